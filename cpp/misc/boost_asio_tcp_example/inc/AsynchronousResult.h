@@ -2,6 +2,7 @@
 
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition.hpp>
+#include <cpplib/concurrency/cancellation_token.h>
 #include "Generic/noncopyable.h"
 
 namespace Server {
@@ -36,6 +37,27 @@ public:
         
         return m_pData;
     }
+
+    // throws cpp::cancelled_exception when the token is cancelled before the data or an error arrived
+    std::shared_ptr<T> Get(const cpp::concurrency::CancellationToken& token)
+    {
+        auto registration = token.on_cancel([this] ()
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_cond.notify_all();
+        });
+
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_cond.wait(lock, [this, &token] () { return m_pData != nullptr || m_error || token.is_cancelled(); });
+
+        if (m_error)
+            throw boost::system::system_error(m_error);
+
+        if (m_pData == nullptr)
+            throw cpp::cancelled_exception();
+
+        return m_pData;
+    }
     
 private:
     boost::mutex m_mutex;
@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include <boost/asio.hpp>
 #include <inc/Dispatcher.h>
+#include <cpplib/concurrency/cancellation_token.h>
 #include "CeosProtocol/CommandMessage.h"
 #include "CeosProtocol/ResultMessage.h"
 #include "CeosProtocol/EventMessage.h"
@@ -39,8 +40,11 @@ public:
            const Logger& logger=NullLogger());
     ~Client();
 
-    std::shared_ptr<ResultMessage> Send(const CommandMessage& message);
-    void StartSend(const CommandMessage& message);
+    // a cancelled Send stops waiting for the result and closes the connection, the unread result
+    // would be taken for the result of the next command. A cancelled StartSend that has not been
+    // sent yet is reported as error result.
+    std::shared_ptr<ResultMessage> Send(const CommandMessage& message, const cpp::concurrency::CancellationToken& token = {});
+    void StartSend(const CommandMessage& message, const cpp::concurrency::CancellationToken& token = {});
     bool IsConnected() const;
     
 private:
@@ -50,9 +54,9 @@ private:
     void ConnectInternal();
     void DisconnectInternal();
 
-    void StartSendInternal(const CommandMessage& message);
+    void StartSendInternal(const CommandMessage& message, const cpp::concurrency::CancellationToken& token);
     void SendCommand(const CommandMessage& message);
-    std::shared_ptr<ResultMessage> ReceiveResult();
+    std::shared_ptr<ResultMessage> ReceiveResult(const cpp::concurrency::CancellationToken& token);
     void EndReceiveResult(const CommandMessage& command, const ResultMessage& result);
     
     void ConnectCommandConnection();
@@ -107,27 +107,28 @@ void Client::Disconnect()
     m_dispatcher.Synchronize();
 }
 
-std::shared_ptr<ResultMessage> Client::Send(const CommandMessage& message)
+std::shared_ptr<ResultMessage> Client::Send(const CommandMessage& message, const cpp::concurrency::CancellationToken& token)
 {
+    token.throw_if_cancelled();
     if (!IsConnected())
         throw std::runtime_error("Not connected");
 
     auto guard = make_guard([this] () { Disconnect(); });
 
     m_dispatcher.Call([this, message] () { SendCommand(message); });
-    auto pResult = ReceiveResult();
+    auto pResult = ReceiveResult(token);
     EndReceiveResult(message, *pResult);
     
     guard.release();
     return pResult;
 }
 
-void Client::StartSend(const CommandMessage& message)
+void Client::StartSend(const CommandMessage& message, const cpp::concurrency::CancellationToken& token)
 {
     if (!IsConnected())
         throw std::runtime_error("Not connected");
 
-    m_dispatcher.Notify([this, message] () { StartSendInternal(message); });
+    m_dispatcher.Notify([this, message, token] () { StartSendInternal(message, token); });
 }
 
 void Client::ConnectInternal()
@@ -164,9 +165,15 @@ void Client::DisconnectInternal()
     m_pEventHandler->HandleConnectedChanged(false);
 }
 
-void Client::StartSendInternal(const CommandMessage& message)
+void Client::StartSendInternal(const CommandMessage& message, const cpp::concurrency::CancellationToken& token)
 try
 {
+    if (token.is_cancelled())
+    {
+        HandleErrorResult(message, L"Cancelled");
+        return;
+    }
+
     auto guard = make_guard([this] () { DisconnectInternal(); });
 
     SendCommand(message);
@@ -195,10 +202,10 @@ void Client::SendCommand(const CommandMessage& message)
     m_pCommandConnection->SendMessagePacket(message);
 }
 
-std::shared_ptr<ResultMessage> Client::ReceiveResult()
+std::shared_ptr<ResultMessage> Client::ReceiveResult(const cpp::concurrency::CancellationToken& token)
 {
     auto pResult = m_dispatcher.Call([this] () { return m_pCommandConnection->StartReceiveResult(); });
-    return pResult->Get();
+    return pResult->Get(token);
 }
 
 void Client::EndReceiveResult(const CommandMessage& commandMessage, const ResultMessage& resultMessage)
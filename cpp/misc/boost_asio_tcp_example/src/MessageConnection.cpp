@@ -1,4 +1,5 @@
 #include <inc/scope_guard.h>
+#include <cpplib/performance/tracer.h>
 #include "CeosProtocol/MessageConnection.h"
 #include "CeosProtocol/RawPacket.h"
 
@@ -100,12 +101,16 @@ std::shared_ptr<AsynchronousResult<EventMessage>> MessageConnection::StartReceiv
 
 void MessageConnection::SendMessagePacket(const Message& message)
 {
-    m_pConnection->Send(ToRawData(message));
+    auto data = ToRawData(message);
+    cpp::performance::trace(cpp::performance::TracePhase::instant, "tcp", "send message", 0, data.ByteSize());
+    m_pConnection->Send(data);
 }
 
 boost::system::error_code MessageConnection::SendMessagePacketNoThrow(const Message& message)
 {
-    return m_pConnection->SendNoThrow(ToRawData(message));
+    auto data = ToRawData(message);
+    cpp::performance::trace(cpp::performance::TracePhase::instant, "tcp", "send message", 0, data.ByteSize());
+    return m_pConnection->SendNoThrow(data);
 }
 
 void MessageConnection::EndReceiveRawPacket(const std::shared_ptr<RawData>& pRawData, const std::function<void(uint32_t)>& handler)
@@ -117,7 +122,9 @@ template <typename T>
 std::shared_ptr<T> MessageConnection::ReceiveMessage()
 {
     auto messageSize = ReceiveRawPacket();
-    return std::make_shared<T>(m_pConnection->Receive(messageSize - sizeof(uint32_t)));
+    auto pMessage = std::make_shared<T>(m_pConnection->Receive(messageSize - sizeof(uint32_t)));
+    cpp::performance::trace(cpp::performance::TracePhase::instant, "tcp", "receive message", 0, messageSize);
+    return pMessage;
 }
 
 template <typename T>
@@ -140,6 +147,7 @@ void MessageConnection::EndReceiveMessageContent(const std::shared_ptr<RawData>&
     auto guard = make_guard([errorHandler] () { errorHandler(boost::system::error_code(boost::system::errc::protocol_error, boost::system::system_category())); });
     auto pMessage = std::make_shared<T>(*pData);
     guard.release();
+    cpp::performance::trace(cpp::performance::TracePhase::instant, "tcp", "receive message", 0, pData->ByteSize() + sizeof(uint32_t));
     handler(pMessage);
 }
 
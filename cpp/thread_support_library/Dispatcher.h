@@ -1,11 +1,17 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <queue>
 #include <cassert>
 #include <mutex>
+#include <string>
 #include <thread>
-#include "inc/dbgstream.h"
+#include <unordered_map>
+#include <cpplib/concurrency/details/timing_wheel.h>
 
 #include "inc/ScheduledCall.h"
 #include "inc/DispatcherItf.h"
@@ -28,6 +34,7 @@ public:
     virtual ~Dispatcher() override;
 
     virtual void Notify(const std::function<void()>& fn) const override;
+    virtual void NotifyCoalesced(std::uint64_t key, const std::function<void()>& fn) const override;
     virtual void Synchronize() const override;
     virtual void Cancel(const ScheduledCall& call) const override;
     virtual std::chrono::steady_clock::duration TimeUntilNextExecution(const ScheduledCall& call) const override;
@@ -67,7 +74,8 @@ private:
     unsigned int GetCallId() const;
     void Insert(CallData&& call) const;
     void Remove(const ScheduledCall& call) const;
-    std::vector<CallData>::iterator Find(const ScheduledCall& call);
+    void QueueDueCalls();
+    void RunCoalesced(std::uint64_t key) const;
     std::function<void()> GetNextFunction();
     void Run(const std::string& threadName);  
 
@@ -75,11 +83,13 @@ private:
     mutable std::mutex m_qMtx;
     mutable std::condition_variable m_cond;
     mutable std::queue<std::function<void()>> m_q;
-    mutable std::vector<CallData> m_scheduledCalls;
+    mutable std::unordered_map<std::uint64_t, std::function<void()>> m_coalesced;
+    mutable cpp::concurrency::details::TimingWheel<CallData> m_scheduledCalls;
+    mutable std::unordered_map<unsigned int, cpp::concurrency::details::TimingWheel<CallData>::handle> m_scheduledCallHandles;
     mutable std::atomic<unsigned int> m_callId;
     bool m_end;
-    std::thread m_thread;
     std::function<void(const std::string&)> m_onUnhandledException;
+    std::thread m_thread;
 };
 
 }
@@ -1,45 +1,10 @@
-#include "stdafx.h"
-
 #include "inc/Dispatcher.h"
-#include "inc/dbgstream.h"
-#include "inc/stringbuilder.h"
-#include "Timing.h"
+
+#include <algorithm>
+#include <cpplib/concurrency/thread_placement.h>
 
 namespace
 {
-#pragma pack(push, 8)
-	struct ThreadnameInfo
-	{
-		DWORD dwType; // Must be 0x1000.
-		LPCSTR szName; // Pointer to name (in user addr space).
-		DWORD dwThreadID; // Thread ID (-1=caller thread).
-		DWORD dwFlags; // Reserved for future use, must be zero.
-	};
-#pragma pack(pop)
-
-	void SetThreadName(DWORD dwThreadID, const char* threadName)
-	{
-		ThreadnameInfo info;
-		info.dwType = 0x1000;
-		info.szName = threadName;
-		info.dwThreadID = dwThreadID;
-		info.dwFlags = 0;
-
-		__try
-		{
-			const DWORD MS_VC_EXCEPTION = 0x406D1388;
-			RaiseException(MS_VC_EXCEPTION, 0, sizeof(info) / sizeof(ULONG_PTR), reinterpret_cast<ULONG_PTR*>(&info));
-		}
-		__except (EXCEPTION_EXECUTE_HANDLER)
-		{
-		}
-	}
-
-	void SetThreadName(const char* threadName)
-	{
-		SetThreadName(GetCurrentThreadId(), threadName);
-	}
-
 	std::string GetThreadName(const std::string& name)
 	{
         if (name.empty())
@@ -47,11 +12,6 @@ namespace
 		else
 			return name;
 	}
-
-	void LogUnhandledException(const std::string& what)
-	{
-		my::cdbg << "Dispatcher::Notify(): exception: " << what << "\n";
-	}
 }
 
 namespace TaskExecution {
@@ -74,10 +34,10 @@ Dispatcher::CallData::CallData(const ScheduledCall& scheduledCall, const std::ch
 }
 
 Dispatcher::Dispatcher(const std::string& threadName, const std::function<void(const std::string&)>& onUnhandledException) :
-	m_end(false),
     m_callId(0),
-	m_thread([this, threadName]() { Run(GetThreadName(threadName)); }),
-	m_onUnhandledException(onUnhandledException)
+	m_end(false),
+	m_onUnhandledException(onUnhandledException),
+	m_thread([this, threadName]() { Run(GetThreadName(threadName)); })
 {
     assert(onUnhandledException);
 }
@@ -98,6 +58,34 @@ void Dispatcher::Notify(const std::function<void()>& fn) const
 	m_cond.notify_one();
 }
 
+// only the first notification of a key is queued, it runs the function posted last for the key
+void Dispatcher::NotifyCoalesced(std::uint64_t key, const std::function<void()>& fn) const
+{
+	std::lock_guard<std::mutex> lock(m_qMtx);
+	auto inserted = m_coalesced.emplace(key, fn);
+	if (!inserted.second)
+	{
+		inserted.first->second = fn;
+		return;
+	}
+	m_q.push([this, key]() { RunCoalesced(key); });
+	m_cond.notify_one();
+}
+
+void Dispatcher::RunCoalesced(std::uint64_t key) const
+{
+	std::function<void()> fn;
+	{
+		std::lock_guard<std::mutex> lock(m_qMtx);
+		auto it = m_coalesced.find(key);
+		if (it == m_coalesced.end())
+			return;
+		fn = std::move(it->second);
+		m_coalesced.erase(it);
+	}
+	fn();
+}
+
 void Dispatcher::Synchronize() const
 {
 	Call([]() {});
@@ -105,15 +93,24 @@ void Dispatcher::Synchronize() const
 
 void Dispatcher::Insert(CallData&& call) const
 {
-	auto it = std::lower_bound(m_scheduledCalls.begin(), m_scheduledCalls.end(), call, [](const CallData& a, const CallData& b) { return a.m_at > b.m_at; });
-	m_scheduledCalls.insert(it, call);
+	auto id = call.m_scheduledCall.GetId();
+	auto at = call.m_at;
+	m_scheduledCallHandles[id] = m_scheduledCalls.insert(at, std::move(call));
 }
 
 void Dispatcher::Remove(const ScheduledCall& call) const
 {
-	auto it = std::find_if(m_scheduledCalls.begin(), m_scheduledCalls.end(), [this, call](const CallData& cd) { return cd.m_scheduledCall == call; });
-	if (it != m_scheduledCalls.end())
-		m_scheduledCalls.erase(it);
+	auto it = m_scheduledCallHandles.find(call.GetId());
+	if (it != m_scheduledCallHandles.end())
+	{
+		m_scheduledCalls.cancel(it->second);
+		m_scheduledCallHandles.erase(it);
+		return;
+	}
+
+	auto due = std::find_if(m_dueCalls.begin(), m_dueCalls.end(), [&call](const CallData& cd) { return cd.m_scheduledCall.GetId() == call.GetId(); });
+	if (due != m_dueCalls.end())
+		m_dueCalls.erase(due);
 }
 
 ScheduledCall Dispatcher::CallAtSystemClock(const std::chrono::steady_clock::time_point& at, const std::function<void()>& fn) const
@@ -158,9 +155,13 @@ std::chrono::steady_clock::duration Dispatcher::TimeUntilNextExecution(const Sch
 {
 	auto fn = [this, call]()
 	{
-		auto it = std::find_if(m_scheduledCalls.begin(), m_scheduledCalls.end(), [this, call](const CallData& cd) { return cd.m_scheduledCall == call; });
-		if (it != m_scheduledCalls.end())
-			return (it->m_at - std::chrono::steady_clock::now());
+		auto it = m_scheduledCallHandles.find(call.GetId());
+		if (it != m_scheduledCallHandles.end())
+			return (m_scheduledCalls.get(it->second).m_at - std::chrono::steady_clock::now());
+
+		auto due = std::find_if(m_dueCalls.begin(), m_dueCalls.end(), [&call](const CallData& cd) { return cd.m_scheduledCall.GetId() == call.GetId(); });
+		if (due != m_dueCalls.end())
+			return (due->m_at - std::chrono::steady_clock::now());
 
 		return std::chrono::steady_clock::duration(-1);
 	};
@@ -176,21 +177,42 @@ bool Dispatcher::IsDispatcherThread() const
 	return std::this_thread::get_id() == m_thread.get_id();
 }
 
+// Moves the calls that are due to the due list, in order of expiry. Called with m_qMtx locked
+void Dispatcher::QueueDueCalls()
+{
+	m_scheduledCalls.advance(std::chrono::steady_clock::now(), [this](CallData&& call)
+	{
+		m_scheduledCallHandles.erase(call.m_scheduledCall.GetId());
+		m_dueCalls.push_back(std::move(call));
+	});
+}
+
+// Takes the next due call, a repeating call is scheduled again before it runs so it can cancel itself
+std::function<void()> Dispatcher::TakeDueCall()
+{
+	CallData call(std::move(m_dueCalls.front()));
+	m_dueCalls.pop_front();
+	if (call.m_repeat)
+		Insert(CallData(call.m_scheduledCall, call.m_at + call.m_interval, call.m_interval, call.m_fn));
+	return std::move(call.m_fn);
+}
+
+// Notifications go first, due calls run one at a time when none are queued. A Cancel posted
+// meanwhile, or done by an earlier call due in the same tick, still stops a due call.
 std::function<void()> Dispatcher::GetNextFunction()
 {
 	std::unique_lock<std::mutex> lock(m_qMtx);
 	while (m_q.empty())
 	{
-		if (!m_scheduledCalls.empty())
+		if (!m_dueCalls.empty())
+		{
+			return TakeDueCall();
+		}
+		else if (!m_scheduledCalls.empty())
 		{
-			if (WaitUntil(m_cond, lock, m_scheduledCalls.back().m_at) == std::cv_status::timeout)
-			{
-				CallData call(std::move(m_scheduledCalls.back()));
-				m_scheduledCalls.pop_back();
-				if (call.m_repeat)
-					Insert(CallData(call.m_scheduledCall, call.m_at + call.m_interval, call.m_interval, call.m_fn));
-				return call.m_fn;
-			}
+			// the wheel can ask for a wake-up to cascade its slots, in which case nothing is due yet
+			if (m_cond.wait_until(lock, m_scheduledCalls.next_expiry()) == std::cv_status::timeout)
+				QueueDueCalls();
 		}
 		else
 		{
@@ -205,7 +227,7 @@ std::function<void()> Dispatcher::GetNextFunction()
 
 void Dispatcher::Run(const std::string& threadName)
 {
-	SetThreadName(threadName.c_str());
+	cpp::concurrency::set_current_thread_name(threadName);
 
 	while (!m_end)
 	{
@@ -232,13 +254,13 @@ unsigned int Dispatcher::GetCallId() const
 
 }
 
+#if defined(_MSC_VER) && (_MSC_VER < 1900)
 namespace
 {
 	//std::thread.join fix copied from https://connect.microsoft.com/VisualStudio/feedback/details/747145/
 #pragma warning(disable:4073) // initializers put in library initialization area
 #pragma init_seg(lib)
 
-#if _MSC_VER < 1900
 	struct VS2013_threading_fix
 	{
 		VS2013_threading_fix()
@@ -246,6 +268,5 @@ namespace
 			_Cnd_do_broadcast_at_thread_exit();
 		}
 	} threading_fix;
+}
 #endif
-
-}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "inc/DispatcherClient.h"
+
+#include <mutex>
+#include "inc/DispatcherItf.h"
+
+namespace TaskExecution {
+
+// Notifications posted through a client hold the bridge. Once the client cancels its notifications,
+// or is destroyed, the bridge is closed and the notifications still queued do nothing.
+class DispatcherClient::DispatcherScopeBridge
+{
+public:
+	void Run(const std::function<void()>& fn)
+	{
+		std::lock_guard<std::recursive_mutex> lock(m_mtx);
+		if (m_open)
+			fn();
+	}
+
+	// waits for a notification that is running on another thread, may be called from the notification itself
+	void Close()
+	{
+		std::lock_guard<std::recursive_mutex> lock(m_mtx);
+		m_open = false;
+	}
+
+private:
+	std::recursive_mutex m_mtx;
+	bool m_open = true;
+};
+
+DispatcherClient::DispatcherClient(DispatcherItf& dispatcher) :
+	m_pDispatcher(&dispatcher),
+	m_pScopeBridge(std::make_shared<DispatcherScopeBridge>())
+{
+}
+
+DispatcherClient::DispatcherClient(DispatcherClient&& dispatcherClient) :
+	m_pDispatcher(dispatcherClient.m_pDispatcher),
+	m_pScopeBridge(std::move(dispatcherClient.m_pScopeBridge))
+{
+}
+
+DispatcherClient& DispatcherClient::operator=(DispatcherClient&& other)
+{
+	if (this != &other)
+	{
+		if (m_pScopeBridge)
+			m_pScopeBridge->Close();
+		m_pDispatcher = other.m_pDispatcher;
+		m_pScopeBridge = std::move(other.m_pScopeBridge);
+	}
+	return *this;
+}
+
+DispatcherClient::~DispatcherClient()
+{
+	if (m_pScopeBridge)
+		m_pScopeBridge->Close();
+}
+
+void DispatcherClient::Notify(const std::function<void()>& fn) const
+{
+	auto pScopeBridge = m_pScopeBridge;
+	m_pDispatcher->Notify([pScopeBridge, fn]() { pScopeBridge->Run(fn); });
+}
+
+// the notifications queued so far are dropped, later ones run again
+void DispatcherClient::CancelNotifications()
+{
+	m_pScopeBridge->Close();
+	m_pScopeBridge = std::make_shared<DispatcherScopeBridge>();
+}
+
+bool DispatcherClient::IsDispatcherThread() const
+{
+	return m_pDispatcher->IsDispatcherThread();
+}
+
+void DispatcherClient::Synchronize() const
+{
+	m_pDispatcher->Synchronize();
+}
+
+DispatcherItf& DispatcherClient::GetDispatcher() const
+{
+	return *m_pDispatcher;
+}
+
+}
@@ -0,0 +1,287 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <cpplib/exceptions/cancelled_exception.h>
+#include <cpplib/preprocessor/nodiscard.h>
+#include <cpplib/types/non_copyable.h>
+
+// Cooperative cancellation.
+//
+//   CancellationSource source;
+//   auto token = source.token();
+//   ...
+//   while (!token.is_cancelled()) { ... }      // one atomic load, no lock
+//   source.cancel();
+//
+// A token is a cheap copyable view on the state of its source. Callbacks registered with on_cancel
+// run once, on the thread that cancels; a source made from a parent token is cancelled together
+// with the parent, cancelling the child leaves the parent alone.
+// The mutex of the state is only taken to register callbacks and to cancel, never to check.
+
+namespace cpp
+{
+namespace concurrency
+{
+namespace details
+{
+
+class CancellationState final :
+    public NonCopyable
+{
+public:
+    using callback_id = std::uint64_t;
+
+    NO_DISCARD bool is_cancelled() const noexcept
+    {
+        return m_cancelled.load(std::memory_order_acquire);
+    }
+
+    // runs the callbacks in the order they were added, the callbacks must not throw
+    void cancel() noexcept
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_cancelled.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        m_cancelled.store(true, std::memory_order_release);
+
+        m_running_thread = std::this_thread::get_id();
+        while (!m_callbacks.empty())
+        {
+            auto callback = std::move(m_callbacks.front());
+            m_callbacks.pop_front();
+            m_running_id = callback.first;
+            lock.unlock();
+            callback.second();
+            callback.second = nullptr;
+            lock.lock();
+            m_running_id = 0;
+            m_callback_done.notify_all();
+        }
+        m_running_thread = std::thread::id();
+    }
+
+    // 0 when already cancelled, then the callback has run on the calling thread
+    callback_id add(std::function<void()> callback)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!m_cancelled.load(std::memory_order_relaxed))
+            {
+                auto id = m_next_id++;
+                m_callbacks.emplace_back(id, std::move(callback));
+                return id;
+            }
+        }
+        callback();
+        return 0;
+    }
+
+    // when the callback is running on another thread, waits until it has returned
+    void remove(callback_id id) noexcept
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (auto it = m_callbacks.begin(); it != m_callbacks.end(); ++it)
+        {
+            if (it->first == id)
+            {
+                m_callbacks.erase(it);
+                return;
+            }
+        }
+        if (m_running_thread != std::this_thread::get_id())
+        {
+            m_callback_done.wait(lock, [this, id] { return m_running_id != id; });
+        }
+    }
+
+private:
+    std::atomic<bool> m_cancelled{ false };
+
+    std::mutex m_mutex;
+    std::condition_variable m_callback_done;
+    std::list<std::pair<callback_id, std::function<void()>>> m_callbacks;
+    callback_id m_next_id = 1;
+    callback_id m_running_id = 0;
+    std::thread::id m_running_thread;
+};
+
+} // details
+
+//-----------------------------------------------------------------------------------------------------------------------------------------
+
+// removes the callback when destroyed, so the callback never runs after that
+class CancellationRegistration final :
+    public NonCopyable
+{
+public:
+    CancellationRegistration() noexcept = default;
+
+    CancellationRegistration(std::shared_ptr<details::CancellationState> state, details::CancellationState::callback_id id) noexcept :
+        m_state{ std::move(state) },
+        m_id{ id }
+    {
+    }
+
+    CancellationRegistration(CancellationRegistration&& other) noexcept :
+        m_state{ std::move(other.m_state) },
+        m_id{ other.m_id }
+    {
+        other.m_id = 0;
+    }
+
+    CancellationRegistration& operator=(CancellationRegistration&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_state = std::move(other.m_state);
+            m_id = other.m_id;
+            other.m_id = 0;
+        }
+        return *this;
+    }
+
+    ~CancellationRegistration()
+    {
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        if (m_state && (m_id != 0))
+        {
+            m_state->remove(m_id);
+        }
+        m_state = nullptr;
+        m_id = 0;
+    }
+
+private:
+    std::shared_ptr<details::CancellationState> m_state;
+    details::CancellationState::callback_id m_id = 0;
+};
+
+//-----------------------------------------------------------------------------------------------------------------------------------------
+
+class CancellationToken
+{
+public:
+    // a default token is never cancelled
+    CancellationToken() noexcept = default;
+
+    explicit CancellationToken(std::shared_ptr<details::CancellationState> state) noexcept :
+        m_state{ std::move(state) }
+    {
+    }
+
+    NO_DISCARD bool is_cancelled() const noexcept
+    {
+        return m_state && m_state->is_cancelled();
+    }
+
+    NO_DISCARD bool can_be_cancelled() const noexcept
+    {
+        return m_state != nullptr;
+    }
+
+    void throw_if_cancelled() const
+    {
+        if (is_cancelled())
+        {
+            throw cancelled_exception();
+        }
+    }
+
+    // the callback runs on the cancelling thread, or right away when already cancelled.
+    // It must not throw and must not remove its own registration from another thread.
+    NO_DISCARD CancellationRegistration on_cancel(std::function<void()> callback) const
+    {
+        if (!m_state)
+        {
+            return {};
+        }
+        auto id = m_state->add(std::move(callback));
+        return { m_state, id };
+    }
+
+    // sleeps until cancelled or the duration has passed, true when cancelled
+    bool try_wait_for(const std::chrono::steady_clock::duration& duration) const
+    {
+        if (is_cancelled() || !m_state)
+        {
+            return is_cancelled();
+        }
+
+        std::mutex mutex;
+        std::condition_variable cancelled;
+        auto registration = on_cancel([&mutex, &cancelled]
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            cancelled.notify_all();
+        });
+
+        std::unique_lock<std::mutex> lock(mutex);
+        return cancelled.wait_for(lock, duration, [this] { return is_cancelled(); });
+    }
+
+private:
+    std::shared_ptr<details::CancellationState> m_state;
+};
+
+//-----------------------------------------------------------------------------------------------------------------------------------------
+
+class CancellationSource final :
+    public NonCopyable
+{
+public:
+    CancellationSource() :
+        m_state{ std::make_shared<details::CancellationState>() }
+    {
+    }
+
+    // cancelled as well when the parent is cancelled
+    explicit CancellationSource(const CancellationToken& parent) :
+        CancellationSource()
+    {
+        m_parent_registration = parent.on_cancel([state = m_state]() noexcept
+        {
+            state->cancel();
+        });
+    }
+
+    void cancel() noexcept
+    {
+        m_state->cancel();
+    }
+
+    NO_DISCARD bool is_cancelled() const noexcept
+    {
+        return m_state->is_cancelled();
+    }
+
+    NO_DISCARD CancellationToken token() const noexcept
+    {
+        return CancellationToken(m_state);
+    }
+
+private:
+    std::shared_ptr<details::CancellationState> m_state;
+    CancellationRegistration m_parent_registration;
+};
+
+} // concurrency
+} // cpp
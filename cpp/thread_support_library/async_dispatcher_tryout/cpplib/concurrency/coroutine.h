@@ -0,0 +1,343 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <cpplib/preprocessor/coroutines.h>
+
+#if CPPLIB_HAS_COROUTINES
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+// C++20 coroutine support for the dispatchers:
+//
+//   cpp::concurrency::task<int> read_value(cpp::concurrency::Dispatcher& dispatcher)
+//   {
+//       co_await dispatcher.schedule();                              // continues on the dispatcher thread
+//       co_await dispatcher.after(std::chrono::milliseconds(10));    // and again 10 ms later
+//       co_return 42;
+//   }
+//
+// A task<T> is lazy, it starts when it is co_awaited and resumes its awaiter on the thread it completed on.
+// start_detached() starts a top-level task without waiting for it.
+
+namespace cpp
+{
+namespace concurrency
+{
+
+template<typename T = void>
+class task;
+
+namespace details
+{
+
+// continues the awaiting coroutine on the dispatcher thread, queued like a notification
+template<typename IMPL>
+class ScheduleAwaiter
+{
+public:
+    explicit ScheduleAwaiter(IMPL& impl) noexcept :
+        m_impl{ impl }
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        m_impl.notify([handle]() noexcept { handle.resume(); });
+    }
+
+    void await_resume() const noexcept
+    {
+    }
+
+private:
+    IMPL& m_impl;
+};
+
+// continues the awaiting coroutine on the dispatcher thread at the given time
+template<typename IMPL>
+class ResumeAtAwaiter
+{
+public:
+    ResumeAtAwaiter(IMPL& impl, const std::chrono::steady_clock::time_point& time) noexcept :
+        m_impl{ impl },
+        m_time{ time }
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        m_impl.notify_at(m_time, [handle]() noexcept { handle.resume(); });
+    }
+
+    void await_resume() const noexcept
+    {
+    }
+
+private:
+    IMPL& m_impl;
+    const std::chrono::steady_clock::time_point m_time;
+};
+
+class TaskPromiseBase
+{
+public:
+    // resumes the awaiting coroutine directly (symmetric transfer), no queueing and no stack growth
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        template<typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept
+        {
+            auto continuation = handle.promise().continuation();
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    std::suspend_always initial_suspend() const noexcept
+    {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() const noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception() noexcept
+    {
+        m_exception = std::current_exception();
+    }
+
+    void set_continuation(std::coroutine_handle<> continuation) noexcept
+    {
+        m_continuation = continuation;
+    }
+
+    std::coroutine_handle<> continuation() const noexcept
+    {
+        return m_continuation;
+    }
+
+protected:
+    void rethrow_if_failed() const
+    {
+        if (m_exception)
+        {
+            std::rethrow_exception(m_exception);
+        }
+    }
+
+private:
+    std::coroutine_handle<> m_continuation;
+    std::exception_ptr m_exception;
+};
+
+template<typename T>
+class TaskPromise final :
+    public TaskPromiseBase
+{
+public:
+    task<T> get_return_object() noexcept;
+
+    template<typename U>
+    void return_value(U&& value)
+    {
+        m_value.emplace(std::forward<U>(value));
+    }
+
+    T result()
+    {
+        rethrow_if_failed();
+        return std::move(*m_value);
+    }
+
+private:
+    std::optional<T> m_value;
+};
+
+template<>
+class TaskPromise<void> final :
+    public TaskPromiseBase
+{
+public:
+    task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept
+    {
+    }
+
+    void result() const
+    {
+        rethrow_if_failed();
+    }
+};
+
+} // details
+
+//--------------------------------------------------------------------------------------------------------------------
+
+// lazily started coroutine returning a T, owns the coroutine frame
+template<typename T>
+class task final
+{
+public:
+    using promise_type = details::TaskPromise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    explicit task(handle_type handle) noexcept :
+        m_handle{ handle }
+    {
+    }
+
+    task(task&& other) noexcept :
+        m_handle{ std::exchange(other.m_handle, {}) }
+    {
+    }
+
+    task& operator=(task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+
+    ~task()
+    {
+        destroy();
+    }
+
+    // starts the task, the awaiting coroutine continues when the task has completed
+    auto operator co_await() const noexcept
+    {
+        struct Awaiter
+        {
+            bool await_ready() const noexcept
+            {
+                return !handle || handle.done();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle.promise().set_continuation(awaiting);
+                return handle;
+            }
+
+            T await_resume()
+            {
+                return handle.promise().result();
+            }
+
+            handle_type handle;
+        };
+
+        return Awaiter{ m_handle };
+    }
+
+private:
+    void destroy() noexcept
+    {
+        if (m_handle)
+        {
+            m_handle.destroy();
+            m_handle = {};
+        }
+    }
+
+    handle_type m_handle;
+};
+
+namespace details
+{
+
+template<typename T>
+task<T> TaskPromise<T>::get_return_object() noexcept
+{
+    return task<T>{ std::coroutine_handle<TaskPromise<T>>::from_promise(*this) };
+}
+
+inline task<void> TaskPromise<void>::get_return_object() noexcept
+{
+    return task<void>{ std::coroutine_handle<TaskPromise<void>>::from_promise(*this) };
+}
+
+// eagerly started coroutine that destroys itself when done
+struct DetachedTask
+{
+    struct promise_type
+    {
+        DetachedTask get_return_object() const noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() const noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() const noexcept
+        {
+            return {};
+        }
+
+        void return_void() const noexcept
+        {
+        }
+
+        // like a notification, nobody is there to receive the exception
+        void unhandled_exception() const noexcept
+        {
+        }
+    };
+};
+
+template<typename T>
+DetachedTask run_detached(task<T> detached)
+{
+    co_await detached;
+}
+
+} // details
+
+// starts the task on the calling thread, it runs to completion on whatever threads it hops to.
+// exceptions leaving the task are swallowed.
+template<typename T>
+void start_detached(task<T> detached)
+{
+    details::run_detached(std::move(detached));
+}
+
+} // concurrency
+} // cpp
+
+#endif
@@ -0,0 +1,20 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <cstddef>
+
+namespace cpp
+{
+namespace concurrency
+{
+namespace details
+{
+
+// used to keep data written by different threads on separate cache lines (avoids false sharing)
+static constexpr std::size_t cache_line_size = 64;
+
+} // details
+} // concurrency
+} // cpp
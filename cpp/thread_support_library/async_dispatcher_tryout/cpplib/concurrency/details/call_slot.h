@@ -0,0 +1,193 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "futex.h"
+
+namespace cpp
+{
+namespace concurrency
+{
+namespace details
+{
+
+// Rendezvous of a synchronous call: the calling thread waits on its slot until the dispatcher has
+// run the callable. One slot per thread, a thread waits for one call at a time. Completing takes no
+// lock and the futex is only woken when the caller sleeps; the slot is touched only by the wake-up
+// after the caller can see the call completed, the futex calls accept an address that went away.
+class CallSlot
+{
+public:
+    static CallSlot& of_this_thread() noexcept
+    {
+        thread_local CallSlot slot;
+        return slot;
+    }
+
+    // dispatcher side, error is set before
+    void complete() noexcept
+    {
+        if (m_state.exchange(done, std::memory_order_acq_rel) == waiting)
+        {
+            futex_wake_one(m_state);
+        }
+    }
+
+    // caller side, the slot is ready for the next call afterwards
+    void wait() noexcept
+    {
+        auto state = idle;
+        if (m_state.compare_exchange_strong(state, waiting, std::memory_order_acquire))
+        {
+            while (m_state.load(std::memory_order_acquire) != done)
+            {
+                futex_wait(m_state, waiting, std::chrono::hours(24));
+            }
+        }
+        m_state.store(idle, std::memory_order_relaxed);
+    }
+
+    // the call was not queued, nobody else has seen the slot
+    void reset() noexcept
+    {
+        m_state.store(idle, std::memory_order_relaxed);
+        error = nullptr;
+    }
+
+    void rethrow_error()
+    {
+        if (error)
+        {
+            std::rethrow_exception(std::exchange(error, nullptr));
+        }
+    }
+
+    // only set when the callable threw
+    std::exception_ptr error;
+
+private:
+    static constexpr std::uint32_t idle = 0;
+    static constexpr std::uint32_t waiting = 1;
+    static constexpr std::uint32_t done = 2;
+
+    std::atomic<std::uint32_t> m_state{ idle };
+};
+
+// the result lives on the stack of the calling thread
+template<typename R>
+class CallResult
+{
+public:
+    template<typename L>
+    void set(L& fn)
+    {
+        m_value.emplace(fn());
+    }
+
+    R take()
+    {
+        return std::move(*m_value);
+    }
+
+private:
+    std::optional<R> m_value;
+};
+
+template<typename R>
+class CallResult<R&>
+{
+public:
+    template<typename L>
+    void set(L& fn)
+    {
+        m_value = &fn();
+    }
+
+    R& take() noexcept
+    {
+        return *m_value;
+    }
+
+private:
+    R* m_value = nullptr;
+};
+
+template<>
+class CallResult<void>
+{
+public:
+    template<typename L>
+    void set(L& fn)
+    {
+        fn();
+    }
+
+    void take() noexcept
+    {
+    }
+};
+
+// Queued for a synchronous call: three references, so it is stored inline in a TaskNode.
+// Completes the slot with a broken promise when it is destroyed without having run.
+template<typename L, typename R>
+class CallTask
+{
+public:
+    CallTask(L& fn, CallResult<R>& result, CallSlot& slot) noexcept :
+        m_fn{ &fn },
+        m_result{ &result },
+        m_slot{ &slot }
+    {
+    }
+
+    CallTask(CallTask&& other) noexcept :
+        m_fn{ other.m_fn },
+        m_result{ other.m_result },
+        m_slot{ std::exchange(other.m_slot, nullptr) }
+    {
+    }
+
+    CallTask(const CallTask&) = delete;
+    CallTask& operator=(const CallTask&) = delete;
+    CallTask& operator=(CallTask&&) = delete;
+
+    ~CallTask()
+    {
+        if (m_slot != nullptr)
+        {
+            m_slot->error = std::make_exception_ptr(std::future_error(std::future_errc::broken_promise));
+            m_slot->complete();
+        }
+    }
+
+    void operator()() noexcept
+    {
+        try
+        {
+            m_result->set(*m_fn);
+        }
+        catch (...)
+        {
+            m_slot->error = std::current_exception();
+        }
+        std::exchange(m_slot, nullptr)->complete();
+    }
+
+private:
+    L* m_fn;
+    CallResult<R>* m_result;
+    CallSlot* m_slot;
+};
+
+} // details
+} // concurrency
+} // cpp
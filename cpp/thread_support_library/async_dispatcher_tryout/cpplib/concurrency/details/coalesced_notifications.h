@@ -0,0 +1,69 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace cpp
+{
+namespace concurrency
+{
+
+// notifications posted with the same coalescing key while one is pending run once, the latest wins
+using coalescing_key = std::uint64_t;
+
+namespace details
+{
+
+// The pending notification per key. Only the first post of a key queues a task, later posts replace
+// the callable it will run, so the queue holds at most one task per key.
+class CoalescedNotifications
+{
+public:
+    // true when the key was not pending: the caller queues a task that calls run(key)
+    // and discard(key) when queueing fails
+    template<typename L>
+    bool post(coalescing_key key, L&& fn)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto inserted = m_pending.emplace(key, std::function<void()>{});
+        inserted.first->second = std::forward<L>(fn);
+        return inserted.second;
+    }
+
+    // a post of the key from now on queues a new task, also while fn runs
+    void run(coalescing_key key) noexcept
+    {
+        std::function<void()> fn;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto pending = m_pending.find(key);
+            if (pending == m_pending.end())
+            {
+                return;
+            }
+            fn = std::move(pending->second);
+            m_pending.erase(pending);
+        }
+        fn();
+    }
+
+    void discard(coalescing_key key) noexcept
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.erase(key);
+    }
+
+private:
+    std::mutex m_mutex;
+    std::unordered_map<coalescing_key, std::function<void()>> m_pending;
+};
+
+} // details
+} // concurrency
+} // cpp
@@ -3,15 +3,30 @@
 
 #pragma once
 
-#include <list>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <iterator>
 #include <memory>
-#include <queue>
+#include <mutex>
+#include <vector>
+#include <cpplib/concurrency/dispatcher_priority.h>
 #include <cpplib/concurrency/state_variable.h>
 #include <cpplib/concurrency/signal.h>
+#include <cpplib/concurrency/thread_placement.h>
+#include <cpplib/exceptions/queue_full_exception.h>
+#include <cpplib/performance/task_profiler.h>
+#include <cpplib/performance/tracer.h>
 #include <cpplib/types/interface.h>
-#include <cpplib/types/uuid.h>
 #include <cpplib/types/unreferenced_variables.h>
+#include "call_slot.h"
+#include "coalesced_notifications.h"
 #include "dispatcher_task.h"
+#include "idle_backoff.h"
+#include "mpsc_queue.h"
+#include "task_node.h"
+#include "timing_wheel.h"
 
 namespace cpp
 {
@@ -39,23 +54,47 @@ template<typename CTX>
 class DispatcherImpl
 {
 public:
-    DispatcherImpl(const std::chrono::steady_clock::duration& required_response_time, std::shared_ptr<performance::DispatcherPerformanceItf> performance_itf) :
+    DispatcherImpl(const std::chrono::steady_clock::duration& required_response_time, std::shared_ptr<performance::DispatcherPerformanceItf> performance_itf, QueueBound bound = {}, ThreadPlacement placement = {}) :
+        m_bound{ bound },
+        m_bounded{ bound.capacity != QueueBound::unbounded },
+        m_shared_consumer{ m_bounded && ((bound.policy == QueueFullPolicy::drop_oldest) || (bound.policy == QueueFullPolicy::coalesce)) },
         m_internal_state{ DispatcherState::starting },
         m_required_response_time{ required_response_time },
+        m_check_deadlines{ (required_response_time > std::chrono::steady_clock::duration::zero()) && (required_response_time != std::chrono::steady_clock::duration::max()) },
         m_performance_itf{ std::move(performance_itf) }
     {
-        m_dispatch_future = std::async(std::launch::async, [this]()
+        m_dispatch_future = std::async(std::launch::async, [this, placement]()
         {
-            main_loop();
+            main_loop(placement);
         });
 
-        m_internal_state.wait_for(DispatcherState::running);
+        m_internal_state.wait_for_any({ DispatcherState::running, DispatcherState::stopped });
+
+        // the thread failed to start (e.g. it could not be pinned or its thread context threw), rethrow its exception
+        if (m_internal_state == DispatcherState::stopped)
+        {
+            m_dispatch_future.get();
+        }
+    }
+
+    DispatcherImpl(const std::chrono::steady_clock::duration& required_response_time, std::shared_ptr<performance::DispatcherPerformanceItf> performance_itf, ThreadPlacement placement) :
+        DispatcherImpl(required_response_time, std::move(performance_itf), QueueBound{}, std::move(placement))
+    {
     }
 
     ~DispatcherImpl()
     {
         stop();
         m_dispatch_future.get();
+
+        // tasks posted after the dispatcher stopped are dropped
+        for (auto& queue : m_ready_queues)
+        {
+            while (auto node = queue.try_pop())
+            {
+                TaskNodePool::instance().release(node);
+            }
+        }
     }
 
     void stop()
@@ -66,16 +105,46 @@ public:
         m_internal_state.wait_for(DispatcherState::stopped);
     }
 
+    // also called by the destructor, so it gets past a full bounded queue
     void synchronize()
     {
-        invoke([] {});
+        if (is_dispatcher_thread())
+        {
+            return;
+        }
+        auto task_ptr = std::make_shared<InternalDispatcherTask<void>>(std::chrono::steady_clock::now(), [] {}, nullptr);
+        auto future = task_ptr->get_future();
+        queue_task(task_ptr, DispatcherPriority::normal, true);
+        future.get();
     }
 
+    // waits on the slot of the calling thread instead of a future: no packaged task, no shared state,
+    // the callable is stored inline in the pooled node. Pinned, so a full bounded queue never drops it.
     template<typename L>
     auto call(L&& fn) -> decltype(fn())
     {
-        auto future = async(fn);
-        return future.get();
+        using result_type = decltype(fn());
+
+        auto& slot = CallSlot::of_this_thread();
+        CallResult<result_type> result;
+        try
+        {
+            NodeChain chain;
+            auto node = chain.append();
+            node->emplace(CallTask<std::remove_reference_t<L>, result_type>(fn, result, slot));
+            node->queued_at = std::chrono::steady_clock::now();
+            node->pinned = true;
+            queue_chain(chain);
+        }
+        catch (...)
+        {
+            // e.g. a full bounded queue, the chain has destroyed the task
+            slot.reset();
+            throw;
+        }
+        slot.wait();
+        slot.rethrow_error();
+        return result.take();
     }
 
     template<typename L>
@@ -92,25 +161,132 @@ public:
     }
 
     template<typename L>
-    auto async(L&& fn) -> std::future<decltype(fn())>
+    auto async(L&& fn, const char* tag = nullptr) -> std::future<decltype(fn())>
+    {
+        return async(DispatcherPriority::normal, std::forward<L>(fn), tag);
+    }
+
+    template<typename L>
+    auto async(DispatcherPriority priority, L&& fn, const char* tag = nullptr) -> std::future<decltype(fn())>
     {
-        auto task_ptr = std::make_shared<InternalDispatcherTask<decltype(fn())>>(std::chrono::steady_clock::now(), fn);
-        queue_task(task_ptr);
+        auto task_ptr = std::make_shared<InternalDispatcherTask<decltype(fn())>>(std::chrono::steady_clock::now(), fn, tag);
+        queue_task(task_ptr, priority);
         return task_ptr->get_future();
     }
 
     template<typename L>
-    const void notify(L&& fn)
+    const void notify(L&& fn, const char* tag = nullptr)
+    {
+        notify(DispatcherPriority::normal, std::forward<L>(fn), tag);
+    }
+
+    // nobody waits for the result, so the callable is stored in a pooled node
+    // instead of a packaged task: no heap allocation for lambdas up to TaskNode::inline_size
+    template<typename L>
+    const void notify(DispatcherPriority priority, L&& fn, const char* tag = nullptr)
+    {
+        // a chain of one, the node goes back to the pool when a bounded queue rejects it
+        NodeChain chain;
+        auto node = chain.append();
+        node->emplace(std::forward<L>(fn), tag);
+        node->queued_at = std::chrono::steady_clock::now();
+        queue_chain(chain, priority);
+    }
+
+    // with QueueFullPolicy::coalesce a full queue replaces a queued notification posted with the same key
+    template<typename L>
+    void notify_replacing(coalescing_key key, L&& fn, const char* tag = nullptr)
+    {
+        NodeChain chain;
+        auto node = chain.append();
+        node->emplace(std::forward<L>(fn), tag);
+        node->queued_at = std::chrono::steady_clock::now();
+        node->replace_key = key;
+        queue_chain(chain);
+    }
+
+    // the whole range is linked into one chain that is published with a single push,
+    // so the dispatcher is woken at most once for the batch
+    template<typename Range>
+    void notify_bulk(Range&& fns)
+    {
+        auto now = std::chrono::steady_clock::now();
+        NodeChain chain;
+        for (auto&& fn : fns)
+        {
+            auto node = chain.append();
+            node->emplace(fn);
+            node->queued_at = now;
+        }
+        queue_chain(chain);
+    }
+
+    template<typename Range>
+    auto async_bulk(Range&& fns) -> std::vector<std::future<decltype((*std::begin(fns))())>>
+    {
+        using result_type = decltype((*std::begin(fns))());
+
+        auto now = std::chrono::steady_clock::now();
+        std::vector<std::future<result_type>> futures;
+        NodeChain chain;
+        for (auto&& fn : fns)
+        {
+            auto task_ptr = std::make_shared<InternalDispatcherTask<result_type>>(now, fn);
+            futures.push_back(task_ptr->get_future());
+            auto node = chain.append();
+            node->task = std::move(task_ptr);
+            node->queued_at = now;
+        }
+        queue_chain(chain);
+        return futures;
+    }
+
+    // a single dispatcher thread runs every task in order, so all keys share one strand
+    template<typename K, typename L>
+    auto async_in_strand(const K&, L&& fn) -> std::future<decltype(fn())>
+    {
+        return async(fn);
+    }
+
+    template<typename K, typename L>
+    void notify_in_strand(const K&, L&& fn)
+    {
+        notify(fn);
+    }
+
+    // only the first notification of a key is queued, it runs the latest fn posted for the key.
+    // One task per key at most, so it is exempt from the bound like a timer.
+    template<typename L>
+    void notify_coalesced(coalescing_key key, L&& fn, const char* tag = nullptr)
     {
-        auto task_ptr = std::make_shared<InternalDispatcherTask<decltype(fn())>>(std::chrono::steady_clock::now(), fn);
-        queue_task(task_ptr);
+        if (!m_coalesced.post(key, std::forward<L>(fn)))
+        {
+            return;
+        }
+        try
+        {
+            NodeChain chain;
+            auto node = chain.append();
+            node->emplace([this, key]() noexcept
+            {
+                m_coalesced.run(key);
+            }, tag);
+            node->queued_at = std::chrono::steady_clock::now();
+            node->pinned = true;
+            queue_chain(chain, DispatcherPriority::normal, true);
+        }
+        catch (...)
+        {
+            m_coalesced.discard(key);
+            throw;
+        }
     }
 
     template<typename L>
-    std::unique_ptr<DispatcherTaskItf> schedule_task(const std::chrono::steady_clock::duration& interval, L&& fn) noexcept
+    std::unique_ptr<DispatcherTaskItf> schedule_task(const std::chrono::steady_clock::duration& interval, L&& fn, const char* tag = nullptr) noexcept
     {
-        auto task_ptr = std::make_shared<InternalDispatcherTask<decltype(fn())>>(interval, fn);
-        queue_task(task_ptr);
+        auto task_ptr = std::make_shared<InternalDispatcherTask<decltype(fn())>>(interval, fn, tag);
+        queue_task(task_ptr, DispatcherPriority::normal, true);
         // return a wrapper to client which will cancel task if client releases task
         return std::make_unique<DispatcherTask>(task_ptr);
     }
@@ -119,65 +295,603 @@ public:
     std::unique_ptr<DispatcherTaskItf> schedule_task(const std::chrono::steady_clock::time_point& time, L&& fn) noexcept
     {
         auto task_ptr = std::make_shared<InternalDispatcherTask<decltype(fn())>>(time, fn);
-        queue_task(task_ptr);
+        queue_task(task_ptr, DispatcherPriority::normal, true);
 
         // return a wrapper to client which will cancel task if client releases task
         return std::make_unique<DispatcherTask>(task_ptr);
     }
 
+    // one-shot timer without a cancellation handle, used to resume coroutines.
+    // Like notify the callable is stored in a pooled node, the node itself waits in the timer queue.
+    template<typename L>
+    void notify_at(const std::chrono::steady_clock::time_point& time, L&& fn)
+    {
+        NodeChain chain;
+        auto node = chain.append();
+        node->emplace(std::forward<L>(fn));
+        node->not_before = time;
+        node->queued_at = time;
+        queue_chain(chain, DispatcherPriority::normal, true);
+    }
+
     bool is_dispatcher_thread() const
     {
         return (m_dispatcher_thread_id == std::this_thread::get_id());
     }
 
+    void set_background_work_policy(BackgroundWorkPolicy policy) noexcept
+    {
+        m_background_work_policy = policy;
+    }
+
+    // takes effect the next time the dispatcher runs out of work
+    void set_idle_strategy(IdleStrategy strategy) noexcept
+    {
+        m_idle_strategy = strategy;
+    }
+
+    std::size_t number_of_deadline_violations() const noexcept
+    {
+        return m_deadline_violations;
+    }
+
+    std::size_t number_of_shed_tasks() const noexcept
+    {
+        return m_shed_tasks;
+    }
+
+    // takes effect with the next round of the dispatcher loop, collected totals are kept when switched off
+    void enable_task_profiling(bool enable) noexcept
+    {
+        m_task_profiling_requested = enable;
+    }
+
+    // the profiler belongs to the dispatcher thread, so it is read and reset there
+    std::vector<performance::TaskProfile> task_profile(std::size_t top_n)
+    {
+        return invoke([this, top_n]
+        {
+            return m_task_profiler.top(top_n);
+        });
+    }
+
+    void reset_task_profile()
+    {
+        invoke([this]
+        {
+            m_task_profiler.reset();
+        });
+    }
+
 private:
-    void queue_task(const std::shared_ptr<InternalDispatcherTaskItf>& task_ptr)
+    using task_ptr_type = std::shared_ptr<InternalDispatcherTaskItf>;
+
+    // nodes of a bulk submission, linked in posting order.
+    // released again when the batch is not queued, e.g. because building it threw.
+    struct NodeChain final :
+        public NonCopyable
     {
+        ~NodeChain()
+        {
+            while (first != nullptr)
+            {
+                auto node = first;
+                first = node->next.load(std::memory_order_relaxed);
+                TaskNodePool::instance().release(node);
+            }
+        }
 
-        std::unique_lock<std::mutex> lock(m_queue_mutex);
-        m_queue.push(task_ptr);
-        m_wakeup.signal();
-        
-        m_performance_itf->increment_number_of_calls_queued();
-        m_performance_itf->report_queue_size(static_cast<unsigned long>(m_queue.size()));
+        TaskNode* append()
+        {
+            auto node = TaskNodePool::instance().allocate();
+            node->next.store(nullptr, std::memory_order_relaxed);
+            node->pinned = false;
+            if (last != nullptr)
+            {
+                last->next.store(node, std::memory_order_relaxed);
+            }
+            else
+            {
+                first = node;
+            }
+            last = node;
+            ++count;
+            return node;
+        }
+
+        TaskNode* first = nullptr;
+        TaskNode* last = nullptr;
+        std::size_t count = 0;
+    };
+
+    // can be called from any thread, immediate and scheduled tasks both go through
+    // the lock-free ready queue. The dispatcher thread moves tasks that are not due yet
+    // into its private timer queue.
+    // exempt tasks, timers and synchronize, are never refused by a bounded queue
+    void queue_task(const task_ptr_type& task_ptr, DispatcherPriority priority = DispatcherPriority::normal, bool exempt = false)
+    {
+        NodeChain chain;
+        auto node = chain.append();
+        node->task = task_ptr;
+        node->queued_at = task_ptr->run_at();
+        node->pinned = exempt;
+        queue_chain(chain, priority, exempt);
     }
 
-    bool suspend()
+    // the nodes stay with the chain when the queue refuses them, so they are released again
+    void queue_chain(NodeChain& chain, DispatcherPriority priority = DispatcherPriority::normal, bool exempt = false)
     {
-        // if no task scheduled wait for a long time before waking up
-        auto wait_duration = std::chrono::steady_clock::duration::min();
+        if (chain.count == 0)
+        {
+            return;
+        }
+        queue_nodes(chain.first, chain.last, chain.count, priority, exempt);
+        chain.first = nullptr;
+        chain.last = nullptr;
+        chain.count = 0;
+    }
+
+    void queue_nodes(TaskNode* first, TaskNode* last, std::size_t count, DispatcherPriority priority, bool exempt)
+    {
+        // the dispatcher thread never waits for itself
+        auto bounded = m_bounded && !exempt && !is_dispatcher_thread();
+        if (bounded)
+        {
+            reserve_room(*first, count, priority);
+        }
 
+        // before the push, afterwards the dispatcher may already have run and recycled the nodes
+        if (performance::tracing_enabled())
         {
-            std::unique_lock<std::mutex> lock(m_queue_mutex);
+            trace_enqueue(first, last);
+        }
+
+        ready_queue(priority).push(first, last);
+        auto queue_size = bounded ? m_ready_queue_size.load(std::memory_order_relaxed) : (m_ready_queue_size += count);
 
-            if (m_queue.size() > 0)
+        // only pay for the wake-up when the dispatcher thread is (about to go) asleep
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_dispatcher_sleeping.load(std::memory_order_relaxed))
+        {
+            m_wakeup.signal();
+        }
+
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            m_performance_itf->increment_number_of_calls_queued();
+        }
+        m_performance_itf->report_queue_size(static_cast<std::uint32_t>(queue_size));
+        if (m_bounded)
+        {
+            m_performance_itf->report_queue_occupancy(static_cast<std::uint32_t>(queue_size), static_cast<std::uint32_t>(m_bound.capacity));
+        }
+    }
+
+    // counts the tasks in before they are pushed, applies the policy when the queue is full.
+    // a batch larger than the capacity gets in when the queue is empty.
+    bool try_reserve_room(std::size_t count) noexcept
+    {
+        auto size = m_ready_queue_size.load(std::memory_order_relaxed);
+        do
+        {
+            if ((size != 0) && (size + count > m_bound.capacity))
             {
-                auto run_next_task_at = m_queue.top()->run_at();
-                auto now = std::chrono::steady_clock::now();
-                if (now < run_next_task_at)
+                return false;
+            }
+        } while (!m_ready_queue_size.compare_exchange_weak(size, size + count, std::memory_order_seq_cst, std::memory_order_relaxed));
+        return true;
+    }
+
+    void reserve_room(TaskNode& first, std::size_t count, DispatcherPriority priority)
+    {
+        if (try_reserve_room(count))
+        {
+            return;
+        }
+
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            m_performance_itf->report_queue_full(m_bound.policy);
+        }
+
+        switch (m_bound.policy)
+        {
+        case QueueFullPolicy::block:
+            wait_for_room(count, std::chrono::steady_clock::duration::max());
+            return;
+        case QueueFullPolicy::fail:
+            throw queue_full_exception();
+        case QueueFullPolicy::drop_oldest:
+            // when only pinned tasks are queued there is nothing to drop, then it waits like block
+            while (!try_reserve_room(count))
+            {
+                if (!drop_oldest_task())
+                {
+                    wait_for_room(count, std::chrono::milliseconds(1));
+                }
+            }
+            return;
+        case QueueFullPolicy::coalesce:
+            // the new task takes the room of the one it replaces
+            if ((count == 1) && first.replace_key && !first.pinned && replace_queued_task(first, priority))
+            {
+                return;
+            }
+            throw queue_full_exception();
+        }
+    }
+
+    // the dispatcher wakes blocked producers whenever it takes a task
+    void wait_for_room(std::size_t count, std::chrono::steady_clock::duration timeout)
+    {
+        std::unique_lock<std::mutex> lock(m_room_mutex);
+        ++m_blocked_producers;
+        auto reserve = [this, count] { return try_reserve_room(count); };
+        if (timeout == std::chrono::steady_clock::duration::max())
+        {
+            m_room_available.wait(lock, reserve);
+        }
+        else
+        {
+            m_room_available.wait_for(lock, timeout, reserve);
+        }
+        --m_blocked_producers;
+    }
+
+    // notifications and async tasks only, from the lowest lane first. Pinned nodes (timers,
+    // synchronize, coalesced notifications) stay.
+    bool drop_oldest_task()
+    {
+        auto now = std::chrono::steady_clock::now();
+        TaskNode* node = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_consumer_mutex);
+            for (auto priority : { DispatcherPriority::background, DispatcherPriority::normal, DispatcherPriority::critical })
+            {
+                node = ready_queue(priority).remove_first_if([&now](const TaskNode& candidate)
                 {
-                    // this is the time it takes to wait until the next call is scheduled.
-                    wait_duration = run_next_task_at - now;
+                    return !candidate.pinned && (candidate.has_callable() ||
+                        ((candidate.task->interval() == std::chrono::steady_clock::duration::zero()) && (candidate.task->run_at() <= now)));
+                });
+                if (node != nullptr)
+                {
+                    break;
                 }
             }
         }
+        if (node == nullptr)
+        {
+            return false;
+        }
+        --m_ready_queue_size;
+        TaskNodePool::instance().release(node);
+        return true;
+    }
+
+    // takes a queued notification with the same replace key out of the lane, the caller queues its replacement
+    bool replace_queued_task(const TaskNode& replacement, DispatcherPriority priority)
+    {
+        TaskNode* node = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_consumer_mutex);
+            node = ready_queue(priority).remove_first_if([&replacement](const TaskNode& candidate)
+            {
+                return !candidate.pinned && candidate.has_callable() && (candidate.replace_key == replacement.replace_key);
+            });
+        }
+        if (node == nullptr)
+        {
+            return false;
+        }
+        TaskNodePool::instance().release(node);
+        return true;
+    }
+
+    // with drop_oldest and coalesce producers take nodes out of the ready queues as well,
+    // the dispatcher then pops under the same lock
+    TaskNode* pop_ready(DispatcherPriority priority) noexcept
+    {
+        if (!m_shared_consumer)
+        {
+            return ready_queue(priority).try_pop();
+        }
+        std::lock_guard<std::mutex> lock(m_consumer_mutex);
+        return ready_queue(priority).try_pop();
+    }
+
+    void task_taken() noexcept
+    {
+        --m_ready_queue_size;
+        if (m_blocked_producers.load(std::memory_order_seq_cst) != 0)
+        {
+            std::lock_guard<std::mutex> lock(m_room_mutex);
+            m_room_available.notify_all();
+        }
+    }
+
+    // nodes are recycled, together with the time they were queued the address is unique enough to link enqueue and start
+    static std::uint64_t trace_id(const TaskNode& node) noexcept
+    {
+        return reinterpret_cast<std::uintptr_t>(&node) ^ static_cast<std::uint64_t>(node.queued_at.time_since_epoch().count());
+    }
+
+    void trace_enqueue(TaskNode* first, TaskNode* last) noexcept
+    {
+        for (auto node = first; ; node = node->next.load(std::memory_order_relaxed))
+        {
+            performance::trace(performance::TracePhase::complete, "dispatcher", "enqueue");
+            performance::trace(performance::TracePhase::flow_start, "dispatcher", "queued", trace_id(*node));
+            if (node == last)
+            {
+                break;
+            }
+        }
+    }
+
+    bool suspend()
+    {
+        // if no task scheduled wait for a long time before waking up
+        auto wait_duration = std::chrono::steady_clock::duration(max_wait_duration);
+
+        if (!ready_queues_empty())
+        {
+            wait_duration = std::chrono::steady_clock::duration::zero();
+        }
+        else if (!m_timers.empty())
+        {
+            // this is the time it takes to wait until the next call is scheduled.
+            auto now = std::chrono::steady_clock::now();
+            auto run_next_task_at = m_timers.next_expiry();
+            wait_duration = (now < run_next_task_at) ? (run_next_task_at - now) : std::chrono::steady_clock::duration::zero();
+        }
 
         // Wait until it is time to run the next call 
         // or until something else has happened.
-        m_wakeup.try_wait_for(wait_duration);
+        if (wait_duration > std::chrono::steady_clock::duration::zero())
+        {
+            auto idle_start = std::chrono::steady_clock::now();
+            auto adaptive_spin = (m_idle_strategy.load(std::memory_order_relaxed) == IdleStrategy::adaptive_spin);
+            if (adaptive_spin)
+            {
+                // the flag is not set while spinning, so producers do not pay for a wake-up
+                auto work_arrived = m_idle_backoff.wait([this]
+                {
+                    return !ready_queues_empty() || (m_internal_state != DispatcherState::running);
+                }, idle_start + wait_duration);
+                if (work_arrived)
+                {
+                    return true;
+                }
+                wait_duration -= std::min(wait_duration, std::chrono::steady_clock::now() - idle_start);
+            }
+
+            // announce the sleep before the final check of the ready queue,
+            // a producer either sees the flag or its task is seen here.
+            m_dispatcher_sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ready_queues_empty())
+            {
+                m_wakeup.try_wait_for(wait_duration);
+            }
+            m_dispatcher_sleeping.store(false, std::memory_order_relaxed);
+
+            if (adaptive_spin)
+            {
+                m_idle_backoff.parked(std::chrono::steady_clock::now() - idle_start);
+            }
+        }
+        return true;
+    }
+
+    MpscQueue<TaskNode>& ready_queue(DispatcherPriority priority) noexcept
+    {
+        return m_ready_queues[static_cast<std::size_t>(priority)];
+    }
+
+    bool ready_queues_empty() noexcept
+    {
+        std::unique_lock<std::mutex> lock(m_consumer_mutex, std::defer_lock);
+        if (m_shared_consumer)
+        {
+            lock.lock();
+        }
+        for (auto& queue : m_ready_queues)
+        {
+            if (!queue.empty())
+            {
+                return false;
+            }
+        }
         return true;
     }
 
-    void main_loop()
+    // moves the timers that are due to the todo list.
+    // only called from the dispatcher thread.
+    void collect_due_timers(std::vector<TaskNode*>& tasks_to_run)
+    {
+        // cancelled tasks are dropped here: call() skips them and they are not rescheduled.
+        m_timers.advance(std::chrono::steady_clock::now(), [&tasks_to_run](pooled_task_node&& timer)
+        {
+            timer->queued_at = timer->run_at();
+            tasks_to_run.push_back(timer.release());
+        });
+    }
+
+    // runs up to the budget of the lane from its ready queue, tasks scheduled in the future
+    // go to the timer queue. Critical tasks posted in the meantime run in between the tasks of lower lanes.
+    void run_lane(DispatcherPriority priority, std::chrono::steady_clock::time_point& now)
+    {
+        auto& pool = TaskNodePool::instance();
+
+        for (std::size_t count = 0; count < lane_budget[static_cast<std::size_t>(priority)];)
+        {
+            auto node = pop_ready(priority);
+            if (node == nullptr)
+            {
+                return;
+            }
+            task_taken();
+            performance::trace(performance::TracePhase::instant, "dispatcher", "dequeue", 0, m_ready_queue_size);
+
+            if (!is_due(node->run_at(), now))
+            {
+                insert_timer(node);
+                continue;
+            }
+
+            run_node(node, priority);
+            pool.release(node);
+            ++count;
+
+            if (priority != DispatcherPriority::critical)
+            {
+                run_lane(DispatcherPriority::critical, now);
+            }
+        }
+    }
+
+    // `now` is refreshed only when a task looks early, it may have been posted after `now` was taken
+    static bool is_due(const std::chrono::steady_clock::time_point& run_at, std::chrono::steady_clock::time_point& now)
+    {
+        if (run_at <= now)
+        {
+            return true;
+        }
+        now = std::chrono::steady_clock::now();
+        return run_at <= now;
+    }
+
+    void run_node(TaskNode* node, DispatcherPriority priority)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto queue_latency = start - node->queued_at;
+        auto latency = static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(queue_latency).count());
+        m_performance_itf->report_latency_in_milliseconds(latency);
+        m_performance_itf->report_latency_in_milliseconds(priority, latency);
+        m_performance_itf->report_queue_latency(std::chrono::duration_cast<std::chrono::nanoseconds>(queue_latency));
+
+        // the node is emptied by running it
+        auto identity = m_check_deadlines ? node->identity() : nullptr;
+        auto tag = m_profile_tasks ? node->tag() : nullptr;
+        auto cpu_start = m_profile_tasks ? performance::thread_cpu_time() : std::chrono::nanoseconds::zero();
+        auto tracing = performance::tracing_enabled();
+        if (tracing)
+        {
+            performance::trace(performance::TracePhase::begin, "dispatcher", node->tag());
+            performance::trace(performance::TracePhase::flow_end, "dispatcher", "queued", trace_id(*node));
+        }
+        run_node_task(node);
+        if (tracing)
+        {
+            performance::trace(performance::TracePhase::end, "dispatcher", nullptr);
+        }
+
+        auto execution_time = std::chrono::steady_clock::now() - start;
+        m_performance_itf->report_execution_time(std::chrono::duration_cast<std::chrono::nanoseconds>(execution_time));
+        if (m_check_deadlines)
+        {
+            check_deadline(identity, priority, queue_latency, execution_time);
+        }
+        if (m_profile_tasks)
+        {
+            m_task_profiler.record(tag, std::chrono::duration_cast<std::chrono::nanoseconds>(queue_latency),
+                std::chrono::duration_cast<std::chrono::nanoseconds>(execution_time), performance::thread_cpu_time() - cpu_start);
+        }
+    }
+
+    // records a violation when the task took longer than the required response time from queueing to finishing
+    void check_deadline(const char* identity, DispatcherPriority priority,
+        const std::chrono::steady_clock::duration& queue_latency, const std::chrono::steady_clock::duration& execution_time)
+    {
+        if (queue_latency + execution_time <= m_required_response_time)
+        {
+            return;
+        }
+
+        ++m_deadline_violations;
+        if (priority != DispatcherPriority::background)
+        {
+            m_higher_lanes_late = true;
+        }
+        m_performance_itf->report_deadline_violation({ identity, priority, queue_latency, execution_time, m_ready_queue_size });
+    }
+
+    // after a late critical or normal task the background lane is run, skipped or dropped
+    void run_background_lane(std::chrono::steady_clock::time_point& now)
+    {
+        if (!m_higher_lanes_late)
+        {
+            run_lane(DispatcherPriority::background, now);
+            return;
+        }
+
+        switch (m_background_work_policy.load())
+        {
+        case BackgroundWorkPolicy::run:
+            run_lane(DispatcherPriority::background, now);
+            break;
+        case BackgroundWorkPolicy::defer:
+            break;
+        case BackgroundWorkPolicy::shed:
+            while (auto node = pop_ready(DispatcherPriority::background))
+            {
+                task_taken();
+                ++m_shed_tasks;
+                TaskNodePool::instance().release(node);
+            }
+            break;
+        }
+    }
+
+    void run_node_task(TaskNode* node)
+    {
+        if (node->has_callable())
+        {
+            // like the packaged task notify used to create, an exception of a notification is swallowed
+            try
+            {
+                node->run();
+            }
+            catch (...)
+            {
+            }
+            return;
+        }
+
+        // check start of call
+        node->task->call();
+
+        // recurring non-canceled task must be rescheduled,
+        // this is the dispatcher thread so it can go straight into the timer queue
+        if (node->task->reschedule())
+        {
+            node->task->reset();
+            auto timer = TaskNodePool::instance().allocate();
+            timer->task = std::move(node->task);
+            insert_timer(timer);
+        }
+    }
+
+    // the timer queue owns the node until it is due, a node still queued at destruction goes back to the pool.
+    // only called from the dispatcher thread.
+    void insert_timer(TaskNode* node)
+    {
+        pooled_task_node timer(node);
+        auto run_at = timer->run_at();
+        m_timers.insert(run_at, std::move(timer));
+    }
+
+    void main_loop(const ThreadPlacement& placement)
     {
         // check all scheduled tasks that need to be executed
-        // pop them off the queue and add to todo list
-        // this copy frees up the queue for adding new tasks
-        // without having to wait for the execution time of a running task
-        std::list<std::shared_ptr<InternalDispatcherTaskItf>> tasks_to_run;
+        // pop them off the queues and add to todo list
+        std::vector<TaskNode*> tasks_to_run;
+        auto& pool = TaskNodePool::instance();
 
         try
         {
+            apply_thread_placement(placement, 0, 1);
+
             static_assert(std::is_class<CTX>::value, "dispatcher thread context must be a class");
             // force context to be created
             CTX thread_context;
@@ -191,42 +905,25 @@ private:
             {
                 if (m_internal_state == DispatcherState::stopping) break;
 
-                // pop all tasks from queue that need running,
-                // copy to local list so queue can be unlocked and doesn't have to wait on
-                // tasks that need running.
-                {
-                    std::unique_lock<std::mutex> lock(m_queue_mutex);
-                    auto now = std::chrono::steady_clock::now();
-
-                    // pop all tasks ready to run
-                    while ((m_queue.size() > 0) && (now >= m_queue.top()->run_at()))
-                    {
-                        tasks_to_run.push_back(m_queue.top());
-                        m_queue.pop();
-                    }
-
-                    m_performance_itf->report_queue_size(static_cast<std::uint32_t>(m_queue.size()));
-                }
+                // sampled once per round, when profiling is off a task pays one branch on a plain bool
+                m_profile_tasks = m_task_profiling_requested.load(std::memory_order_relaxed);
 
-                // loop over all tasks to run
-                for (auto task_ptr : tasks_to_run)
+                // timers first, they became due before anything that is posted now
+                collect_due_timers(tasks_to_run);
+                for (auto node : tasks_to_run)
                 {
-                    auto start = std::chrono::steady_clock::now();
-                    auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(start - task_ptr->run_at());
-                    m_performance_itf->report_latency_in_milliseconds(static_cast<std::uint32_t>(latency.count()));
-
-                    // check start of call
-                    task_ptr->call();
-
-                    // recurring non-canceled task must be rescheduled
-                    if (task_ptr->reschedule())
-                    {
-                        task_ptr->reset();
-                        queue_task(task_ptr);
-                    }
+                    run_node(node, DispatcherPriority::normal);
+                    pool.release(node);
                 }
-
                 tasks_to_run.clear();
+
+                auto now = std::chrono::steady_clock::now();
+                m_higher_lanes_late = false;
+                run_lane(DispatcherPriority::critical, now);
+                run_lane(DispatcherPriority::normal, now);
+                run_background_lane(now);
+
+                m_performance_itf->report_queue_size(static_cast<std::uint32_t>(m_ready_queue_size + m_timers.size()));
             }
 
             m_internal_state = DispatcherState::stopped;
@@ -241,13 +938,47 @@ private:
     std::thread::id m_dispatcher_thread_id;
     std::future<void> m_dispatch_future;
 
-    std::mutex m_queue_mutex;
-    std::priority_queue<std::shared_ptr<InternalDispatcherTaskItf>, std::vector<std::shared_ptr<InternalDispatcherTaskItf>>, task_compare> m_queue;
+    // tasks run per lane in one round of the dispatcher loop, the shares of the lanes when all are busy
+    static constexpr std::array<std::size_t, number_of_dispatcher_priorities> lane_budget{ 64, 16, 4 };
+
+    // written by producers, one queue per priority lane
+    std::array<MpscQueue<TaskNode>, number_of_dispatcher_priorities> m_ready_queues;
+    std::atomic<std::size_t> m_ready_queue_size{ 0 };
+    std::atomic<bool> m_dispatcher_sleeping{ false };
+
+    // optional bound of the ready queues, see QueueFullPolicy
+    const QueueBound m_bound;
+    const bool m_bounded;
+    const bool m_shared_consumer;
+    std::mutex m_consumer_mutex;
+    std::mutex m_room_mutex;
+    std::condition_variable m_room_available;
+    std::atomic<std::size_t> m_blocked_producers{ 0 };
+
+    CoalescedNotifications m_coalesced;
+
+    // owned by the dispatcher thread, no locking required
+    TimingWheel<pooled_task_node> m_timers;
 
     StateVariable<DispatcherState> m_internal_state;
     Signal m_wakeup;
 
+    // the required response time is the deadline of every task, from queueing until it has finished.
+    // duration::max() (the default) switches the check off.
     const std::chrono::steady_clock::duration m_required_response_time;
+    const bool m_check_deadlines;
+    bool m_higher_lanes_late = false;
+    std::atomic<BackgroundWorkPolicy> m_background_work_policy{ BackgroundWorkPolicy::run };
+    std::atomic<IdleStrategy> m_idle_strategy{ IdleStrategy::park };
+    IdleBackoff m_idle_backoff;
+    std::atomic<std::size_t> m_deadline_violations{ 0 };
+    std::atomic<std::size_t> m_shed_tasks{ 0 };
+
+    // per tag profile of the tasks, owned by the dispatcher thread
+    std::atomic<bool> m_task_profiling_requested{ false };
+    bool m_profile_tasks = false;
+    performance::TaskProfiler m_task_profiler;
+
     std::shared_ptr<performance::DispatcherPerformanceItf> m_performance_itf;
 };
 
@@ -4,6 +4,9 @@
 #pragma once
 #include <chrono>
 #include <memory>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
 #include <cpplib/types/interface.h>
 #include <cpplib/types/non_copyable.h>
 
@@ -30,6 +33,12 @@ struct InternalDispatcherTaskItf :
     virtual void call() = 0;
     virtual void reset() = 0;
     virtual const bool reschedule() noexcept = 0;
+
+    // type name of the callable, identifies the task in diagnostics
+    virtual const char* identity() const noexcept = 0;
+
+    // tag given when the task was posted (by default the posting function), the identity when there is none
+    virtual const char* tag() const noexcept = 0;
 };
 
 template<typename R>
@@ -38,20 +47,24 @@ struct InternalDispatcherTask :
 {
 public:
     template<typename L>
-    InternalDispatcherTask(const std::chrono::steady_clock::time_point& run_at, const L& fn) noexcept :
+    InternalDispatcherTask(const std::chrono::steady_clock::time_point& run_at, const L& fn, const char* tag = nullptr) noexcept :
         m_run_at{ run_at },
         m_interval{ std::chrono::steady_clock::duration::zero() },
         m_task{ fn },
+        m_identity{ typeid(L).name() },
+        m_tag{ tag },
         m_is_recurring{ false },
         m_is_active{ true }
     {
     }
 
     template<typename L>
-    InternalDispatcherTask(const std::chrono::steady_clock::duration& interval, const L& fn) noexcept :
+    InternalDispatcherTask(const std::chrono::steady_clock::duration& interval, const L& fn, const char* tag = nullptr) noexcept :
         m_run_at{ std::chrono::steady_clock::now() },
         m_interval{ interval },
         m_task{ fn },
+        m_identity{ typeid(L).name() },
+        m_tag{ tag },
         m_is_recurring{ true },
         m_is_active{ true }
     {
@@ -103,16 +116,105 @@ public:
         return m_is_active && m_is_recurring;
     }
 
+    virtual const char* identity() const noexcept override
+    {
+        return m_identity;
+    }
+
+    virtual const char* tag() const noexcept override
+    {
+        return (m_tag != nullptr) ? m_tag : m_identity;
+    }
+
 private:
     std::chrono::steady_clock::time_point m_run_at;
     std::chrono::steady_clock::duration m_interval;
     std::packaged_task<R()> m_task;
+    const char* m_identity;
+    const char* m_tag;
 
     mutable std::mutex m_cancellation_mutex;
     std::atomic<bool> m_is_recurring;
     std::atomic<bool> m_is_active;
 };
 
+// one-shot notification that runs at a given time. Nobody waits for a result, so unlike
+// InternalDispatcherTask the callable is stored without a packaged task and its shared state.
+template<typename L>
+struct InternalDispatcherNotification final :
+    public InternalDispatcherTaskItf
+{
+public:
+    template<typename F>
+    InternalDispatcherNotification(const std::chrono::steady_clock::time_point& run_at, F&& fn) :
+        m_run_at{ run_at },
+        m_fn{ std::forward<F>(fn) },
+        m_is_active{ true }
+    {
+    }
+
+    virtual void call() override
+    {
+        if (!m_is_active)
+        {
+            return;
+        }
+        // like the packaged task of a notification, an exception is swallowed
+        try
+        {
+            m_fn();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    virtual const bool recurring() const noexcept override
+    {
+        return false;
+    }
+
+    virtual const std::chrono::steady_clock::time_point& run_at() const noexcept override
+    {
+        return m_run_at;
+    }
+
+    virtual const std::chrono::steady_clock::duration& interval() const noexcept override
+    {
+        static const std::chrono::steady_clock::duration none = std::chrono::steady_clock::duration::zero();
+        return none;
+    }
+
+    virtual void cancel() override
+    {
+        m_is_active = false;
+    }
+
+    virtual void reset() override
+    {
+    }
+
+    virtual const bool reschedule() noexcept override
+    {
+        return false;
+    }
+
+    virtual const char* identity() const noexcept override
+    {
+        return typeid(L).name();
+    }
+
+    virtual const char* tag() const noexcept override
+    {
+        return identity();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_run_at;
+    L m_fn;
+    std::atomic<bool> m_is_active;
+};
+
 struct task_compare
 {
     bool operator()(const std::shared_ptr<InternalDispatcherTaskItf>& lhs, const std::shared_ptr<InternalDispatcherTaskItf>& rhs) const noexcept
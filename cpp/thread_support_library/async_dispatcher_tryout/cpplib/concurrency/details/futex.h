@@ -0,0 +1,112 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+#if defined(_WIN32)
+#include <cpplib/win32/win_api.h>
+#pragma comment(lib,"Synchronization.lib")
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// Waiting on a 32 bit atomic with a timeout: WaitOnAddress on windows, the futex system call on linux,
+// elsewhere a table of condition variables hashed by address. std::atomic::wait has no timeout and
+// needs C++20.
+//
+// futex_wait returns when the word no longer holds the expected value, when woken, when the timeout
+// has passed, or spuriously; the caller checks its condition again. Waking takes no lock (except in
+// the fallback), the caller skips it when it knows that nobody waits.
+
+namespace cpp
+{
+namespace concurrency
+{
+namespace details
+{
+
+#if !defined(_WIN32) && !defined(__linux__)
+struct FutexBucket
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+inline FutexBucket& futex_bucket(const void* address) noexcept
+{
+    static FutexBucket buckets[64];
+    return buckets[std::hash<const void*>{}(address) % 64];
+}
+#endif
+
+inline void futex_wait(const std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::steady_clock::duration timeout) noexcept
+{
+    if (timeout <= std::chrono::steady_clock::duration::zero())
+    {
+        return;
+    }
+    // callers wait in a loop, a day at a time keeps the conversions below from overflowing
+    timeout = std::min<std::chrono::steady_clock::duration>(timeout, std::chrono::hours(24));
+
+#if defined(_WIN32)
+    auto milliseconds = std::chrono::ceil<std::chrono::milliseconds>(timeout).count();
+    auto wait_time = (milliseconds >= INFINITE) ? (INFINITE - 1) : static_cast<DWORD>(milliseconds);
+    ::WaitOnAddress(const_cast<std::atomic<std::uint32_t>*>(&word), &expected, sizeof(expected), wait_time);
+#elif defined(__linux__)
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    timespec relative{};
+    relative.tv_sec = static_cast<time_t>(seconds.count());
+    relative.tv_nsec = static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(timeout - seconds).count());
+    ::syscall(SYS_futex, &word, FUTEX_WAIT_PRIVATE, expected, &relative, nullptr, 0);
+#else
+    auto& bucket = futex_bucket(&word);
+    std::unique_lock<std::mutex> lock(bucket.mutex);
+    if (word.load(std::memory_order_seq_cst) == expected)
+    {
+        bucket.changed.wait_for(lock, timeout);
+    }
+#endif
+}
+
+inline void futex_wake_one(std::atomic<std::uint32_t>& word) noexcept
+{
+#if defined(_WIN32)
+    ::WakeByAddressSingle(&word);
+#elif defined(__linux__)
+    ::syscall(SYS_futex, &word, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+    // all, the waiters of other words in the bucket may be picked otherwise
+    auto& bucket = futex_bucket(&word);
+    std::lock_guard<std::mutex> lock(bucket.mutex);
+    bucket.changed.notify_all();
+#endif
+}
+
+inline void futex_wake_all(std::atomic<std::uint32_t>& word) noexcept
+{
+#if defined(_WIN32)
+    ::WakeByAddressAll(&word);
+#elif defined(__linux__)
+    ::syscall(SYS_futex, &word, FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+#else
+    auto& bucket = futex_bucket(&word);
+    std::lock_guard<std::mutex> lock(bucket.mutex);
+    bucket.changed.notify_all();
+#endif
+}
+
+} // details
+} // concurrency
+} // cpp
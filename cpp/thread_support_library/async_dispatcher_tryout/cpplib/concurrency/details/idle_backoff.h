@@ -0,0 +1,115 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace cpp
+{
+namespace concurrency
+{
+namespace details
+{
+
+// tells the core that this is a spin loop: saves power and leaves the pipeline to the other hyperthread
+inline void cpu_relax() noexcept
+{
+#if (defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))) || defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+    __yield();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+// Spin, then yield, then let the caller park. The window adapts to the idle periods seen so far:
+// an idle period that ended within max_window (work arrived while spinning, or soon after parking)
+// doubles the window, a longer one halves it. Bursty traffic thus gets caught while spinning,
+// a quiet thread soon stops burning CPU.
+// With a single hardware thread the producer cannot run while we spin, so only yielding is done.
+class IdleBackoff
+{
+public:
+    static constexpr auto default_max_window = std::chrono::microseconds(50);
+
+    explicit IdleBackoff(std::chrono::steady_clock::duration max_window = default_max_window) noexcept :
+        m_max_window{ max_window },
+        m_window{ max_window / 4 },
+        m_can_spin{ std::thread::hardware_concurrency() != 1 }
+    {
+    }
+
+    // spins for the window and yields for as long again, at most until the deadline.
+    // True when ready() became true, the caller parks otherwise.
+    template<typename Ready>
+    bool wait(Ready&& ready, std::chrono::steady_clock::time_point deadline) noexcept
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto spin_until = std::min(deadline, start + (m_can_spin ? m_window : std::chrono::steady_clock::duration::zero()));
+        auto yield_until = std::min(deadline, spin_until + m_window);
+
+        for (auto now = start; now < yield_until; now = std::chrono::steady_clock::now())
+        {
+            // the clock is read every few rounds only
+            for (int round = 0; round < 16; ++round)
+            {
+                if (ready())
+                {
+                    adapt(std::chrono::steady_clock::now() - start);
+                    return true;
+                }
+                if (now < spin_until)
+                {
+                    cpu_relax();
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        return false;
+    }
+
+    // idle time of a period that ended after parking, measured from the start of the wait
+    void parked(std::chrono::steady_clock::duration idle_time) noexcept
+    {
+        adapt(idle_time);
+    }
+
+    std::chrono::steady_clock::duration window() const noexcept
+    {
+        return m_window;
+    }
+
+private:
+    void adapt(std::chrono::steady_clock::duration idle_time) noexcept
+    {
+        if (idle_time <= m_max_window)
+        {
+            m_window = std::min(m_max_window, std::max<std::chrono::steady_clock::duration>(2 * m_window, std::chrono::microseconds(1)));
+        }
+        else
+        {
+            m_window /= 2;
+        }
+    }
+
+    const std::chrono::steady_clock::duration m_max_window;
+    std::chrono::steady_clock::duration m_window;
+    const bool m_can_spin;
+};
+
+} // details
+} // concurrency
+} // cpp
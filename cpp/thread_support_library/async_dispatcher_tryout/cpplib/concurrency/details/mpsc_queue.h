@@ -0,0 +1,134 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <cpplib/types/non_copyable.h>
+#include "cache_line.h"
+
+namespace cpp
+{
+namespace concurrency
+{
+namespace details
+{
+
+// Unbounded lock-free multi-producer/single-consumer intrusive FIFO queue.
+// push() may be called from any thread, try_pop() only from the one consumer thread.
+// Node must have a `std::atomic<Node*> next` member, the queue never allocates and does not own the nodes.
+//
+// Based on Dmitry Vyukov's intrusive MPSC node based queue:
+// a producer publishes its node with a single atomic exchange, so producers never wait on each other.
+template<typename Node>
+class MpscQueue final :
+    public NonCopyable
+{
+public:
+    MpscQueue() :
+        m_head{ &m_stub },
+        m_tail{ &m_stub }
+    {
+    }
+
+    void push(Node* node) noexcept
+    {
+        push(node, node);
+    }
+
+    // pushes the chain first..last, linked through their next members, with a single exchange.
+    // the chain becomes visible to the consumer at once and stays contiguous.
+    void push(Node* first, Node* last) noexcept
+    {
+        last->next.store(nullptr, std::memory_order_relaxed);
+        Node* previous = m_head.exchange(last, std::memory_order_acq_rel);
+        // between the exchange and this store the consumer sees the queue as (temporarily) empty
+        previous->next.store(first, std::memory_order_release);
+    }
+
+    Node* try_pop() noexcept
+    {
+        Node* tail = m_tail;
+        Node* next = tail->next.load(std::memory_order_acquire);
+
+        if (tail == &m_stub)
+        {
+            if (next == nullptr)
+            {
+                return nullptr;
+            }
+            m_tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next != nullptr)
+        {
+            m_tail = next;
+            return tail;
+        }
+
+        // tail is the last node, a producer may be linking a new one right now
+        if (tail != m_head.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+
+        // put the stub back so the last node can be handed out
+        push(&m_stub);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next != nullptr)
+        {
+            m_tail = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    // consumer only: unlinks and returns the oldest node that matches, nullptr when there is none.
+    // The newest node is never taken, a producer may be linking the next one behind it.
+    template<typename Pred>
+    Node* remove_first_if(Pred&& pred) noexcept
+    {
+        Node* previous = nullptr;
+        for (Node* node = m_tail; ; )
+        {
+            Node* next = node->next.load(std::memory_order_acquire);
+            if (next == nullptr)
+            {
+                return nullptr;
+            }
+            if ((node != &m_stub) && pred(*node))
+            {
+                if (previous == nullptr)
+                {
+                    m_tail = next;
+                }
+                else
+                {
+                    previous->next.store(next, std::memory_order_relaxed);
+                }
+                return node;
+            }
+            previous = node;
+            node = next;
+        }
+    }
+
+    // only reliable when called from the consumer thread
+    bool empty() const noexcept
+    {
+        return (m_tail == &m_stub) && (m_stub.next.load(std::memory_order_acquire) == nullptr);
+    }
+
+private:
+    alignas(cache_line_size) std::atomic<Node*> m_head;
+    alignas(cache_line_size) Node* m_tail;
+    Node m_stub;
+};
+
+} // details
+} // concurrency
+} // cpp
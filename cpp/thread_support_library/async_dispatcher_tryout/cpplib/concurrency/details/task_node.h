@@ -0,0 +1,273 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <cpplib/types/non_copyable.h>
+#include "cache_line.h"
+#include "dispatcher_task.h"
+
+namespace cpp
+{
+namespace concurrency
+{
+namespace details
+{
+
+// Queue entry of the dispatcher. Either carries a fire-and-forget callable, stored inline
+// when it fits in inline_size bytes, or a shared InternalDispatcherTask (async, scheduled tasks).
+// Nodes are recycled through the TaskNodePool so queueing a small lambda does not allocate.
+struct alignas(cache_line_size) TaskNode final :
+    public NonCopyable
+{
+    static constexpr std::size_t inline_size = 64;
+
+    template<typename L>
+    static constexpr bool fits_inline() noexcept
+    {
+        return (sizeof(L) <= inline_size) && (alignof(L) <= alignof(std::max_align_t));
+    }
+
+    template<typename L>
+    void emplace(L&& fn, const char* tag = nullptr);
+
+    void run()
+    {
+        auto invoke = m_invoke;
+        m_invoke = nullptr;
+        invoke(m_storage, true);
+    }
+
+    // destroys the callable and releases the task without running them
+    void clear() noexcept
+    {
+        if (m_invoke != nullptr)
+        {
+            auto invoke = m_invoke;
+            m_invoke = nullptr;
+            invoke(m_storage, false);
+        }
+        task.reset();
+        replace_key.reset();
+        not_before = {};
+    }
+
+    bool has_callable() const noexcept
+    {
+        return m_invoke != nullptr;
+    }
+
+    // type name of the callable or of the task's callable, for diagnostics
+    const char* identity() const noexcept
+    {
+        return task ? task->identity() : m_identity;
+    }
+
+    // profiling tag of the callable or of the task, the identity when none was given
+    const char* tag() const noexcept
+    {
+        return task ? task->tag() : ((m_tag != nullptr) ? m_tag : m_identity);
+    }
+
+    // earliest time the node may run, a callable runs right away unless posted with notify_at
+    std::chrono::steady_clock::time_point run_at() const noexcept
+    {
+        return task ? task->run_at() : not_before;
+    }
+
+    std::atomic<TaskNode*> next{ nullptr };
+    std::chrono::steady_clock::time_point queued_at;
+    std::shared_ptr<InternalDispatcherTaskItf> task;
+    // never dropped or replaced by a full bounded queue
+    bool pinned = false;
+    // set by notify_replacing: with QueueFullPolicy::coalesce a notification with the same key replaces the node
+    std::optional<std::uint64_t> replace_key;
+    // set by notify_at for a callable, a task carries its own time
+    std::chrono::steady_clock::time_point not_before{};
+
+private:
+    // runs (if requested) and destroys the stored callable
+    using invoke_fn = void(*)(void* storage, bool run);
+
+    invoke_fn m_invoke = nullptr;
+    const char* m_identity = nullptr;
+    const char* m_tag = nullptr;
+    alignas(std::max_align_t) unsigned char m_storage[inline_size];
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+
+// Process wide freelist of TaskNodes.
+// Nodes are released to a shared lock-free stack, a thread that needs nodes takes the whole stack
+// at once into its thread local cache. Taking everything with one exchange avoids the ABA problem
+// of popping single nodes from a lock-free stack.
+class TaskNodePool final :
+    public NonCopyable
+{
+public:
+    // nodes beyond this number are freed instead of pooled, bounds the memory kept after a burst
+    static constexpr std::size_t max_pooled_nodes = 1 << 16;
+
+    static TaskNodePool& instance()
+    {
+        static TaskNodePool pool;
+        return pool;
+    }
+
+    TaskNode* allocate()
+    {
+        auto& cache = local_cache();
+        if (cache.head == nullptr)
+        {
+            cache.head = m_free.exchange(nullptr, std::memory_order_acquire);
+        }
+
+        if (cache.head != nullptr)
+        {
+            auto node = cache.head;
+            cache.head = node->next.load(std::memory_order_relaxed);
+            return node;
+        }
+
+        ++m_heap_allocations;
+        ++m_live_nodes;
+        return new TaskNode();
+    }
+
+    void release(TaskNode* node) noexcept
+    {
+        node->clear();
+        if (m_live_nodes > max_pooled_nodes)
+        {
+            --m_live_nodes;
+            delete node;
+            return;
+        }
+
+        auto head = m_free.load(std::memory_order_relaxed);
+        do
+        {
+            node->next.store(head, std::memory_order_relaxed);
+        } while (!m_free.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // number of heap allocations done for task nodes and callables that did not fit inline,
+    // stays constant once the dispatcher runs in steady state.
+    std::size_t heap_allocations() const noexcept
+    {
+        return m_heap_allocations;
+    }
+
+    void count_heap_allocation() noexcept
+    {
+        ++m_heap_allocations;
+    }
+
+private:
+    struct LocalCache
+    {
+        ~LocalCache()
+        {
+            while (head != nullptr)
+            {
+                auto node = head;
+                head = node->next.load(std::memory_order_relaxed);
+                TaskNodePool::instance().release(node);
+            }
+        }
+
+        TaskNode* head = nullptr;
+    };
+
+    TaskNodePool() = default;
+
+    ~TaskNodePool()
+    {
+        auto node = m_free.exchange(nullptr);
+        while (node != nullptr)
+        {
+            auto next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+    static LocalCache& local_cache() noexcept
+    {
+        static thread_local LocalCache cache;
+        return cache;
+    }
+
+    alignas(cache_line_size) std::atomic<TaskNode*> m_free{ nullptr };
+    alignas(cache_line_size) std::atomic<std::size_t> m_live_nodes{ 0 };
+    std::atomic<std::size_t> m_heap_allocations{ 0 };
+};
+
+// returns a node to the pool, for nodes owned outside a queue such as the timers of the dispatcher
+struct TaskNodeRelease
+{
+    void operator()(TaskNode* node) const noexcept
+    {
+        TaskNodePool::instance().release(node);
+    }
+};
+
+using pooled_task_node = std::unique_ptr<TaskNode, TaskNodeRelease>;
+
+//---------------------------------------------------------------------------------------------------------------------
+
+template<typename L>
+void TaskNode::emplace(L&& fn, const char* tag)
+{
+    using callable_type = std::decay_t<L>;
+    m_identity = typeid(callable_type).name();
+    m_tag = tag;
+
+    if constexpr (fits_inline<callable_type>())
+    {
+        new (m_storage) callable_type(std::forward<L>(fn));
+        m_invoke = [](void* storage, bool run)
+        {
+            struct DestroyOnExit
+            {
+                ~DestroyOnExit()
+                {
+                    callable.~callable_type();
+                }
+                callable_type& callable;
+            } guard{ *static_cast<callable_type*>(storage) };
+
+            if (run)
+            {
+                guard.callable();
+            }
+        };
+    }
+    else
+    {
+        TaskNodePool::instance().count_heap_allocation();
+        new (m_storage) callable_type*(new callable_type(std::forward<L>(fn)));
+        m_invoke = [](void* storage, bool run)
+        {
+            std::unique_ptr<callable_type> callable(*static_cast<callable_type**>(storage));
+            if (run)
+            {
+                (*callable)();
+            }
+        };
+    }
+}
+
+} // details
+} // concurrency
+} // cpp
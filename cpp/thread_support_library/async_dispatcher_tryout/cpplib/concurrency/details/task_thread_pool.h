@@ -0,0 +1,125 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <cpplib/types/non_copyable.h>
+
+namespace cpp
+{
+namespace concurrency
+{
+namespace details
+{
+
+// Process wide threads for Task. A task usually runs long and blocks, so unlike the dispatcher pool
+// every started task gets a thread of its own: an idle thread when there is one, otherwise a new one.
+// Idle threads are kept for idle_timeout, so starting short tasks in a row does not create a thread
+// each time. Beyond max_threads running tasks new ones wait until a thread becomes idle; tasks often
+// run until they are cancelled, so the default bound is far above the number of tasks expected at once.
+class TaskThreadPool final :
+    public NonCopyable
+{
+public:
+    static constexpr std::size_t default_max_threads = 1024;
+    static constexpr auto idle_timeout = std::chrono::seconds(10);
+
+    static TaskThreadPool& instance()
+    {
+        static TaskThreadPool pool(default_max_threads);
+        return pool;
+    }
+
+    explicit TaskThreadPool(std::size_t max_threads) :
+        m_max_threads{ max_threads }
+    {
+    }
+
+    // waits until the running jobs have finished
+    ~TaskThreadPool()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_job_queued.notify_all();
+        m_thread_stopped.wait(lock, [this] { return m_threads == 0; });
+    }
+
+    // the job must not throw
+    void submit(std::function<void()> job)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+        if ((m_idle_threads >= m_jobs.size()) || (m_threads >= m_max_threads))
+        {
+            m_job_queued.notify_one();
+            return;
+        }
+
+        // started under the lock: until it is released no worker can take the job, so a failed start
+        // removes exactly the job pushed above
+        try
+        {
+            std::thread([this] { worker(); }).detach();
+        }
+        catch (...)
+        {
+            m_jobs.pop_back();
+            throw;
+        }
+        ++m_threads;
+    }
+
+    std::size_t number_of_threads() const
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_threads;
+    }
+
+private:
+    void worker()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;)
+        {
+            ++m_idle_threads;
+            auto has_job = m_job_queued.wait_for(lock, idle_timeout, [this] { return !m_jobs.empty() || m_stopping; });
+            --m_idle_threads;
+            if (!has_job || m_jobs.empty())
+            {
+                break;
+            }
+
+            auto job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            lock.unlock();
+            job();
+            job = nullptr;
+            lock.lock();
+        }
+
+        // the pool may be destroyed as soon as the lock is released
+        --m_threads;
+        m_thread_stopped.notify_all();
+    }
+
+    const std::size_t m_max_threads;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_job_queued;
+    std::condition_variable m_thread_stopped;
+    std::deque<std::function<void()>> m_jobs;
+    std::size_t m_threads = 0;
+    std::size_t m_idle_threads = 0;
+    bool m_stopping = false;
+};
+
+} // details
+} // concurrency
+} // cpp
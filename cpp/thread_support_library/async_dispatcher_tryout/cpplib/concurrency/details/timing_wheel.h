@@ -0,0 +1,441 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <cpplib/types/non_copyable.h>
+
+namespace cpp
+{
+namespace concurrency
+{
+namespace details
+{
+
+// Hierarchical timing wheel (Varghese & Lauck) with O(1) insert and cancel.
+//
+// Time is divided in ticks of `resolution`. Level 0 has one slot per tick for the next 64 ticks,
+// every next level has slots that are 64 times as wide. Entries move down a level ("cascade")
+// when the current time enters their slot. An entry fires at the first tick at or after its expiry,
+// so it can be up to one resolution late, never early.
+// Entries beyond the range of the wheel are parked in the top level and re-inserted when cascaded.
+//
+// Not thread-safe, meant to be owned by one (dispatcher) thread or guarded by the owner.
+// A handle stays valid until its entry has fired or has been cancelled.
+template<typename T>
+class TimingWheel final :
+    public NonCopyable
+{
+    struct Node;
+
+public:
+    using clock = std::chrono::steady_clock;
+    using handle = Node*;
+
+    explicit TimingWheel(
+        const clock::duration& resolution = std::chrono::milliseconds(1),
+        const clock::time_point& start = clock::now()) :
+        m_resolution{ resolution },
+        m_start{ start }
+    {
+    }
+
+    ~TimingWheel()
+    {
+        for (auto& level : m_slots)
+        {
+            for (auto& slot : level)
+            {
+                delete_list(slot);
+            }
+        }
+        delete_list(m_due);
+        delete_list(m_firing);
+        delete_list(m_free);
+    }
+
+    handle insert(const clock::time_point& at, T value)
+    {
+        auto node = allocate();
+        node->value.emplace(std::move(value));
+        node->expiry_tick = to_tick(at);
+        place(node);
+        ++m_size;
+        return node;
+    }
+
+    void cancel(handle entry) noexcept
+    {
+        unlink(entry);
+        release(entry);
+        --m_size;
+    }
+
+    const T& get(handle entry) const noexcept
+    {
+        return *entry->value;
+    }
+
+    // time at which the entry will be fired at the latest
+    clock::time_point expiry(handle entry) const noexcept
+    {
+        return to_time(entry->expiry_tick);
+    }
+
+    bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    // time at which advance() should be called next, clock::time_point::max() when empty.
+    // this can be the time of a cascade instead of an expiry, advance() then fires nothing.
+    clock::time_point next_expiry() const noexcept
+    {
+        if (m_size == 0)
+        {
+            return clock::time_point::max();
+        }
+        if (m_due.head != nullptr)
+        {
+            return to_time(m_current_tick);
+        }
+        return to_time(next_event_tick());
+    }
+
+    // fires all entries that are due at `now`, in order of expiry.
+    // fn(T&&) may insert or cancel entries.
+    template<typename Fn>
+    void advance(const clock::time_point& now, Fn&& fn)
+    {
+        auto target = std::max(m_current_tick, to_tick_floor(now));
+
+        splice(m_due, m_firing);
+        fire(fn);
+
+        while (m_size > 0)
+        {
+            auto tick = next_event_tick();
+            if (tick > target)
+            {
+                break;
+            }
+
+            // entries of a cascaded slot that expire at this tick end up in the due list
+            m_current_tick = tick;
+            for (std::size_t level = number_of_levels - 1; level > 0; --level)
+            {
+                if ((tick & level_mask(level)) == 0)
+                {
+                    cascade(level, slot_index(tick, level));
+                }
+            }
+
+            auto slot = slot_index(tick, 0);
+            m_occupied[0] &= ~(std::uint64_t{ 1 } << slot);
+            splice(m_due, m_firing);
+            splice(m_slots[0][slot], m_firing);
+            fire(fn);
+        }
+
+        m_current_tick = target;
+    }
+
+private:
+    static constexpr std::size_t bits_per_level = 6;
+    static constexpr std::size_t slots_per_level = std::size_t{ 1 } << bits_per_level;
+    static constexpr std::size_t number_of_levels = 4;
+    static constexpr std::uint64_t wheel_range = std::uint64_t{ 1 } << (bits_per_level * number_of_levels);
+    static constexpr int not_in_slot = -1;
+
+    struct List
+    {
+        Node* head = nullptr;
+        Node* tail = nullptr;
+    };
+
+    struct Node
+    {
+        Node* previous = nullptr;
+        Node* next = nullptr;
+        List* list = nullptr;
+        int level = not_in_slot;
+        std::size_t slot = 0;
+        std::uint64_t expiry_tick = 0;
+        std::optional<T> value;
+    };
+
+    static constexpr std::uint64_t level_mask(std::size_t level) noexcept
+    {
+        return (std::uint64_t{ 1 } << (bits_per_level * level)) - 1;
+    }
+
+    static constexpr std::size_t slot_index(std::uint64_t tick, std::size_t level) noexcept
+    {
+        return static_cast<std::size_t>((tick >> (bits_per_level * level)) & (slots_per_level - 1));
+    }
+
+    static std::size_t count_trailing_zeros(std::uint64_t value) noexcept
+    {
+        std::size_t count = 0;
+        while ((value & 1) == 0)
+        {
+            value >>= 1;
+            ++count;
+        }
+        return count;
+    }
+
+    static std::uint64_t rotate_right(std::uint64_t value, std::size_t count) noexcept
+    {
+        count &= (slots_per_level - 1);
+        return (count == 0) ? value : ((value >> count) | (value << (slots_per_level - count)));
+    }
+
+    // first tick at or after `at`. Rounds up after the division, so that a deadline as far as
+    // clock::time_point::max() does not overflow
+    std::uint64_t to_tick(const clock::time_point& at) const noexcept
+    {
+        if (at <= m_start)
+        {
+            return 0;
+        }
+        auto elapsed = at - m_start;
+        auto ticks = elapsed / m_resolution;
+        if ((elapsed % m_resolution) != clock::duration::zero())
+        {
+            ++ticks;
+        }
+        return static_cast<std::uint64_t>(ticks);
+    }
+
+    // last tick at or before `at`
+    std::uint64_t to_tick_floor(const clock::time_point& at) const noexcept
+    {
+        if (at <= m_start)
+        {
+            return 0;
+        }
+        return static_cast<std::uint64_t>((at - m_start) / m_resolution);
+    }
+
+    // saturates at clock::time_point::max()
+    clock::time_point to_time(std::uint64_t tick) const noexcept
+    {
+        if (tick > static_cast<std::uint64_t>((clock::time_point::max() - m_start) / m_resolution))
+        {
+            return clock::time_point::max();
+        }
+        return m_start + m_resolution * static_cast<clock::rep>(tick);
+    }
+
+    // next tick at which a slot fires or cascades, there must be at least one entry in the wheel
+    std::uint64_t next_event_tick() const noexcept
+    {
+        auto next = std::numeric_limits<std::uint64_t>::max();
+        for (std::size_t level = 0; level < number_of_levels; ++level)
+        {
+            if (m_occupied[level] == 0)
+            {
+                continue;
+            }
+
+            // slots are visited in order starting right after the current one
+            auto block = m_current_tick >> (bits_per_level * level);
+            auto first = (slot_index(m_current_tick, level) + 1) & (slots_per_level - 1);
+            auto distance = count_trailing_zeros(rotate_right(m_occupied[level], first)) + 1;
+            auto tick = (block + distance) << (bits_per_level * level);
+            next = std::min(next, tick);
+        }
+        return next;
+    }
+
+    void place(Node* node) noexcept
+    {
+        if (node->expiry_tick <= m_current_tick)
+        {
+            append(m_due, node, not_in_slot, 0);
+            return;
+        }
+
+        auto delta = node->expiry_tick - m_current_tick;
+        auto slot_tick = node->expiry_tick;
+        if (delta >= wheel_range)
+        {
+            // too far away, park it in the furthest slot and re-insert when it cascades
+            delta = wheel_range - 1;
+            slot_tick = m_current_tick + delta;
+        }
+
+        std::size_t level = 0;
+        while (delta >= (std::uint64_t{ 1 } << (bits_per_level * (level + 1))))
+        {
+            ++level;
+        }
+
+        auto slot = slot_index(slot_tick, level);
+        m_occupied[level] |= (std::uint64_t{ 1 } << slot);
+        append(m_slots[level][slot], node, static_cast<int>(level), slot);
+    }
+
+    void cascade(std::size_t level, std::size_t slot) noexcept
+    {
+        m_occupied[level] &= ~(std::uint64_t{ 1 } << slot);
+        auto node = m_slots[level][slot].head;
+        m_slots[level][slot] = List{};
+        while (node != nullptr)
+        {
+            auto next = node->next;
+            node->list = nullptr;
+            place(node);
+            node = next;
+        }
+    }
+
+    template<typename Fn>
+    void fire(Fn& fn)
+    {
+        while (m_firing.head != nullptr)
+        {
+            auto node = m_firing.head;
+            unlink(node);
+            if (node->expiry_tick > m_current_tick)
+            {
+                place(node);
+                continue;
+            }
+
+            T value = std::move(*node->value);
+            release(node);
+            --m_size;
+            fn(std::move(value));
+        }
+    }
+
+    void append(List& list, Node* node, int level, std::size_t slot) noexcept
+    {
+        node->list = &list;
+        node->level = level;
+        node->slot = slot;
+        node->next = nullptr;
+        node->previous = list.tail;
+        if (list.tail != nullptr)
+        {
+            list.tail->next = node;
+        }
+        else
+        {
+            list.head = node;
+        }
+        list.tail = node;
+    }
+
+    void unlink(Node* node) noexcept
+    {
+        auto& list = *node->list;
+        if (node->previous != nullptr)
+        {
+            node->previous->next = node->next;
+        }
+        else
+        {
+            list.head = node->next;
+        }
+        if (node->next != nullptr)
+        {
+            node->next->previous = node->previous;
+        }
+        else
+        {
+            list.tail = node->previous;
+        }
+
+        if ((node->level != not_in_slot) && (list.head == nullptr))
+        {
+            m_occupied[node->level] &= ~(std::uint64_t{ 1 } << node->slot);
+        }
+        node->list = nullptr;
+        node->previous = nullptr;
+        node->next = nullptr;
+    }
+
+    // moves all nodes of `from` to the end of `to`
+    void splice(List& from, List& to) noexcept
+    {
+        for (auto node = from.head; node != nullptr; node = node->next)
+        {
+            node->list = &to;
+            node->level = not_in_slot;
+        }
+        if (from.head == nullptr)
+        {
+            return;
+        }
+        if (to.tail != nullptr)
+        {
+            to.tail->next = from.head;
+            from.head->previous = to.tail;
+        }
+        else
+        {
+            to.head = from.head;
+        }
+        to.tail = from.tail;
+        from = List{};
+    }
+
+    Node* allocate()
+    {
+        if (m_free.head == nullptr)
+        {
+            return new Node();
+        }
+        auto node = m_free.head;
+        unlink(node);
+        return node;
+    }
+
+    void release(Node* node) noexcept
+    {
+        node->value.reset();
+        append(m_free, node, not_in_slot, 0);
+    }
+
+    static void delete_list(List& list) noexcept
+    {
+        auto node = list.head;
+        while (node != nullptr)
+        {
+            auto next = node->next;
+            delete node;
+            node = next;
+        }
+        list = List{};
+    }
+
+    const clock::duration m_resolution;
+    const clock::time_point m_start;
+    std::uint64_t m_current_tick = 0;
+    std::size_t m_size = 0;
+
+    std::array<std::array<List, slots_per_level>, number_of_levels> m_slots{};
+    std::array<std::uint64_t, number_of_levels> m_occupied{};
+
+    List m_due;
+    List m_firing;
+    List m_free;
+};
+
+} // details
+} // concurrency
+} // cpp
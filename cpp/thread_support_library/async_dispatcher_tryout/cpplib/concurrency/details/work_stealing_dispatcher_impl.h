@@ -0,0 +1,803 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cpplib/concurrency/dispatcher_priority.h>
+#include <cpplib/concurrency/state_variable.h>
+#include <cpplib/concurrency/thread_placement.h>
+#include <cpplib/performance/cpplib_performance.h>
+#include <cpplib/performance/tracer.h>
+#include <cpplib/types/unreferenced_variables.h>
+#include "cache_line.h"
+#include "coalesced_notifications.h"
+#include "dispatcher_impl.h"
+#include "dispatcher_task.h"
+#include "timing_wheel.h"
+
+namespace cpp
+{
+namespace concurrency
+{
+
+// tasks posted with the same strand key never run concurrently
+// and run in the order in which they were posted.
+using strand_key = std::uint64_t;
+
+namespace details
+{
+
+// Pool of N dispatcher threads, each with its own deque of ready tasks.
+// An idle worker first drains its own deque, then steals from the other workers.
+// Ordering between tasks is only guaranteed for tasks posted on the same strand.
+template<typename CTX>
+class WorkStealingDispatcherImpl
+{
+public:
+    WorkStealingDispatcherImpl(
+        const std::chrono::steady_clock::duration& required_response_time,
+        std::shared_ptr<performance::DispatcherPerformanceItf> performance_itf,
+        std::size_t number_of_threads = std::max(1u, std::thread::hardware_concurrency()),
+        ThreadPlacement placement = {}) :
+        m_internal_state{ DispatcherState::starting },
+        m_required_response_time{ required_response_time },
+        m_check_deadlines{ (required_response_time > std::chrono::steady_clock::duration::zero()) && (required_response_time != std::chrono::steady_clock::duration::max()) },
+        m_performance_itf{ std::move(performance_itf) }
+    {
+        if (number_of_threads == 0)
+        {
+            throw std::invalid_argument("number of dispatcher threads must be non-zero");
+        }
+
+        // with first touch every worker allocates its own deques once it has been pinned
+        m_workers.resize(number_of_threads);
+        if (!placement.first_touch)
+        {
+            for (auto& worker : m_workers)
+            {
+                worker = std::make_unique<Worker>();
+            }
+        }
+
+        for (std::size_t index = 0; index < number_of_threads; ++index)
+        {
+            m_worker_futures.push_back(std::async(std::launch::async, [this, index, placement]()
+            {
+                main_loop(index, placement);
+            }));
+        }
+
+        m_internal_state.wait_for_any({ DispatcherState::running, DispatcherState::stopped });
+
+        // a worker failed to start (e.g. its thread context threw), rethrow its exception
+        if (m_internal_state == DispatcherState::stopped)
+        {
+            for (auto& future : m_worker_futures)
+            {
+                future.get();
+            }
+        }
+    }
+
+    ~WorkStealingDispatcherImpl()
+    {
+        stop();
+        for (auto& future : m_worker_futures)
+        {
+            future.get();
+        }
+    }
+
+    void stop()
+    {
+        if (m_internal_state == DispatcherState::running)
+        {
+            synchronize();
+        }
+        m_internal_state.set_if_in(DispatcherState::running, DispatcherState::stopping);
+        wake_all();
+        m_internal_state.wait_for(DispatcherState::stopped);
+    }
+
+    // waits until the pool has run every notify/async task queued so far,
+    // call_every and call_at timers are not waited for.
+    // Tasks queued from now on count in the other epoch, so producers that keep posting do not hold it up.
+    void synchronize()
+    {
+        if (is_dispatcher_thread())
+        {
+            return;
+        }
+
+        std::unique_lock<std::mutex> synchronizing(m_synchronize_mutex);
+        auto& outstanding = m_outstanding[m_epoch++ % m_outstanding.size()].count;
+
+        std::unique_lock<std::mutex> lock(m_idle_mutex);
+        m_drained.wait(lock, [&outstanding] { return outstanding == 0; });
+    }
+
+    template<typename L>
+    auto call(L&& fn) -> decltype(fn())
+    {
+        auto future = async(fn);
+        return future.get();
+    }
+
+    template<typename L>
+    auto invoke(L&& fn) -> decltype(fn())
+    {
+        if (is_dispatcher_thread())
+        {
+            return fn();
+        }
+        else
+        {
+            return call(fn);
+        }
+    }
+
+    // tags are kept with the task, only the single threaded dispatcher profiles them
+    template<typename L>
+    auto async(L&& fn, const char* tag = nullptr) -> std::future<decltype(fn())>
+    {
+        return async(DispatcherPriority::normal, std::forward<L>(fn), tag);
+    }
+
+    template<typename L>
+    auto async(DispatcherPriority priority, L&& fn, const char* tag = nullptr) -> std::future<decltype(fn())>
+    {
+        auto task_ptr = std::make_shared<InternalDispatcherTask<decltype(fn())>>(std::chrono::steady_clock::now(), fn, tag);
+        queue_task(task_ptr, priority);
+        return task_ptr->get_future();
+    }
+
+    template<typename L>
+    const void notify(L&& fn, const char* tag = nullptr)
+    {
+        notify(DispatcherPriority::normal, std::forward<L>(fn), tag);
+    }
+
+    template<typename L>
+    const void notify(DispatcherPriority priority, L&& fn, const char* tag = nullptr)
+    {
+        auto task_ptr = std::make_shared<InternalDispatcherTask<decltype(fn())>>(std::chrono::steady_clock::now(), fn, tag);
+        queue_task(task_ptr, priority);
+    }
+
+    // the batch goes into one worker deque under one lock, idle workers are woken once to steal from it
+    template<typename Range>
+    void notify_bulk(Range&& fns)
+    {
+        auto now = std::chrono::steady_clock::now();
+        std::vector<task_ptr_type> tasks;
+        for (auto&& fn : fns)
+        {
+            tasks.push_back(std::make_shared<InternalDispatcherTask<decltype(fn())>>(now, fn));
+        }
+        queue_tasks(tasks);
+    }
+
+    template<typename Range>
+    auto async_bulk(Range&& fns) -> std::vector<std::future<decltype((*std::begin(fns))())>>
+    {
+        using result_type = decltype((*std::begin(fns))());
+
+        auto now = std::chrono::steady_clock::now();
+        std::vector<std::future<result_type>> futures;
+        std::vector<task_ptr_type> tasks;
+        for (auto&& fn : fns)
+        {
+            auto task_ptr = std::make_shared<InternalDispatcherTask<result_type>>(now, fn);
+            futures.push_back(task_ptr->get_future());
+            tasks.push_back(std::move(task_ptr));
+        }
+        queue_tasks(tasks);
+        return futures;
+    }
+
+    template<typename L>
+    auto async_in_strand(strand_key key, L&& fn) -> std::future<decltype(fn())>
+    {
+        auto task_ptr = std::make_shared<InternalDispatcherTask<decltype(fn())>>(std::chrono::steady_clock::now(), fn);
+        queue_strand_task(key, task_ptr);
+        return task_ptr->get_future();
+    }
+
+    template<typename L>
+    void notify_in_strand(strand_key key, L&& fn)
+    {
+        auto task_ptr = std::make_shared<InternalDispatcherTask<decltype(fn())>>(std::chrono::steady_clock::now(), fn);
+        queue_strand_task(key, task_ptr);
+    }
+
+    // the queued task runs in the strand of the same key, so two runs of a key never overlap
+    template<typename L>
+    void notify_coalesced(coalescing_key key, L&& fn, const char* tag = nullptr)
+    {
+        if (!m_coalesced.post(key, std::forward<L>(fn)))
+        {
+            return;
+        }
+        try
+        {
+            auto task_ptr = std::make_shared<InternalDispatcherTask<void>>(std::chrono::steady_clock::now(), [this, key]() noexcept
+            {
+                m_coalesced.run(key);
+            }, tag);
+            queue_strand_task(key, task_ptr);
+        }
+        catch (...)
+        {
+            m_coalesced.discard(key);
+            throw;
+        }
+    }
+
+    template<typename L>
+    std::unique_ptr<DispatcherTaskItf> schedule_task(const std::chrono::steady_clock::duration& interval, L&& fn, const char* tag = nullptr) noexcept
+    {
+        auto task_ptr = std::make_shared<InternalDispatcherTask<decltype(fn())>>(interval, fn, tag);
+        queue_timer(task_ptr);
+        return std::make_unique<DispatcherTask>(task_ptr);
+    }
+
+    template<typename L>
+    std::unique_ptr<DispatcherTaskItf> schedule_task(const std::chrono::steady_clock::time_point& time, L&& fn) noexcept
+    {
+        auto task_ptr = std::make_shared<InternalDispatcherTask<decltype(fn())>>(time, fn);
+        queue_timer(task_ptr);
+        return std::make_unique<DispatcherTask>(task_ptr);
+    }
+
+    // one-shot timer without a cancellation handle, used to resume coroutines.
+    // the timers are shared with all workers, so the callable still needs one allocation but no packaged task.
+    template<typename L>
+    void notify_at(const std::chrono::steady_clock::time_point& time, L&& fn)
+    {
+        queue_timer(std::make_shared<InternalDispatcherNotification<std::decay_t<L>>>(time, std::forward<L>(fn)));
+    }
+
+    bool is_dispatcher_thread() const
+    {
+        return (current_pool() == this);
+    }
+
+    std::size_t number_of_deadline_violations() const noexcept
+    {
+        return m_deadline_violations;
+    }
+
+private:
+    using task_ptr_type = std::shared_ptr<InternalDispatcherTaskItf>;
+
+    struct QueuedTask
+    {
+        task_ptr_type task;
+        bool is_timer;
+        DispatcherPriority priority;
+        // counter of unfinished tasks the task was counted in, see task_queued
+        std::size_t epoch;
+    };
+
+    struct StrandTask
+    {
+        task_ptr_type task;
+        std::size_t epoch;
+    };
+
+    // one deque per priority lane
+    struct alignas(cache_line_size) Worker
+    {
+        std::mutex mutex;
+        std::array<std::deque<QueuedTask>, number_of_dispatcher_priorities> lanes;
+        std::size_t pops = 0;
+
+        std::deque<QueuedTask>& lane(DispatcherPriority priority) noexcept
+        {
+            return lanes[static_cast<std::size_t>(priority)];
+        }
+    };
+
+    // Tasks of one strand, drained by at most one worker at a time.
+    struct Strand
+    {
+        std::deque<StrandTask> tasks;
+        bool scheduled = false;
+    };
+
+    static const void*& current_pool() noexcept
+    {
+        static thread_local const void* pool = nullptr;
+        return pool;
+    }
+
+    static std::size_t& current_worker_index() noexcept
+    {
+        static thread_local std::size_t index = 0;
+        return index;
+    }
+
+    // counts tasks that synchronize waits for, returns the epoch to pass to task_done
+    std::size_t task_queued(std::size_t count = 1)
+    {
+        auto epoch = m_epoch % m_outstanding.size();
+        m_outstanding[epoch].count += count;
+        return epoch;
+    }
+
+    void queue_task(const task_ptr_type& task_ptr, DispatcherPriority priority)
+    {
+        auto epoch = task_queued();
+
+        // tasks posted from a worker stay local, others are spread round robin
+        auto index = is_dispatcher_thread() ? current_worker_index() : (m_next_worker++ % m_workers.size());
+        auto queued = ++m_queued;
+        auto& worker = *m_workers[index];
+        trace_enqueue(*task_ptr);
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            worker.lane(priority).push_back({ task_ptr, false, priority, epoch });
+        }
+        ++m_pushes;
+
+        m_performance_itf->increment_number_of_calls_queued();
+        m_performance_itf->report_queue_size(static_cast<std::uint32_t>(queued));
+
+        wake_one();
+    }
+
+    void queue_tasks(std::vector<task_ptr_type>& tasks)
+    {
+        if (tasks.empty())
+        {
+            return;
+        }
+
+        auto epoch = task_queued(tasks.size());
+        auto index = is_dispatcher_thread() ? current_worker_index() : (m_next_worker++ % m_workers.size());
+        auto queued = (m_queued += tasks.size());
+        auto& worker = *m_workers[index];
+        for (auto& task_ptr : tasks)
+        {
+            trace_enqueue(*task_ptr);
+        }
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            for (auto& task_ptr : tasks)
+            {
+                worker.lane(DispatcherPriority::normal).push_back({ std::move(task_ptr), false, DispatcherPriority::normal, epoch });
+            }
+        }
+        ++m_pushes;
+
+        for (std::size_t count = 0; count < tasks.size(); ++count)
+        {
+            m_performance_itf->increment_number_of_calls_queued();
+        }
+        m_performance_itf->report_queue_size(static_cast<std::uint32_t>(queued));
+
+        // one wake-up for the whole batch, woken workers steal from the deque that got it
+        if (m_sleeping > 0)
+        {
+            std::unique_lock<std::mutex> lock(m_idle_mutex);
+            m_wakeup.notify_all();
+        }
+    }
+
+    void queue_strand_task(strand_key key, const task_ptr_type& task_ptr)
+    {
+        bool schedule_drain = false;
+        {
+            std::unique_lock<std::mutex> lock(m_strands_mutex);
+            auto& strand = m_strands[key];
+            // counted by itself, the drain that runs it may be queued after a synchronize has started
+            strand.tasks.push_back({ task_ptr, task_queued() });
+            if (!strand.scheduled)
+            {
+                strand.scheduled = true;
+                schedule_drain = true;
+            }
+        }
+
+        if (schedule_drain)
+        {
+            notify([this, key]() noexcept { drain_strand(key); });
+        }
+    }
+
+    // runs the tasks of one strand, hands the strand back to the pool
+    // after a bounded number of tasks so one busy strand cannot monopolize a worker.
+    void drain_strand(strand_key key) noexcept
+    {
+        static constexpr int max_tasks_per_drain = 64;
+
+        for (int count = 0; count < max_tasks_per_drain; ++count)
+        {
+            StrandTask task;
+            {
+                std::unique_lock<std::mutex> lock(m_strands_mutex);
+                auto it = m_strands.find(key);
+                if (it->second.tasks.empty())
+                {
+                    m_strands.erase(it);
+                    return;
+                }
+                task = std::move(it->second.tasks.front());
+                it->second.tasks.pop_front();
+            }
+            run_task(task.task, DispatcherPriority::normal);
+            task_done(task.epoch);
+        }
+
+        notify([this, key]() noexcept { drain_strand(key); });
+    }
+
+    void queue_timer(const task_ptr_type& task_ptr)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_timers_mutex);
+            m_timers.insert(task_ptr->run_at(), task_ptr);
+            m_next_timer_expiry = m_timers.next_expiry().time_since_epoch().count();
+        }
+        ++m_timer_generation;
+        m_performance_itf->increment_number_of_calls_queued();
+
+        // a sleeping worker must recompute its wake-up time
+        wake_one();
+    }
+
+    // moves all timers that are due onto the deque of the calling worker
+    void release_due_timers(std::size_t index)
+    {
+        // cheap check first, avoids taking the timer lock on every iteration
+        auto now = std::chrono::steady_clock::now();
+        if (now.time_since_epoch().count() < m_next_timer_expiry)
+        {
+            return;
+        }
+
+        std::vector<task_ptr_type> due;
+        {
+            std::unique_lock<std::mutex> lock(m_timers_mutex);
+            m_timers.advance(now, [&due](task_ptr_type&& task_ptr)
+            {
+                due.push_back(std::move(task_ptr));
+            });
+            m_next_timer_expiry = m_timers.next_expiry().time_since_epoch().count();
+        }
+
+        if (due.empty())
+        {
+            return;
+        }
+
+        m_queued += due.size();
+        auto& worker = *m_workers[index];
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            for (auto& task_ptr : due)
+            {
+                worker.lane(DispatcherPriority::normal).push_back({ std::move(task_ptr), true, DispatcherPriority::normal, 0 });
+            }
+        }
+        ++m_pushes;
+
+        if (due.size() > 1)
+        {
+            wake_one();
+        }
+    }
+
+    std::chrono::steady_clock::duration time_until_next_timer()
+    {
+        std::unique_lock<std::mutex> lock(m_timers_mutex);
+        if (m_timers.empty())
+        {
+            return max_wait_duration;
+        }
+        return std::max(std::chrono::steady_clock::duration::zero(), m_timers.next_expiry() - std::chrono::steady_clock::now());
+    }
+
+    // critical tasks first, but every 4th pop starts at the normal lane and every 16th
+    // at the background lane, so a flood of higher priority work cannot starve the lower lanes
+    bool pop_local(std::size_t index, QueuedTask& task)
+    {
+        auto& worker = *m_workers[index];
+        std::unique_lock<std::mutex> lock(worker.mutex);
+
+        auto first = std::size_t{ 0 };
+        if ((worker.pops % 16) == 15)
+        {
+            first = static_cast<std::size_t>(DispatcherPriority::background);
+        }
+        else if ((worker.pops % 4) == 3)
+        {
+            first = static_cast<std::size_t>(DispatcherPriority::normal);
+        }
+
+        for (std::size_t offset = 0; offset < number_of_dispatcher_priorities; ++offset)
+        {
+            auto& lane = worker.lanes[(first + offset) % number_of_dispatcher_priorities];
+            if (!lane.empty())
+            {
+                task = std::move(lane.front());
+                lane.pop_front();
+                ++worker.pops;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // steals from the back of a victim's deques, highest priority first, the owner pops from the front.
+    // Victims that are locked are skipped first, when one was skipped all of them are tried again waiting
+    // for the lock. Giving up means every deque was seen empty, so the worker may park.
+    bool steal(std::size_t index, QueuedTask& task)
+    {
+        bool contended = false;
+        for (auto blocking : { false, true })
+        {
+            for (std::size_t offset = 1; offset < m_workers.size(); ++offset)
+            {
+                auto& victim = *m_workers[(index + offset) % m_workers.size()];
+                std::unique_lock<std::mutex> lock(victim.mutex, std::defer_lock);
+                if (blocking)
+                {
+                    lock.lock();
+                }
+                else if (!lock.try_lock())
+                {
+                    contended = true;
+                    continue;
+                }
+
+                for (auto& lane : victim.lanes)
+                {
+                    if (!lane.empty())
+                    {
+                        task = std::move(lane.back());
+                        lane.pop_back();
+                        return true;
+                    }
+                }
+            }
+
+            if (!contended)
+            {
+                break;
+            }
+        }
+        return false;
+    }
+
+    void wake_one()
+    {
+        if (m_sleeping > 0)
+        {
+            std::unique_lock<std::mutex> lock(m_idle_mutex);
+            m_wakeup.notify_one();
+        }
+    }
+
+    void wake_all()
+    {
+        std::unique_lock<std::mutex> lock(m_idle_mutex);
+        m_wakeup.notify_all();
+    }
+
+    // `pushes` was read before the worker looked at the deques, a task pushed since then ends the wait.
+    // Tasks that other workers are about to take do not keep the worker awake.
+    void park(std::uint64_t pushes)
+    {
+        // a timer queued after this point changes the generation and ends the wait,
+        // so the wait duration gets recomputed.
+        auto timer_generation = m_timer_generation.load();
+        auto wait_duration = time_until_next_timer();
+
+        std::unique_lock<std::mutex> lock(m_idle_mutex);
+        ++m_sleeping;
+        m_wakeup.wait_for(lock, wait_duration, [this, pushes, timer_generation]
+        {
+            return (m_pushes != pushes) ||
+                (m_timer_generation != timer_generation) ||
+                (m_internal_state == DispatcherState::stopping);
+        });
+        --m_sleeping;
+    }
+
+    void run_task(const task_ptr_type& task_ptr, DispatcherPriority priority)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto queue_latency = start - task_ptr->run_at();
+        auto latency = static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(queue_latency).count());
+        m_performance_itf->report_latency_in_milliseconds(latency);
+        m_performance_itf->report_latency_in_milliseconds(priority, latency);
+        m_performance_itf->report_queue_latency(std::chrono::duration_cast<std::chrono::nanoseconds>(queue_latency));
+
+        auto tracing = performance::tracing_enabled();
+        if (tracing)
+        {
+            performance::trace(performance::TracePhase::begin, "dispatcher", task_ptr->tag());
+            performance::trace(performance::TracePhase::flow_end, "dispatcher", "queued", trace_id(*task_ptr));
+        }
+        task_ptr->call();
+        if (tracing)
+        {
+            performance::trace(performance::TracePhase::end, "dispatcher", nullptr);
+        }
+
+        auto execution_time = std::chrono::steady_clock::now() - start;
+        m_performance_itf->report_execution_time(std::chrono::duration_cast<std::chrono::nanoseconds>(execution_time));
+        if (m_check_deadlines)
+        {
+            check_deadline(*task_ptr, priority, queue_latency, execution_time);
+        }
+
+        // recurring non-canceled task must be rescheduled
+        if (task_ptr->reschedule())
+        {
+            task_ptr->reset();
+            queue_timer(task_ptr);
+        }
+    }
+
+    // a task is queued again when it recurs, its run_at is part of the id
+    static std::uint64_t trace_id(const InternalDispatcherTaskItf& task) noexcept
+    {
+        return reinterpret_cast<std::uintptr_t>(&task) ^ static_cast<std::uint64_t>(task.run_at().time_since_epoch().count());
+    }
+
+    static void trace_enqueue(const InternalDispatcherTaskItf& task) noexcept
+    {
+        if (performance::tracing_enabled())
+        {
+            performance::trace(performance::TracePhase::complete, "dispatcher", "enqueue");
+            performance::trace(performance::TracePhase::flow_start, "dispatcher", "queued", trace_id(task));
+        }
+    }
+
+    void check_deadline(const InternalDispatcherTaskItf& task, DispatcherPriority priority,
+        const std::chrono::steady_clock::duration& queue_latency, const std::chrono::steady_clock::duration& execution_time)
+    {
+        if (queue_latency + execution_time > m_required_response_time)
+        {
+            ++m_deadline_violations;
+            m_performance_itf->report_deadline_violation({ task.identity(), priority, queue_latency, execution_time, m_queued });
+        }
+    }
+
+    void task_done(std::size_t epoch)
+    {
+        if (--m_outstanding[epoch].count == 0)
+        {
+            std::unique_lock<std::mutex> lock(m_idle_mutex);
+            m_drained.notify_all();
+        }
+    }
+
+    void main_loop(std::size_t index, const ThreadPlacement& placement)
+    {
+        try
+        {
+            apply_thread_placement(placement, index, m_workers.size());
+            if (!m_workers[index])
+            {
+                m_workers[index] = std::make_unique<Worker>();
+            }
+
+            static_assert(std::is_class<CTX>::value, "dispatcher thread context must be a class");
+            // force context to be created, one per worker thread
+            CTX thread_context;
+            unreferenced::variable(thread_context);
+
+            current_pool() = this;
+            current_worker_index() = index;
+
+            // the other workers are stolen from, they have to be there
+            if (++m_workers_started == m_workers.size())
+            {
+                m_internal_state.set_if_in(DispatcherState::starting, DispatcherState::running);
+            }
+            m_internal_state.wait_for_any({ DispatcherState::running, DispatcherState::stopping });
+
+            while (m_internal_state != DispatcherState::stopping)
+            {
+                auto pushes = m_pushes.load();
+                release_due_timers(index);
+
+                QueuedTask task;
+                if (!pop_local(index, task) && !steal(index, task))
+                {
+                    park(pushes);
+                    continue;
+                }
+
+                --m_queued;
+                run_task(task.task, task.priority);
+                if (!task.is_timer)
+                {
+                    task_done(task.epoch);
+                }
+            }
+
+            current_pool() = nullptr;
+            worker_stopped();
+        }
+        catch (...)
+        {
+            current_pool() = nullptr;
+            m_internal_state = DispatcherState::stopping;
+            wake_all();
+            worker_stopped();
+            throw;
+        }
+    }
+
+    void worker_stopped()
+    {
+        if (++m_workers_stopped == m_workers.size())
+        {
+            m_internal_state = DispatcherState::stopped;
+        }
+    }
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::future<void>> m_worker_futures;
+    std::atomic<std::size_t> m_next_worker{ 0 };
+    std::atomic<std::size_t> m_workers_started{ 0 };
+    std::atomic<std::size_t> m_workers_stopped{ 0 };
+
+    // notify/async tasks queued but not yet finished, counted per epoch. synchronize starts a new epoch
+    // and waits for the counter of the one before.
+    struct alignas(cache_line_size) Outstanding
+    {
+        std::atomic<std::size_t> count{ 0 };
+    };
+
+    // tasks sitting in a worker deque, and the number of pushes to a deque, which wakes parked workers
+    alignas(cache_line_size) std::atomic<std::size_t> m_queued{ 0 };
+    alignas(cache_line_size) std::atomic<std::uint64_t> m_pushes{ 0 };
+    std::array<Outstanding, 2> m_outstanding;
+    alignas(cache_line_size) std::atomic<std::size_t> m_epoch{ 0 };
+    std::mutex m_synchronize_mutex;
+    alignas(cache_line_size) std::atomic<std::size_t> m_sleeping{ 0 };
+    std::atomic<std::uint64_t> m_timer_generation{ 0 };
+
+    std::mutex m_idle_mutex;
+    std::condition_variable m_wakeup;
+    std::condition_variable m_drained;
+
+    std::mutex m_timers_mutex;
+    TimingWheel<task_ptr_type> m_timers;
+    std::atomic<std::chrono::steady_clock::rep> m_next_timer_expiry{ std::chrono::steady_clock::time_point::max().time_since_epoch().count() };
+
+    std::mutex m_strands_mutex;
+    std::unordered_map<strand_key, Strand> m_strands;
+
+    CoalescedNotifications m_coalesced;
+
+    StateVariable<DispatcherState> m_internal_state;
+
+    // deadline of every task from queueing until it has finished, duration::max() switches the check off
+    const std::chrono::steady_clock::duration m_required_response_time;
+    const bool m_check_deadlines;
+    std::atomic<std::size_t> m_deadline_violations{ 0 };
+    std::shared_ptr<performance::DispatcherPerformanceItf> m_performance_itf;
+};
+
+} // details
+} // concurrency
+} // cpp
@@ -3,16 +3,26 @@
 #include <cassert>
 #include <future>
 #include <functional>
+#include <iterator>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
+#ifdef _WIN32
 #include <cpplib/com/apartment.h>
+#endif
 #include <cpplib/performance/cpplib_performance.h>
+#include <cpplib/preprocessor/caller_function.h>
 #include <cpplib/preprocessor/nodiscard.h>
-#include <cpplib/types/uuid.h>
+#include "cancellation_token.h"
+#include "coroutine.h"
+#include "dispatcher_priority.h"
 #include "details/dispatcher_impl.h"
+#include "details/work_stealing_dispatcher_impl.h"
 #include "injected_thread_itf.h"
 #include "task.h"
+#include "thread_placement.h"
 
 namespace cpp
 {
@@ -45,15 +55,18 @@ public:
 
 //--------------------------------------------------------------------------------------------------------------------
 
-template<typename CTX>
+// IMPL is the dispatcher engine: details::DispatcherImpl runs all tasks on one thread,
+// details::WorkStealingDispatcherImpl runs them on a pool of threads.
+template<typename CTX, typename IMPL = details::DispatcherImpl<CTX>>
 class DispatcherWithContext :
     public InjectedThreadItf
 {
 public:
-    DispatcherWithContext() noexcept :
+    // the constructors throw the exception of a dispatcher thread that failed to start, e.g. when CTX throws
+    DispatcherWithContext() :
         m_pimpl
         (
-            std::make_unique<details::DispatcherImpl<CTX>>
+            std::make_unique<IMPL>
             (
                 std::chrono::steady_clock::duration::max(),
                 performance::NullDispatcherPerformance::shared()
@@ -62,8 +75,28 @@ public:
     {
     }
 
-    DispatcherWithContext(const std::chrono::steady_clock::duration& required_response_time, std::shared_ptr<performance::DispatcherPerformanceItf> performance_itf) noexcept :
-        m_pimpl(std::make_unique<details::DispatcherImpl<CTX>>(required_response_time, performance_itf))
+    DispatcherWithContext(const std::chrono::steady_clock::duration& required_response_time, std::shared_ptr<performance::DispatcherPerformanceItf> performance_itf) :
+        m_pimpl(std::make_unique<IMPL>(required_response_time, performance_itf))
+    {
+    }
+
+    // only available for thread pool dispatchers, placement pins and names the workers, see ThreadPlacement
+    DispatcherWithContext(const std::chrono::steady_clock::duration& required_response_time, std::shared_ptr<performance::DispatcherPerformanceItf> performance_itf, std::size_t number_of_threads, ThreadPlacement placement = {}) :
+        m_pimpl(std::make_unique<IMPL>(required_response_time, performance_itf, number_of_threads, std::move(placement)))
+    {
+    }
+
+    // only for the single threaded dispatcher: at most bound.capacity tasks are queued, a full queue
+    // blocks the producer, fails (notify and async throw queue_full_exception), drops or coalesces, see QueueFullPolicy
+    DispatcherWithContext(const std::chrono::steady_clock::duration& required_response_time, std::shared_ptr<performance::DispatcherPerformanceItf> performance_itf, QueueBound bound, ThreadPlacement placement = {}) :
+        m_pimpl(std::make_unique<IMPL>(required_response_time, performance_itf, bound, std::move(placement)))
+    {
+    }
+
+    // only for the single threaded dispatcher, pins and names the dispatcher thread.
+    // Throws std::system_error when the thread cannot be pinned.
+    DispatcherWithContext(const std::chrono::steady_clock::duration& required_response_time, std::shared_ptr<performance::DispatcherPerformanceItf> performance_itf, ThreadPlacement placement) :
+        m_pimpl(std::make_unique<IMPL>(required_response_time, performance_itf, std::move(placement)))
     {
     }
 
@@ -102,10 +135,15 @@ public:
         m_pimpl->synchronize();
     }
 
+    // the single threaded dispatcher does not allocate on the way: the caller waits on a per-thread slot,
+    // see details::CallSlot. A pool dispatcher queues an async task and waits on its future.
     template<typename L>
     auto call(L&& fn) const -> decltype(fn())
     {
-        not_injected_thread_required("call cannot be called from dispatcher thread");
+        if (is_injected_thread())
+        {
+            throw requires_not_dispatcher_thread_exception("call cannot be called from dispatcher thread");
+        }
         return m_pimpl->call(fn);
     }
 
@@ -120,11 +158,12 @@ public:
     }
 
     // if you get a discared warning, then consider using notify. Or really use the returned future
+    // the tag names the task in the task profile, it defaults to the calling function and must be a static string
     template<typename L>
-    NO_DISCARD auto async(L&& fn) const -> std::future<decltype(fn())>
+    NO_DISCARD auto async(L&& fn, const char* tag = CPPLIB_CALLER_FUNCTION) const -> std::future<decltype(fn())>
     {
         not_injected_thread_required("async cannot be called from dispatcher thread");
-        return m_pimpl->async(fn);
+        return m_pimpl->async(fn, tag);
     }
 
     // if you get a discared warning, then consider using notify. Or really use the returned future
@@ -139,35 +178,217 @@ public:
     }
 
     template<typename L>
-    void notify(L&& fn) const
+    void notify(L&& fn, const char* tag = CPPLIB_CALLER_FUNCTION) const
     {
-        not_injected_thread_required("notify cannot be called from dispatcher thread");
         static_assert(std::is_void_v<decltype(fn())>, "only functions returning void may be scheduled");
         static_assert(noexcept(fn()), "make sure your lambda is noexcept, and that you catch ANY exceptions in your lambda if necessary"); 
 
+        // checked inline, building the message string for not_injected_thread_required would allocate on every call
         if (is_injected_thread())
         {
-            throw requires_not_dispatcher_thread_exception("async cannot be called from dispatcher thread");
+            throw requires_not_dispatcher_thread_exception("notify cannot be called from dispatcher thread");
         }
-        m_pimpl->notify(fn);
+        m_pimpl->notify(fn, tag);
+    }
+
+    // like notify, runs fn in the lane of the given priority
+    template<typename L>
+    void notify(DispatcherPriority priority, L&& fn, const char* tag = CPPLIB_CALLER_FUNCTION) const
+    {
+        static_assert(std::is_void_v<decltype(fn())>, "only functions returning void may be scheduled");
+        static_assert(noexcept(fn()), "make sure your lambda is noexcept, and that you catch ANY exceptions in your lambda if necessary");
+        if (is_injected_thread())
+        {
+            throw requires_not_dispatcher_thread_exception("notify cannot be called from dispatcher thread");
+        }
+        m_pimpl->notify(priority, fn, tag);
+    }
+
+    template<typename L>
+    NO_DISCARD auto async(DispatcherPriority priority, L&& fn, const char* tag = CPPLIB_CALLER_FUNCTION) const -> std::future<decltype(fn())>
+    {
+        not_injected_thread_required("async cannot be called from dispatcher thread");
+        return m_pimpl->async(priority, fn, tag);
+    }
+
+    // fn is skipped when the token is cancelled before fn gets its turn, checking costs no lock
+    template<typename L>
+    void notify(const CancellationToken& token, L&& fn, const char* tag = CPPLIB_CALLER_FUNCTION) const
+    {
+        static_assert(std::is_void_v<decltype(fn())>, "only functions returning void may be scheduled");
+        static_assert(noexcept(fn()), "make sure your lambda is noexcept, and that you catch ANY exceptions in your lambda if necessary");
+        if (is_injected_thread())
+        {
+            throw requires_not_dispatcher_thread_exception("notify cannot be called from dispatcher thread");
+        }
+        m_pimpl->notify([token, fn = std::forward<L>(fn)]() mutable noexcept
+        {
+            if (!token.is_cancelled())
+            {
+                fn();
+            }
+        }, tag);
     }
 
+    // the future throws cancelled_exception when the token is cancelled before fn gets its turn
     template<typename L>
-    NO_DISCARD std::unique_ptr<DispatcherTaskItf> call_every(const std::chrono::steady_clock::duration &duration, L&& fn) const noexcept
+    NO_DISCARD auto async(const CancellationToken& token, L&& fn, const char* tag = CPPLIB_CALLER_FUNCTION) const -> std::future<decltype(fn())>
+    {
+        not_injected_thread_required("async cannot be called from dispatcher thread");
+        return m_pimpl->async([token, fn = std::forward<L>(fn)]() mutable
+        {
+            token.throw_if_cancelled();
+            return fn();
+        }, tag);
+    }
+
+    // queues every callable of the range at once: one queue operation and at most one wake-up
+    // of the dispatcher for the whole batch. The callables run in the order of the range.
+    template<typename Range>
+    void notify_bulk(Range&& fns) const
+    {
+        using fn_type = decltype(*std::begin(fns));
+        static_assert(std::is_void_v<decltype(std::declval<fn_type>()())>, "only functions returning void may be scheduled");
+        static_assert(noexcept(std::declval<fn_type>()()), "make sure your lambda is noexcept, and that you catch ANY exceptions in your lambda if necessary");
+        if (is_injected_thread())
+        {
+            throw requires_not_dispatcher_thread_exception("notify cannot be called from dispatcher thread");
+        }
+        m_pimpl->notify_bulk(fns);
+    }
+
+    // like notify_bulk, returns one future per callable in the order of the range
+    template<typename Range>
+    NO_DISCARD auto async_bulk(Range&& fns) const -> std::vector<std::future<decltype((*std::begin(fns))())>>
+    {
+        not_injected_thread_required("async cannot be called from dispatcher thread");
+        return m_pimpl->async_bulk(fns);
+    }
+
+    // tasks with the same strand key run one at a time and in posting order,
+    // on a single threaded dispatcher every task is already in the same strand.
+    template<typename L>
+    void notify_in_strand(strand_key key, L&& fn) const
     {
         static_assert(std::is_void_v<decltype(fn())>, "only functions returning void may be scheduled");
         static_assert(noexcept(fn()), "make sure your lambda is noexcept, and that you catch ANY exceptions in your lambda if necessary");
-        return m_pimpl->schedule_task(duration, fn);
+        if (is_injected_thread())
+        {
+            throw requires_not_dispatcher_thread_exception("notify cannot be called from dispatcher thread");
+        }
+        m_pimpl->notify_in_strand(key, fn);
+    }
+
+    // while a notification of the key is pending, fn replaces its callable instead of being queued:
+    // the queue holds at most one task per key and it runs the latest fn. Merging updates is up to fn,
+    // e.g. by reading the latest state when it runs.
+    template<typename L>
+    void notify_coalesced(coalescing_key key, L&& fn, const char* tag = CPPLIB_CALLER_FUNCTION) const
+    {
+        static_assert(std::is_void_v<decltype(fn())>, "only functions returning void may be scheduled");
+        static_assert(noexcept(fn()), "make sure your lambda is noexcept, and that you catch ANY exceptions in your lambda if necessary");
+        if (is_injected_thread())
+        {
+            throw requires_not_dispatcher_thread_exception("notify cannot be called from dispatcher thread");
+        }
+        m_pimpl->notify_coalesced(key, std::forward<L>(fn), tag);
+    }
+
+    // like notify; only for the single threaded dispatcher with QueueFullPolicy::coalesce: when the
+    // queue is full, fn replaces the queued notification posted with the same key instead of failing
+    template<typename L>
+    void notify_replacing(coalescing_key key, L&& fn, const char* tag = CPPLIB_CALLER_FUNCTION) const
+    {
+        static_assert(std::is_void_v<decltype(fn())>, "only functions returning void may be scheduled");
+        static_assert(noexcept(fn()), "make sure your lambda is noexcept, and that you catch ANY exceptions in your lambda if necessary");
+        if (is_injected_thread())
+        {
+            throw requires_not_dispatcher_thread_exception("notify cannot be called from dispatcher thread");
+        }
+        m_pimpl->notify_replacing(key, std::forward<L>(fn), tag);
+    }
+
+    template<typename L>
+    NO_DISCARD auto async_in_strand(strand_key key, L&& fn) const -> std::future<decltype(fn())>
+    {
+        not_injected_thread_required("async cannot be called from dispatcher thread");
+        return m_pimpl->async_in_strand(key, fn);
+    }
+
+    template<typename L>
+    NO_DISCARD std::unique_ptr<DispatcherTaskItf> call_every(const std::chrono::steady_clock::duration &duration, L&& fn, const char* tag = CPPLIB_CALLER_FUNCTION) const noexcept
+    {
+        static_assert(std::is_void_v<decltype(fn())>, "only functions returning void may be scheduled");
+        static_assert(noexcept(fn()), "make sure your lambda is noexcept, and that you catch ANY exceptions in your lambda if necessary");
+        return m_pimpl->schedule_task(duration, fn, tag);
     }
 
     template<typename L>
     NO_DISCARD std::shared_ptr<DispatcherTaskItf> call_at(const std::chrono::steady_clock::time_point& time, L&& fn) const noexcept
     {
-        static_assert(std::is_void_v<decltype((object.*fn)(std::forward<Args>(args)...))>, "only functions returning void may be scheduled (no observable return value)");
-        static_assert(noexcept(std::declval(ClassType).fn(args...)), "make sure your lambda is noexcept, and that you catch ANY exceptions in your lambda if necessary");
+        static_assert(std::is_void_v<decltype(fn())>, "only functions returning void may be scheduled (no observable return value)");
+        static_assert(noexcept(fn()), "make sure your lambda is noexcept, and that you catch ANY exceptions in your lambda if necessary");
         return m_pimpl->schedule_task(time, fn);
     }
 
+    // number of tasks that took longer than the required response time, from queueing until finished
+    NO_DISCARD std::size_t number_of_deadline_violations() const noexcept
+    {
+        return m_pimpl->number_of_deadline_violations();
+    }
+
+    // only for the single threaded dispatcher
+    void set_background_work_policy(BackgroundWorkPolicy policy) const noexcept
+    {
+        m_pimpl->set_background_work_policy(policy);
+    }
+
+    // only for the single threaded dispatcher, parks when idle by default
+    void set_idle_strategy(IdleStrategy strategy) const noexcept
+    {
+        m_pimpl->set_idle_strategy(strategy);
+    }
+
+    // only for the single threaded dispatcher, background tasks dropped by BackgroundWorkPolicy::shed
+    NO_DISCARD std::size_t number_of_shed_tasks() const noexcept
+    {
+        return m_pimpl->number_of_shed_tasks();
+    }
+
+    // only for the single threaded dispatcher: collects count, wall time, CPU time and the maximum
+    // queue latency per task tag. Off by default, then it costs a branch per task.
+    void enable_task_profiling(bool enable = true) const noexcept
+    {
+        m_pimpl->enable_task_profiling(enable);
+    }
+
+    // only for the single threaded dispatcher, the top_n tags with the most wall time
+    NO_DISCARD std::vector<performance::TaskProfile> task_profile(std::size_t top_n = 10) const
+    {
+        not_injected_thread_required("task_profile cannot be called from dispatcher thread");
+        return m_pimpl->task_profile(top_n);
+    }
+
+    void reset_task_profile() const
+    {
+        m_pimpl->reset_task_profile();
+    }
+
+#if CPPLIB_HAS_COROUTINES
+    // co_await dispatcher.schedule() continues the coroutine on the dispatcher thread,
+    // the calling thread is not blocked and no future is created
+    NO_DISCARD details::ScheduleAwaiter<IMPL> schedule() const noexcept
+    {
+        return details::ScheduleAwaiter<IMPL>{ *m_pimpl };
+    }
+
+    // co_await dispatcher.after(duration) continues the coroutine on the dispatcher thread after the duration
+    NO_DISCARD details::ResumeAtAwaiter<IMPL> after(const std::chrono::steady_clock::duration& duration) const noexcept
+    {
+        return details::ResumeAtAwaiter<IMPL>{ *m_pimpl, std::chrono::steady_clock::now() + duration };
+    }
+#endif
+
     template<typename L>
     auto invoke(L&& fn) const -> decltype(fn())
     {
@@ -198,13 +419,19 @@ public:
     }
 
 private:
-    std::unique_ptr<details::DispatcherImpl<CTX>> m_pimpl;
+    std::unique_ptr<IMPL> m_pimpl;
 };
 
 //=================================================================================================================
 
 using Dispatcher = DispatcherWithContext<details::NullDispatcherContext>;
+using PoolDispatcher = DispatcherWithContext<details::NullDispatcherContext, details::WorkStealingDispatcherImpl<details::NullDispatcherContext>>;
+
+// dispatcher threads that are in the COM multithreaded apartment
+#ifdef _WIN32
 using MTADispatcher = DispatcherWithContext<cpp::com::MultithreadedApartment>;
+using MTAPoolDispatcher = DispatcherWithContext<cpp::com::MultithreadedApartment, details::WorkStealingDispatcherImpl<cpp::com::MultithreadedApartment>>;
+#endif
 
 //=================================================================================================================
 
@@ -0,0 +1,63 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cpp
+{
+namespace concurrency
+{
+
+// lane of a dispatcher task. Critical tasks (e.g. socket completions) run before normal ones,
+// background tasks run when there is nothing else to do. Every lane gets a share of the dispatcher
+// so a flood of higher priority work delays lower lanes but never starves them.
+enum class DispatcherPriority : std::uint8_t
+{
+    critical,
+    normal,
+    background
+};
+
+constexpr std::size_t number_of_dispatcher_priorities = 3;
+
+// what a dispatcher does with background work after a critical or normal task missed the required response time
+enum class BackgroundWorkPolicy : std::uint8_t
+{
+    run,        // keep running it
+    defer,      // skip the background lane as long as higher lanes miss their deadline
+    shed        // drop the queued background tasks, futures of dropped async tasks report a broken promise
+};
+
+// what a dispatcher with a bounded queue does with a task posted while the queue is full.
+// Timers and tasks posted from the dispatcher thread itself are always accepted.
+enum class QueueFullPolicy : std::uint8_t
+{
+    block,          // the producer waits until the dispatcher has taken a task
+    fail,           // notify and async throw queue_full_exception
+    drop_oldest,    // the oldest queued task of the lowest lane is dropped, the future of a dropped async task reports a broken promise
+    coalesce        // a notification posted with notify_replacing replaces a queued one with the same key and goes
+                    // to the back of the queue; without such a notification, and for every other task, it fails
+};
+
+// capacity of the ready queue over all lanes, in tasks. unbounded by default
+struct QueueBound
+{
+    static constexpr std::size_t unbounded = static_cast<std::size_t>(-1);
+
+    std::size_t capacity = unbounded;
+    QueueFullPolicy policy = QueueFullPolicy::block;
+};
+
+// what a dispatcher thread does when it runs out of work
+enum class IdleStrategy : std::uint8_t
+{
+    park,           // sleep until woken, costs no CPU while idle but every wake-up is a system call on both sides
+    adaptive_spin   // spin, then yield for a self-tuning window of at most 50 us before parking: tasks posted
+                    // meanwhile start within a microsecond and the producer skips the wake-up
+};
+
+} // concurrency
+} // cpp
@@ -0,0 +1,508 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+#include <cpplib/concurrency/injected_thread_itf.h>
+#include <cpplib/exceptions/invalid_state_exception.h>
+#include <cpplib/preprocessor/nodiscard.h>
+#include <cpplib/types/non_copyable.h>
+
+// Futures with continuations. Instead of parking a thread in get(), work is chained:
+//
+//   post(dispatcher, [] { return read(); })
+//       .then(other_dispatcher, [](const Data& data) { return process(data); })
+//       .then(dispatcher, [](const Result& result) { show(result); });
+//
+// Every continuation is queued on the dispatcher it was given once its input is ready.
+// An exception skips the continuations and ends up in the last future.
+// Future and Promise are cheap to copy, copies share the same result.
+
+namespace cpp
+{
+namespace concurrency
+{
+
+template<typename T>
+class Future;
+
+template<typename T>
+class Promise;
+
+namespace details
+{
+
+template<typename T>
+class FutureState final :
+    public NonCopyable
+{
+public:
+    using value_type = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+    void set_value(value_type value)
+    {
+        complete([this, &value] { m_value.emplace(std::move(value)); });
+    }
+
+    void set_exception(std::exception_ptr exception)
+    {
+        complete([this, &exception] { m_exception = std::move(exception); });
+    }
+
+    // runs fn on the thread completing the state, or right away when it is already complete
+    void on_ready(std::function<void()> fn)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (!m_ready)
+            {
+                m_continuations.push_back(std::move(fn));
+                return;
+            }
+        }
+        fn();
+    }
+
+    bool is_ready() const
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_ready;
+    }
+
+    void wait() const
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_ready_changed.wait(lock, [this] { return m_ready; });
+    }
+
+    // only valid once ready
+    const value_type& value() const
+    {
+        if (m_exception)
+        {
+            std::rethrow_exception(m_exception);
+        }
+        return *m_value;
+    }
+
+    std::exception_ptr exception() const noexcept
+    {
+        return m_exception;
+    }
+
+private:
+    template<typename Fn>
+    void complete(Fn&& store)
+    {
+        std::vector<std::function<void()>> continuations;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_ready)
+            {
+                throw invalid_state_exception("promise already satisfied");
+            }
+            store();
+            m_ready = true;
+            continuations.swap(m_continuations);
+        }
+        m_ready_changed.notify_all();
+
+        for (auto& continuation : continuations)
+        {
+            continuation();
+        }
+    }
+
+    mutable std::mutex m_mutex;
+    mutable std::condition_variable m_ready_changed;
+    bool m_ready = false;
+    std::optional<value_type> m_value;
+    std::exception_ptr m_exception;
+    std::vector<std::function<void()>> m_continuations;
+};
+
+// calls fn with the value of the state (nothing for void) and stores its result in the promise.
+// The promise is completed outside the try: an exception thrown by its own continuations is not the result of fn.
+template<typename T, typename R, typename Fn>
+void fulfil(const FutureState<T>& state, Promise<R>& promise, Fn& fn)
+{
+    std::optional<typename FutureState<R>::value_type> result;
+    try
+    {
+        auto invoke = [&state, &fn]() -> R
+        {
+            if constexpr (std::is_void_v<T>)
+            {
+                state.value();
+                return fn();
+            }
+            else
+            {
+                return fn(state.value());
+            }
+        };
+        if constexpr (std::is_void_v<R>)
+        {
+            invoke();
+            result.emplace();
+        }
+        else
+        {
+            result.emplace(invoke());
+        }
+    }
+    catch (...)
+    {
+        promise.set_exception(std::current_exception());
+        return;
+    }
+
+    if constexpr (std::is_void_v<R>)
+    {
+        promise.set_value();
+    }
+    else
+    {
+        promise.set_value(std::move(*result));
+    }
+}
+
+// The promise of a queued continuation, shared by the copies of the continuation. When the last
+// copy is destroyed without having run, e.g. dropped by a stopped dispatcher or a full bounded queue,
+// the next future reports a broken promise like a std::future would.
+template<typename R>
+class ContinuationPromise final :
+    public NonCopyable
+{
+public:
+    explicit ContinuationPromise(Promise<R> promise) :
+        m_promise{ std::move(promise) }
+    {
+    }
+
+    ~ContinuationPromise()
+    {
+        fail(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+    }
+
+    // the first of run and fail completes the promise
+    template<typename T, typename Fn>
+    void run(const FutureState<T>& state, Fn& fn)
+    {
+        if (!m_done.exchange(true))
+        {
+            fulfil(state, m_promise, fn);
+        }
+    }
+
+    void fail(std::exception_ptr exception) noexcept
+    {
+        if (!m_done.exchange(true))
+        {
+            try
+            {
+                m_promise.set_exception(std::move(exception));
+            }
+            catch (...)
+            {
+                // a continuation of the promise threw, nobody is left to report it to
+            }
+        }
+    }
+
+private:
+    Promise<R> m_promise;
+    std::atomic<bool> m_done{ false };
+};
+
+template<typename T, typename Fn>
+struct continuation_result
+{
+    using type = std::invoke_result_t<Fn&, const T&>;
+};
+
+template<typename Fn>
+struct continuation_result<void, Fn>
+{
+    using type = std::invoke_result_t<Fn&>;
+};
+
+} // details
+
+//--------------------------------------------------------------------------------------------------------------------
+
+template<typename T>
+class Future
+{
+public:
+    explicit Future(std::shared_ptr<details::FutureState<T>> state) noexcept :
+        m_state{ std::move(state) }
+    {
+    }
+
+    NO_DISCARD bool is_ready() const
+    {
+        return m_state->is_ready();
+    }
+
+    void wait() const
+    {
+        m_state->wait();
+    }
+
+    // blocks until ready, meant for the end of a pipeline, not for chaining
+    decltype(auto) get() const
+    {
+        m_state->wait();
+        if constexpr (std::is_void_v<T>)
+        {
+            m_state->value();
+        }
+        else
+        {
+            return m_state->value();
+        }
+    }
+
+    // queues fn(value) on the dispatcher once this future is ready, fn() for Future<void>.
+    // The dispatcher must outlive this future, otherwise pass it as a weak_ptr.
+    // When the dispatcher refuses the continuation, e.g. a full bounded queue, the next future
+    // fails with that exception; when it drops the continuation, with a broken promise.
+    template<typename Fn>
+    NO_DISCARD auto then(const InjectedThreadItf& dispatcher, Fn&& fn) const -> Future<typename details::continuation_result<T, std::decay_t<Fn>>::type>
+    {
+        return chain([&dispatcher](std::function<void()> continuation)
+        {
+            dispatcher.notify(std::move(continuation));
+        }, std::forward<Fn>(fn));
+    }
+
+    // like then, the dispatcher is only held while the continuation is queued.
+    // When it is gone by the time this future is ready, the next future reports a broken promise.
+    template<typename Fn>
+    NO_DISCARD auto then(std::weak_ptr<const InjectedThreadItf> dispatcher, Fn&& fn) const -> Future<typename details::continuation_result<T, std::decay_t<Fn>>::type>
+    {
+        return chain([dispatcher](std::function<void()> continuation)
+        {
+            if (auto locked = dispatcher.lock())
+            {
+                locked->notify(std::move(continuation));
+            }
+        }, std::forward<Fn>(fn));
+    }
+
+    // runs fn on the thread that completes this future, or right away when it is already ready.
+    // fn must be short, it delays everything else waiting for the future.
+    void on_ready(std::function<void()> fn) const
+    {
+        m_state->on_ready(std::move(fn));
+    }
+
+    std::exception_ptr exception() const noexcept
+    {
+        return m_state->exception();
+    }
+
+private:
+    // queue(continuation) is called on the thread that completes this future. The state is referenced
+    // weakly until then: a future nobody completes anymore releases the continuation, and so breaks its promise.
+    template<typename Queue, typename Fn>
+    auto chain(Queue queue, Fn&& fn) const -> Future<typename details::continuation_result<T, std::decay_t<Fn>>::type>
+    {
+        using result_type = typename details::continuation_result<T, std::decay_t<Fn>>::type;
+
+        Promise<result_type> promise;
+        auto next = promise.get_future();
+        auto pending = std::make_shared<details::ContinuationPromise<result_type>>(std::move(promise));
+        m_state->on_ready([weak_state = std::weak_ptr<details::FutureState<T>>(m_state), queue = std::move(queue), pending, fn = std::forward<Fn>(fn)]
+        {
+            // not thrown into the thread completing this future
+            try
+            {
+                queue([state = weak_state.lock(), pending, fn]() mutable
+                {
+                    pending->run(*state, fn);
+                });
+            }
+            catch (...)
+            {
+                pending->fail(std::current_exception());
+            }
+        });
+        return next;
+    }
+
+    std::shared_ptr<details::FutureState<T>> m_state;
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+
+template<typename T>
+class Promise
+{
+public:
+    Promise() :
+        m_state{ std::make_shared<details::FutureState<T>>() }
+    {
+    }
+
+    NO_DISCARD Future<T> get_future() const
+    {
+        return Future<T>{ m_state };
+    }
+
+    template<typename U = T, typename = std::enable_if_t<!std::is_void_v<U>>>
+    void set_value(U value) const
+    {
+        m_state->set_value(std::move(value));
+    }
+
+    template<typename U = T, typename = std::enable_if_t<std::is_void_v<U>>>
+    void set_value() const
+    {
+        m_state->set_value(std::monostate{});
+    }
+
+    void set_exception(std::exception_ptr exception) const
+    {
+        m_state->set_exception(std::move(exception));
+    }
+
+private:
+    std::shared_ptr<details::FutureState<T>> m_state;
+};
+
+//--------------------------------------------------------------------------------------------------------------------
+
+template<typename T>
+NO_DISCARD Future<T> make_ready_future(T value)
+{
+    Promise<T> promise;
+    promise.set_value(std::move(value));
+    return promise.get_future();
+}
+
+NO_DISCARD inline Future<void> make_ready_future()
+{
+    Promise<void> promise;
+    promise.set_value();
+    return promise.get_future();
+}
+
+// queues fn on the dispatcher, the start of a pipeline
+template<typename Fn>
+NO_DISCARD auto post(const InjectedThreadItf& dispatcher, Fn&& fn)
+{
+    return make_ready_future().then(dispatcher, std::forward<Fn>(fn));
+}
+
+// ready when all futures are ready, with their values in the same order.
+// fails with the first exception (in order of the futures) when any of them failed.
+template<typename T>
+NO_DISCARD auto when_all(std::vector<Future<T>> futures) -> Future<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>>
+{
+    using result_type = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+
+    struct Context
+    {
+        std::vector<Future<T>> futures;
+        std::atomic<std::size_t> remaining;
+        Promise<result_type> promise;
+    };
+
+    auto context = std::make_shared<Context>();
+    context->remaining = futures.size();
+    context->futures = std::move(futures);
+    auto result = context->promise.get_future();
+
+    auto complete = [context]
+    {
+        for (auto& future : context->futures)
+        {
+            if (auto exception = future.exception())
+            {
+                context->promise.set_exception(exception);
+                return;
+            }
+        }
+
+        if constexpr (std::is_void_v<T>)
+        {
+            context->promise.set_value();
+        }
+        else
+        {
+            std::vector<T> values;
+            values.reserve(context->futures.size());
+            for (auto& future : context->futures)
+            {
+                values.push_back(future.get());
+            }
+            context->promise.set_value(std::move(values));
+        }
+    };
+
+    if (context->futures.empty())
+    {
+        complete();
+        return result;
+    }
+
+    for (auto& future : context->futures)
+    {
+        future.on_ready([context, complete]
+        {
+            if (--context->remaining == 0)
+            {
+                complete();
+            }
+        });
+    }
+    return result;
+}
+
+// ready with the index of the first future that became ready, with a value or an exception.
+// the value itself is read from that future, which is ready by then.
+template<typename T>
+NO_DISCARD Future<std::size_t> when_any(const std::vector<Future<T>>& futures)
+{
+    if (futures.empty())
+    {
+        throw std::invalid_argument("when_any requires at least one future");
+    }
+
+    struct Context
+    {
+        std::atomic<bool> done{ false };
+        Promise<std::size_t> promise;
+    };
+
+    auto context = std::make_shared<Context>();
+    auto result = context->promise.get_future();
+    for (std::size_t index = 0; index < futures.size(); ++index)
+    {
+        futures[index].on_ready([context, index]
+        {
+            if (!context->done.exchange(true))
+            {
+                context->promise.set_value(index);
+            }
+        });
+    }
+    return result;
+}
+
+} // concurrency
+} // cpp
@@ -4,22 +4,22 @@
 #pragma once
 
 #include <atomic>
-#include <condition_variable>
-#include <initializer_list>
-#include <mutex>
-#include <cpplib/types/non_copyable.h>
-#include <cpplib/types/scope_guard.h>
+#include <chrono>
+#include <cstdint>
+#include "details/futex.h"
 
 namespace cpp
 {
 namespace concurrency
 {
 
+// Auto reset event: a wait consumes the signal. Waiting sleeps on a futex word (details/futex.h),
+// signal() only makes the system call when somebody is waiting.
 class Signal
 {
 public:
     Signal() :
-        m_value{false}
+        m_value{ 0 }
     {
     };
 
@@ -27,41 +27,53 @@ public:
 
     void signal() noexcept
     {
-        m_value = true;
-        m_value_changed.notify_all();
+        // the value is set before the waiters are counted, a waiter registers before it checks
+        // the value: either the waiter sees the signal or the signal sees the waiter
+        if ((m_value.exchange(1, std::memory_order_seq_cst) == 0) && (m_waiters.load(std::memory_order_seq_cst) != 0))
+        {
+            details::futex_wake_all(m_value);
+        }
     }
 
     void wait() const
     {
-        std::unique_lock<std::mutex> lock(m_value_mutex);
-        SCOPE_GUARD([this]() { m_value = false; });
-        auto pred = [this] { return m_value; };
-
-        if (pred())
+        while (!try_wait_for(std::chrono::hours(24)))
         {
-            return ;
         }
-
-        m_value_changed.wait(lock);
     }
 
     const bool try_wait_for(const std::chrono::steady_clock::duration& duration) const noexcept
     {
-        std::unique_lock<std::mutex> lock(m_value_mutex);
-        SCOPE_GUARD([this]() { m_value = false; });
-        auto pred = [this] { return m_value; };
-
-        if (pred())
+        if (m_value.exchange(0, std::memory_order_acquire) != 0)
         {
             return true;
         }
-        return m_value_changed.wait_for(lock, duration, pred);
+
+        auto now = std::chrono::steady_clock::now();
+        auto deadline = (duration < std::chrono::steady_clock::time_point::max() - now) ? (now + duration) : std::chrono::steady_clock::time_point::max();
+        m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        auto signalled = false;
+        for (;;)
+        {
+            if (m_value.exchange(0, std::memory_order_seq_cst) != 0)
+            {
+                signalled = true;
+                break;
+            }
+            now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+            {
+                break;
+            }
+            details::futex_wait(m_value, 0, deadline - now);
+        }
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+        return signalled;
     }
 
 private:
-    mutable std::mutex m_value_mutex;
-    mutable std::condition_variable m_value_changed;
-    mutable bool m_value;
+    mutable std::atomic<std::uint32_t> m_value;
+    mutable std::atomic<std::uint32_t> m_waiters{ 0 };
 };
 
 } // concurrency
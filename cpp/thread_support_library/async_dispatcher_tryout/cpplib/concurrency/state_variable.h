@@ -4,9 +4,9 @@
 #pragma once
 
 #include <atomic>
-#include <condition_variable>
+#include <chrono>
+#include <cstdint>
 #include <initializer_list>
-#include <mutex>
 
 #include <cpplib/units/time.h>
 #include <cpplib/exceptions/timeout_exception.h>
@@ -14,6 +14,7 @@
 #include <cpplib/traits/static_asserts.h>
 #include <cpplib/types/non_copyable.h>
 #include <cpplib/types/non_moveable.h>
+#include "details/futex.h"
 
 namespace cpp
 {
@@ -22,11 +23,15 @@ namespace concurrency
 
 static constexpr auto max_wait_duration = 24_hours;
 
+// Reads are a single atomic load. Waiters sleep on a futex word (details/futex.h) that is bumped
+// by every change; a change only makes the system call when somebody is waiting.
 template<typename T>
 class StateVariable final:
     public NonMoveable
 {
 public:
+    static_assert(std::atomic<T>::is_always_lock_free, "the value must fit in a lock free atomic");
+
     StateVariable() : 
         m_value{}
     {
@@ -42,17 +47,13 @@ public:
     
     void set(const T& value) noexcept
     {
-        {
-            std::unique_lock<std::mutex> lock(m_value_mutex);
-            m_value = value;
-        }
-        m_value_changed.notify_all();
+        m_value.store(value, std::memory_order_seq_cst);
+        wake_waiters();
     }
 
-    NO_DISCARD constexpr T get() const noexcept
+    NO_DISCARD T get() const noexcept
     {
-        std::unique_lock<std::mutex> lock(m_value_mutex);
-        return m_value;
+        return m_value.load(std::memory_order_acquire);
     }
 
     void operator=(const T& value) noexcept
@@ -60,13 +61,12 @@ public:
         set(value);
     }
 
-    NO_DISCARD constexpr bool operator==(const T& value) const noexcept
+    NO_DISCARD bool operator==(const T& value) const noexcept
     {
-        std::unique_lock<std::mutex> lock(m_value_mutex);
-        return (m_value == value);
+        return (get() == value);
     }
 
-    NO_DISCARD constexpr bool operator!=(const T& value) const
+    NO_DISCARD bool operator!=(const T& value) const
     {
         return !operator==(value);
     }
@@ -78,17 +78,10 @@ public:
 
     const bool try_wait_for(const T& value, const std::chrono::steady_clock::duration& duration) const noexcept
     {
-        auto pred = [this, value]
+        return wait_until([value](const T& current)
         {
-            return (m_value == value);
-        };
-
-        std::unique_lock<std::mutex> lock(m_value_mutex);
-        if (pred())
-        {
-            return true;
-        }
-        return m_value_changed.wait_for(lock, duration, pred);
+            return (current == value);
+        }, duration);
     }
 
     void wait_for(const T& value, const std::chrono::steady_clock::duration& duration) const
@@ -109,50 +102,22 @@ public:
 
     const bool try_wait_for_any(const std::initializer_list<T>& values, const std::chrono::steady_clock::duration& duration) const noexcept
     {
-        auto pred = [this, &values]
+        return wait_until([&values](const T& current)
         {
             for (auto value : values)
             {
-                if (value == m_value)
+                if (value == current)
                 {
                     return true;
                 }
             }
             return false;
-        };
-
-        std::unique_lock<std::mutex> lock(m_value_mutex);
-
-        if (pred())
-        {
-            return true;
-        }
-
-        return m_value_changed.wait_for(lock, duration, pred);
+        }, duration);
     }
 
     const bool try_wait_for_any(const std::initializer_list<T>& values) const noexcept
     {
-        auto pred = [this, &values]
-        {
-            for (auto value : values)
-            {
-                if (value == m_value)
-                {
-                    return true;
-                }
-            }
-            return false;
-        };
-
-        std::unique_lock<std::mutex> lock(m_value_mutex);
-
-        if (pred())
-        {
-            return true;
-        }
-
-        return m_value_changed.wait(lock, pred);
+        return try_wait_for_any(values, std::chrono::steady_clock::duration::max());
     }
 
     void wait_for_any(const std::initializer_list<T>& values, const std::chrono::steady_clock::duration& duration) const
@@ -173,20 +138,59 @@ public:
 
     void set_if_in(T if_state, T target_state)
     {
+        if (m_value.compare_exchange_strong(if_state, target_state, std::memory_order_seq_cst))
+        {
+            wake_waiters();
+        }
+    }
+
+private:
+    // a waiter registers before it reads the generation and the value, the value is stored before the
+    // waiters are counted: either the waiter sees the new value or the change sees the waiter
+    void wake_waiters() noexcept
+    {
+        if (m_waiters.load(std::memory_order_seq_cst) != 0)
         {
-            std::unique_lock<std::mutex> lock(m_value_mutex);
-            if (m_value == if_state)
+            m_generation.fetch_add(1, std::memory_order_seq_cst);
+            details::futex_wake_all(m_generation);
+        }
+    }
+
+    template<typename Pred>
+    bool wait_until(Pred&& pred, const std::chrono::steady_clock::duration& duration) const noexcept
+    {
+        if (pred(m_value.load(std::memory_order_acquire)))
+        {
+            return true;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        auto deadline = (duration < std::chrono::steady_clock::time_point::max() - now) ? (now + duration) : std::chrono::steady_clock::time_point::max();
+
+        m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        auto satisfied = false;
+        for (;;)
+        {
+            auto generation = m_generation.load(std::memory_order_seq_cst);
+            if (pred(m_value.load(std::memory_order_seq_cst)))
             {
-                m_value = target_state;
+                satisfied = true;
+                break;
             }
+            now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+            {
+                break;
+            }
+            details::futex_wait(m_generation, generation, deadline - now);
         }
-        m_value_changed.notify_all();
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+        return satisfied;
     }
 
-private:
-    mutable std::mutex m_value_mutex;
-    mutable std::condition_variable m_value_changed;
     std::atomic<T> m_value;
+    mutable std::atomic<std::uint32_t> m_generation{ 0 };
+    mutable std::atomic<std::uint32_t> m_waiters{ 0 };
 };
 
 } // concurrency
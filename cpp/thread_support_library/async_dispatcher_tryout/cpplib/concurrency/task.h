@@ -4,9 +4,12 @@
 #pragma once
 
 #include <future>
+#include <memory>
 #include <string>
 #include <cpplib/link_cpplib.h>
+#include <cpplib/concurrency/cancellation_token.h>
 #include <cpplib/concurrency/injected_thread_itf.h>
+#include <cpplib/performance/tracer.h>
 #include <cpplib/exceptions/timeout_exception.h>
 #include <cpplib/exceptions/cancelled_exception.h>
 #include <cpplib/exceptions/invalid_state_exception.h>
@@ -16,11 +19,11 @@
 #include <cpplib/types/non_copyable.h>
 #include <cpplib/types/non_moveable.h>
 #include <cpplib/types/null_object.h>
-#include <cpplib/types/string_cast.h>
 #include <cpplib/concurrency/state_variable.h>
 #include <cpplib/types/scope_guard.h>
 #include <cpplib/types/cpp_assert.h>
 #include <cpplib/units/time.h>
+#include "details/task_thread_pool.h"
 
 namespace cpp
 {
@@ -37,7 +40,60 @@ struct TaskSignalValue
     static const TaskSignalValueType Cancel = 1;
 };
 
-using TaskSignal = StateVariable<TaskSignalValueType>;
+// the cancellation token of a task, checking it takes no lock. Still compares against TaskSignalValue
+// like the StateVariable it used to be.
+class TaskSignal :
+    public CancellationToken
+{
+public:
+    TaskSignal() noexcept = default;
+
+    explicit TaskSignal(const CancellationToken& token) noexcept :
+        CancellationToken(token)
+    {
+    }
+
+    NO_DISCARD TaskSignalValueType get() const noexcept
+    {
+        if (is_cancelled())
+        {
+            return TaskSignalValue::Cancel;
+        }
+        return TaskSignalValue::None;
+    }
+
+    operator TaskSignalValueType() const noexcept
+    {
+        return get();
+    }
+
+    NO_DISCARD bool operator==(TaskSignalValueType value) const noexcept
+    {
+        return get() == value;
+    }
+
+    NO_DISCARD bool operator!=(TaskSignalValueType value) const noexcept
+    {
+        return get() != value;
+    }
+
+    bool try_wait_for(TaskSignalValueType value, const std::chrono::steady_clock::duration& duration) const
+    {
+        if (value == TaskSignalValue::None)
+        {
+            return !is_cancelled();
+        }
+        return CancellationToken::try_wait_for(duration);
+    }
+
+    void wait_for(TaskSignalValueType value, const std::chrono::steady_clock::duration& duration) const
+    {
+        if (!try_wait_for(value, duration))
+        {
+            throw timeout_exception();
+        }
+    }
+};
 
 //-----------------------------------------------------------------------------------------------------------------------------------------
 
@@ -135,6 +191,7 @@ public:
     template<typename Fn>
     explicit Task(const std::wstring& description, TaskReportingItf& reporting, Fn&& fn) :
         m_cancellation_timeout{ cpp::max_timeout },
+        m_signal{ m_cancellation.token() },
         m_state{ TaskState::Idle },
         m_fn{ fn },
         m_description{ description },
@@ -145,6 +202,7 @@ public:
     template<typename Fn>
     explicit Task(const std::wstring& description, TaskReportingItf& reporting, std::chrono::steady_clock::duration cancellation_timeout, Fn&& fn) :
         m_cancellation_timeout{ cancellation_timeout },
+        m_signal{ m_cancellation.token() },
         m_state{ TaskState::Idle },
         m_fn{ fn },
         m_description{ description },
@@ -162,6 +220,12 @@ public:
         {
             m_reporting.report_cancellation_timeout(m_description);
         }
+
+        // the pool thread still uses this task until the function has returned
+        if (m_future.valid())
+        {
+            m_future.wait();
+        }
     }
 
     virtual void start() override
@@ -171,12 +235,13 @@ public:
             throw invalid_state_exception();
         }
 
-        m_state.set(TaskState::Starting);
+        set_state(TaskState::Starting);
 
-        m_future = std::async(std::launch::async, [this]
+        // runs on a pooled thread instead of a new thread per task (std::async)
+        auto job = std::make_shared<std::packaged_task<RetvalType()>>([this]
         {
             m_reporting.report_task_started(m_description);
-            m_state.set(TaskState::Running);
+            set_state(TaskState::Running);
             try
             {
                 TaskResult<RetvalType> result([this]
@@ -185,33 +250,35 @@ public:
                 });
 
                 // function did not cancel itself
-                if (m_signal == TaskSignalValue::Cancel)
+                if (m_cancellation.is_cancelled())
                 {
                     throw cancelled_exception();
                 }
                 else
                 {
                     m_reporting.report_task_finished(m_description);
-                    m_state.set(TaskState::Stopped);
+                    set_state(TaskState::Stopped);
                 }
 
                 return result.get();
             }
             catch (const cancelled_exception&)
             {
-                m_state.set(TaskState::Cancelled);
+                set_state(TaskState::Cancelled);
                 m_reporting.report_task_cancelled(m_description);
                 throw;
             }
             catch (...)
             {
                 m_reporting.report_task_failed(m_description);
-                m_state.set(TaskState::Failed);
+                set_state(TaskState::Failed);
                 throw;
             }
         });
+        m_future = job->get_future();
+        TaskThreadPool::instance().submit([job] { (*job)(); });
 
-        m_state.wait_for_any({ TaskState::Running, TaskState::Cancelled, TaskState::Failed });
+        m_state.wait_for_any({ TaskState::Running, TaskState::Cancelling, TaskState::Cancelled, TaskState::Failed, TaskState::Stopped });
     }
 
     virtual RetvalType get() override
@@ -221,15 +288,41 @@ public:
 
     virtual void cancel() override
     {
-        if (m_state == TaskState::Running)
+        // Cancelling stays until the function has returned, a cancel that timed out is waited for again
+        if ((m_state == TaskState::Running) || (m_state == TaskState::Cancelling))
         {
-            m_signal.set(TaskSignalValue::Cancel);
+            m_state.set_if_in(TaskState::Running, TaskState::Cancelling);
+            performance::trace(performance::TracePhase::instant, "task", state_name(TaskState::Cancelling), 0, reinterpret_cast<std::uintptr_t>(this));
+            m_cancellation.cancel();
             m_state.wait_for_any({ TaskState::Cancelled, TaskState::Stopped }, m_cancellation_timeout);
         }
     }
 
 private:
+    static const char* state_name(TaskState state) noexcept
+    {
+        switch (state)
+        {
+        case TaskState::Idle: return "Idle";
+        case TaskState::Starting: return "Starting";
+        case TaskState::Running: return "Running";
+        case TaskState::Cancelling: return "Cancelling";
+        case TaskState::Cancelled: return "Cancelled";
+        case TaskState::Failed: return "Failed";
+        case TaskState::Stopped: return "Stopped";
+        }
+        return "";
+    }
+
+    // state changes are traced with the address of the task, to tell concurrent tasks apart
+    void set_state(TaskState state)
+    {
+        m_state.set(state);
+        performance::trace(performance::TracePhase::instant, "task", state_name(state), 0, reinterpret_cast<std::uintptr_t>(this));
+    }
+
     std::chrono::steady_clock::duration m_cancellation_timeout;
+    CancellationSource m_cancellation;
     TaskSignal m_signal;
     StateVariable<TaskState> m_state;
     std::function<RetvalType(const TaskSignal&)> m_fn;
@@ -247,12 +340,32 @@ NO_DISCARD std::shared_ptr<TaskItf<RetvalType>> make_task(
     return std::make_unique<details::Task<RetvalType>>(description, reporting_itf, fn);
 }
 
-template<typename RetvalType, typename TaskSignalType>
+template<typename RetvalType>
 NO_DISCARD std::shared_ptr<TaskItf<RetvalType>> make_task(
     const std::wstring& description,
     TaskReportingItf& reporting_itf,
     const std::chrono::steady_clock::duration& cancellation_timeout,
-    const std::function<RetvalType(const StateVariable<TaskSignalType>& signal)>& fn)
+    const std::function<RetvalType(const TaskSignal& signal)>& fn)
+{
+    return std::make_unique<details::Task<RetvalType>>(description, reporting_itf, cancellation_timeout, fn);
+}
+
+// for functions taking the plain token, e.g. to pass it on to the dispatcher or to link child tokens
+template<typename RetvalType>
+NO_DISCARD std::shared_ptr<TaskItf<RetvalType>> make_task(
+    const std::wstring& description,
+    TaskReportingItf& reporting_itf,
+    const std::function<RetvalType(const CancellationToken& token)>& fn)
+{
+    return std::make_unique<details::Task<RetvalType>>(description, reporting_itf, fn);
+}
+
+template<typename RetvalType>
+NO_DISCARD std::shared_ptr<TaskItf<RetvalType>> make_task(
+    const std::wstring& description,
+    TaskReportingItf& reporting_itf,
+    const std::chrono::steady_clock::duration& cancellation_timeout,
+    const std::function<RetvalType(const CancellationToken& token)>& fn)
 {
     return std::make_unique<details::Task<RetvalType>>(description, reporting_itf, cancellation_timeout, fn);
 }
@@ -381,7 +494,10 @@ NO_DISCARD auto start_task(const std::wstring& description, TaskReportingItf& re
     return task;
 }
 
-void ThrowIfCancelled(const TaskSignal& signal);
+inline void ThrowIfCancelled(const CancellationToken& token)
+{
+    token.throw_if_cancelled();
+}
 
 } // concurrency
 } // cpp
@@ -0,0 +1,151 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#include <cpplib/win32/win_api.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace cpp
+{
+namespace concurrency
+{
+
+// Where the threads of a dispatcher, a dispatcher pool or a distributor run. The default leaves
+// them to the scheduler, unnamed.
+struct ThreadPlacement
+{
+    // thread i runs on the CPUs of cpu_sets[i % cpu_sets.size()], no pinning when empty.
+    // A set of CPUs rather than one CPU, so a thread can be kept on a NUMA node, see numa_node_cpus.
+    std::vector<std::vector<unsigned int>> cpu_sets;
+
+    // thread i of a pool is called name + i, a single dispatcher thread name. Linux keeps 15 characters.
+    std::string name;
+
+    // the per-worker queues of a pool are allocated by the worker after it has been pinned, so the
+    // memory comes from its NUMA node (first touch) instead of the node of the constructing thread
+    bool first_touch = false;
+};
+
+// the CPUs of a NUMA node, empty when the node does not exist or cannot be queried
+inline std::vector<unsigned int> numa_node_cpus(unsigned int node)
+{
+    std::vector<unsigned int> cpus;
+#ifdef _WIN32
+    ULONGLONG mask = 0;
+    if ((node <= 0xff) && ::GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask))
+    {
+        for (unsigned int cpu = 0; cpu < 64; ++cpu)
+        {
+            if ((mask & (1ull << cpu)) != 0)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#elif defined(__linux__)
+    // e.g. "0-3,8-11"
+    std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string range;
+    while (std::getline(cpulist, range, ','))
+    {
+        std::istringstream bounds(range);
+        unsigned int first = 0;
+        unsigned int last = 0;
+        char dash = 0;
+        if (!(bounds >> first))
+        {
+            continue;
+        }
+        last = (bounds >> dash >> last) ? last : first;
+        for (auto cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+#else
+    (void)node;
+#endif
+    return cpus;
+}
+
+// names the calling thread, for debuggers, profilers and top -H. Best effort, failures are ignored.
+inline void set_current_thread_name(const std::string& name) noexcept
+{
+#ifdef _WIN32
+    // windows 10 1607 and later
+    ::SetThreadDescription(::GetCurrentThread(), std::wstring(name.begin(), name.end()).c_str());
+#elif defined(__linux__)
+    ::pthread_setname_np(::pthread_self(), name.substr(0, 15).c_str());
+#else
+    (void)name;
+#endif
+}
+
+namespace details
+{
+
+// called by thread thread_index of number_of_threads itself before it does anything else.
+// Throws std::system_error when the thread cannot be pinned, e.g. to a CPU outside of the process' affinity.
+inline void apply_thread_placement(const ThreadPlacement& placement, std::size_t thread_index, std::size_t number_of_threads)
+{
+    if (!placement.name.empty())
+    {
+        set_current_thread_name((number_of_threads == 1) ? placement.name : (placement.name + std::to_string(thread_index)));
+    }
+
+    if (placement.cpu_sets.empty())
+    {
+        return;
+    }
+    const auto& cpus = placement.cpu_sets[thread_index % placement.cpu_sets.size()];
+    if (cpus.empty())
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    // processor group 0 only
+    DWORD_PTR mask = 0;
+    for (auto cpu : cpus)
+    {
+        if (cpu < 8 * sizeof(DWORD_PTR))
+        {
+            mask |= DWORD_PTR(1) << cpu;
+        }
+    }
+    if (::SetThreadAffinityMask(::GetCurrentThread(), mask) == 0)
+    {
+        throw std::system_error(static_cast<int>(::GetLastError()), std::system_category(), "SetThreadAffinityMask");
+    }
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+    if (auto error = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set))
+    {
+        throw std::system_error(error, std::system_category(), "pthread_setaffinity_np");
+    }
+#endif
+}
+
+} // details
+} // concurrency
+} // cpp
@@ -18,10 +18,20 @@ public:
     {
     }
 
+    // std::exception only takes a message on msvc
     cancelled_exception(const std::string& str) :
-        std::exception(str.c_str())
+        std::exception(),
+        m_what(str)
     {
     }
+
+    virtual const char* what() const noexcept override
+    {
+        return m_what.empty() ? std::exception::what() : m_what.c_str();
+    }
+
+private:
+    std::string m_what;
 };
 
 } // cpp
\ No newline at end of file
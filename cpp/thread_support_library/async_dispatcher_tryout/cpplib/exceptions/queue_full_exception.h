@@ -0,0 +1,17 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <stdexcept>
+
+namespace cpp
+{
+
+// a task was rejected because the queue of a bounded dispatcher was full
+class queue_full_exception :
+    public std::exception
+{
+};
+
+} // cpp
@@ -3,6 +3,6 @@
 
 #pragma once
 
-#ifndef COMPILING_CPPLIB_PERF_COUNTERS
+#if defined(_MSC_VER) && !defined(COMPILING_CPPLIB_PERF_COUNTERS)
 #pragma comment(lib,"cpplibperfcounters.lib")
 #endif
@@ -3,8 +3,11 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <cpplib/concurrency/dispatcher_priority.h>
 #include <cpplib/types/interface.h>
 #include <cpplib/types/null_object.h>
 #include <cpplib/types/pimpl_ptr.h>
@@ -14,7 +17,9 @@ namespace cpp
 namespace performance
 {
 
-#ifdef COMPILING_CPPLIB_PERF_COUNTERS
+#ifndef _WIN32
+#define CPPLIB_PERF_COUNTERS_EXPORT
+#elif defined(COMPILING_CPPLIB_PERF_COUNTERS)
 #define CPPLIB_PERF_COUNTERS_EXPORT __declspec(dllexport)
 #else
 #define CPPLIB_PERF_COUNTERS_EXPORT __declspec(dllimport)
@@ -29,6 +34,16 @@ class CpplibPerformanceImpl;
 
 //-----------------------------------------------------------------------------------------------------------------------------------------
 
+// a task whose queue latency plus execution time exceeded the required response time of its dispatcher
+struct DeadlineViolation
+{
+    const char* task;   // type name of the callable
+    concurrency::DispatcherPriority priority;
+    std::chrono::steady_clock::duration queue_latency;
+    std::chrono::steady_clock::duration execution_time;
+    std::size_t queue_depth;
+};
+
 class DispatcherPerformanceItf :
     public Interface
 {
@@ -36,6 +51,22 @@ public:
     virtual void increment_number_of_calls_queued() = 0;
     virtual void report_queue_size(std::uint32_t) = 0;
     virtual void report_latency_in_milliseconds(std::uint32_t) = 0;
+
+    // latency of one priority lane, reported next to the overall latency.
+    // not pure so existing counters keep working, they just don't split the latency per lane.
+    virtual void report_latency_in_milliseconds(concurrency::DispatcherPriority, std::uint32_t) {}
+
+    // only reported by dispatchers created with a required response time
+    virtual void report_deadline_violation(const DeadlineViolation&) {}
+
+    // full resolution timing of every task: time from queueing until start, and time it ran
+    virtual void report_queue_latency(std::chrono::nanoseconds) {}
+    virtual void report_execution_time(std::chrono::nanoseconds) {}
+
+    // only reported by dispatchers with a bounded queue: the queue size against the capacity after every post,
+    // and every task that met a full queue (a blocked producer, a failed, dropped or coalesced task)
+    virtual void report_queue_occupancy(std::uint32_t, std::uint32_t) {}
+    virtual void report_queue_full(concurrency::QueueFullPolicy) {}
 };
 
 class NullDispatcherPerformance :
@@ -45,6 +76,12 @@ public:
     virtual void increment_number_of_calls_queued() override {}
     virtual void report_queue_size(std::uint32_t) override {}
     virtual void report_latency_in_milliseconds(std::uint32_t) override {}
+    virtual void report_latency_in_milliseconds(concurrency::DispatcherPriority, std::uint32_t) override {}
+    virtual void report_deadline_violation(const DeadlineViolation&) override {}
+    virtual void report_queue_latency(std::chrono::nanoseconds) override {}
+    virtual void report_execution_time(std::chrono::nanoseconds) override {}
+    virtual void report_queue_occupancy(std::uint32_t, std::uint32_t) override {}
+    virtual void report_queue_full(concurrency::QueueFullPolicy) override {}
 };
 
 //-----------------------------------------------------------------------------------------------------------------------------------------
@@ -76,4 +113,9 @@ private:
 };
 
 }
-}
\ No newline at end of file
+}
+
+#ifndef _WIN32
+// posix implementation of CpplibPerformance, exports the counters through shared memory
+#include <cpplib/performance/shared_memory_performance.h>
+#endif
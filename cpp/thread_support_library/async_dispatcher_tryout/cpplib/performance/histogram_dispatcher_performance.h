@@ -0,0 +1,102 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <memory>
+#include <cpplib/performance/cpplib_performance.h>
+#include <cpplib/performance/latency_histogram.h>
+
+namespace cpp
+{
+namespace performance
+{
+
+// Collects queue latency and execution time of every dispatcher task in histograms,
+// everything else is passed on to the wrapped counters (e.g. the windows performance counters).
+// Snapshots can be taken from any thread while the dispatcher runs:
+//
+//   auto histograms = std::make_shared<HistogramDispatcherPerformance>();
+//   cpp::concurrency::Dispatcher dispatcher(required_response_time, histograms);
+//   ...
+//   auto latency = histograms->queue_latency().snapshot();   // latency.p99, latency.p999, ...
+class HistogramDispatcherPerformance final :
+    public DispatcherPerformanceItf
+{
+public:
+    explicit HistogramDispatcherPerformance(std::shared_ptr<DispatcherPerformanceItf> counters = NullDispatcherPerformance::shared()) :
+        m_counters{ std::move(counters) }
+    {
+    }
+
+    virtual void increment_number_of_calls_queued() override
+    {
+        m_counters->increment_number_of_calls_queued();
+    }
+
+    virtual void report_queue_size(std::uint32_t size) override
+    {
+        m_counters->report_queue_size(size);
+    }
+
+    virtual void report_latency_in_milliseconds(std::uint32_t latency) override
+    {
+        m_counters->report_latency_in_milliseconds(latency);
+    }
+
+    virtual void report_latency_in_milliseconds(concurrency::DispatcherPriority priority, std::uint32_t latency) override
+    {
+        m_counters->report_latency_in_milliseconds(priority, latency);
+    }
+
+    virtual void report_deadline_violation(const DeadlineViolation& violation) override
+    {
+        m_counters->report_deadline_violation(violation);
+    }
+
+    virtual void report_queue_latency(std::chrono::nanoseconds latency) override
+    {
+        m_queue_latency.record(latency);
+        m_counters->report_queue_latency(latency);
+    }
+
+    virtual void report_execution_time(std::chrono::nanoseconds duration) override
+    {
+        m_execution_time.record(duration);
+        m_counters->report_execution_time(duration);
+    }
+
+    virtual void report_queue_occupancy(std::uint32_t size, std::uint32_t capacity) override
+    {
+        m_counters->report_queue_occupancy(size, capacity);
+    }
+
+    virtual void report_queue_full(concurrency::QueueFullPolicy policy) override
+    {
+        m_counters->report_queue_full(policy);
+    }
+
+    const LatencyHistogram& queue_latency() const noexcept
+    {
+        return m_queue_latency;
+    }
+
+    const LatencyHistogram& execution_time() const noexcept
+    {
+        return m_execution_time;
+    }
+
+    void reset() noexcept
+    {
+        m_queue_latency.reset();
+        m_execution_time.reset();
+    }
+
+private:
+    std::shared_ptr<DispatcherPerformanceItf> m_counters;
+    LatencyHistogram m_queue_latency;
+    LatencyHistogram m_execution_time;
+};
+
+} // performance
+} // cpp
@@ -0,0 +1,156 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cpplib/types/non_copyable.h>
+
+namespace cpp
+{
+namespace performance
+{
+
+struct HistogramSnapshot
+{
+    std::uint64_t count;
+    std::chrono::nanoseconds min;
+    std::chrono::nanoseconds max;
+    std::chrono::nanoseconds p50;
+    std::chrono::nanoseconds p99;
+    std::chrono::nanoseconds p999;
+};
+
+// Lock-free HDR style histogram of durations in nanoseconds.
+//
+// Values are grouped by their highest set bit, every power of two range is split in 32 linear
+// sub buckets, so a reported percentile is at most ~3% above the real value over the whole range
+// of 1 ns to centuries. Recording is one relaxed atomic increment (plus min/max updates that rarely
+// write), snapshots can be taken from any thread while recording goes on.
+class LatencyHistogram final :
+    public NonCopyable
+{
+public:
+    void record(std::chrono::nanoseconds duration) noexcept
+    {
+        auto value = (duration.count() > 0) ? static_cast<std::uint64_t>(duration.count()) : 0;
+        m_buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+
+        auto min = m_min.load(std::memory_order_relaxed);
+        while ((value < min) && !m_min.compare_exchange_weak(min, value, std::memory_order_relaxed))
+        {
+        }
+        auto max = m_max.load(std::memory_order_relaxed);
+        while ((value > max) && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // percentiles are the upper bound of the bucket holding them, clamped to the recorded maximum.
+    // recording during the snapshot may make it slightly inconsistent, never invalid.
+    HistogramSnapshot snapshot() const noexcept
+    {
+        std::array<std::uint64_t, number_of_buckets> counts;
+        std::uint64_t total = 0;
+        for (std::size_t index = 0; index < number_of_buckets; ++index)
+        {
+            counts[index] = m_buckets[index].load(std::memory_order_relaxed);
+            total += counts[index];
+        }
+
+        HistogramSnapshot snapshot{};
+        snapshot.count = total;
+        if (total == 0)
+        {
+            return snapshot;
+        }
+
+        auto max = m_max.load(std::memory_order_relaxed);
+        snapshot.min = std::chrono::nanoseconds(m_min.load(std::memory_order_relaxed));
+        snapshot.max = std::chrono::nanoseconds(max);
+        snapshot.p50 = std::chrono::nanoseconds(percentile(counts, total, 500, max));
+        snapshot.p99 = std::chrono::nanoseconds(percentile(counts, total, 990, max));
+        snapshot.p999 = std::chrono::nanoseconds(percentile(counts, total, 999, max));
+        return snapshot;
+    }
+
+    // not atomic with respect to concurrent recording, samples recorded meanwhile may survive
+    void reset() noexcept
+    {
+        for (auto& bucket : m_buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        m_min.store(UINT64_MAX, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr std::size_t sub_bucket_bits = 5;
+    static constexpr std::size_t sub_buckets = std::size_t{ 1 } << sub_bucket_bits;
+    // values below sub_buckets have a bucket each, every next power of two gets sub_buckets buckets
+    static constexpr std::size_t number_of_buckets = sub_buckets + (64 - sub_bucket_bits) * sub_buckets;
+
+    static std::size_t highest_bit(std::uint64_t value) noexcept
+    {
+        std::size_t bit = 0;
+        while (value >>= 1)
+        {
+            ++bit;
+        }
+        return bit;
+    }
+
+    static std::size_t bucket_index(std::uint64_t value) noexcept
+    {
+        if (value < sub_buckets)
+        {
+            return static_cast<std::size_t>(value);
+        }
+        auto exponent = highest_bit(value);
+        auto sub_bucket = static_cast<std::size_t>(value >> (exponent - sub_bucket_bits)) & (sub_buckets - 1);
+        return sub_buckets + (exponent - sub_bucket_bits) * sub_buckets + sub_bucket;
+    }
+
+    // largest value that falls in the bucket
+    static std::uint64_t bucket_upper_bound(std::size_t index) noexcept
+    {
+        if (index < sub_buckets)
+        {
+            return index;
+        }
+        auto exponent = (index - sub_buckets) / sub_buckets + sub_bucket_bits;
+        auto sub_bucket = (index - sub_buckets) % sub_buckets;
+        auto shift = exponent - sub_bucket_bits;
+        auto lower = (static_cast<std::uint64_t>(sub_buckets + sub_bucket)) << shift;
+        return lower + ((std::uint64_t{ 1 } << shift) - 1);
+    }
+
+    static std::uint64_t percentile(const std::array<std::uint64_t, number_of_buckets>& counts, std::uint64_t total, std::uint64_t per_mille, std::uint64_t max) noexcept
+    {
+        // rank of the sample at the percentile, rounded up
+        auto rank = (total * per_mille + 999) / 1000;
+        std::uint64_t seen = 0;
+        for (std::size_t index = 0; index < number_of_buckets; ++index)
+        {
+            seen += counts[index];
+            if ((seen >= rank) && (counts[index] > 0))
+            {
+                auto bound = bucket_upper_bound(index);
+                return (bound < max) ? bound : max;
+            }
+        }
+        return max;
+    }
+
+    std::array<std::atomic<std::uint64_t>, number_of_buckets> m_buckets{};
+    std::atomic<std::uint64_t> m_min{ UINT64_MAX };
+    std::atomic<std::uint64_t> m_max{ 0 };
+};
+
+} // performance
+} // cpp
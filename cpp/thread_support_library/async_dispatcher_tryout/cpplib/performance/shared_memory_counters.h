@@ -0,0 +1,265 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <cpplib/types/non_copyable.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Layout of the memory mapped file in which the posix backend of CpplibPerformance publishes
+// dispatcher counters. The file is shared with external reader tools (performance_counter_reader),
+// both sides only use lock-free atomics on it, a reader never blocks a dispatcher.
+//
+//   CounterFileHeader | CounterSlot[slot_count]
+//
+// Every dispatcher instance owns one slot. Counters written by producer threads and by the
+// dispatcher thread(s) are on separate cache lines, so readers and the two kinds of writers
+// do not bounce a line between them more than needed.
+
+namespace cpp
+{
+namespace performance
+{
+namespace shared_memory
+{
+
+constexpr std::uint64_t file_magic = 0x5352544E43505043;   // "CPPCNTRS"
+constexpr std::uint32_t file_version = 2;
+constexpr std::size_t cache_line_size = 64;
+constexpr std::size_t max_instance_name_size = 56;
+constexpr std::uint32_t default_slot_count = 256;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "shared memory counters require lock-free 64 bit atomics");
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "shared memory counters require lock-free 32 bit atomics");
+
+enum class SlotState : std::uint32_t
+{
+    free,
+    claimed,    // owner is writing the name
+    live
+};
+
+struct alignas(cache_line_size) CounterFileHeader
+{
+    std::atomic<std::uint64_t> magic;   // written last, a reader sees a complete header once it is set
+    std::uint32_t version;
+    std::uint32_t slot_count;
+};
+
+struct alignas(cache_line_size) CounterSlot
+{
+    // identity, written once by the owner before the slot goes live
+    std::atomic<std::uint32_t> state;
+    std::atomic<std::uint32_t> generation;      // incremented on every claim, readers detect a reused slot
+    char instance_name[max_instance_name_size];
+
+    // written by producer threads
+    alignas(cache_line_size) std::atomic<std::uint64_t> calls_queued;
+    std::atomic<std::uint32_t> queue_size;
+    std::atomic<std::uint32_t> queue_capacity;      // 0 when unbounded
+    std::atomic<std::uint64_t> queue_full[4];       // per QueueFullPolicy
+
+    // written by the dispatcher thread(s)
+    alignas(cache_line_size) std::atomic<std::uint64_t> tasks_run;
+    std::atomic<std::uint64_t> queue_latency_ns_total;
+    std::atomic<std::uint64_t> execution_time_ns_total;
+    std::atomic<std::uint64_t> deadline_violations;
+    std::atomic<std::uint32_t> latency_ms;
+    std::atomic<std::uint32_t> max_latency_ms;
+    std::atomic<std::uint32_t> lane_latency_ms[3];
+};
+
+static_assert(sizeof(CounterSlot) == 3 * cache_line_size, "counter slot layout changed, update file_version");
+
+inline std::size_t file_size(std::uint32_t slot_count) noexcept
+{
+    return sizeof(CounterFileHeader) + slot_count * sizeof(CounterSlot);
+}
+
+#ifndef _WIN32
+
+// shared mapping of a counter file, the writer creates and initializes it, readers open it read-only
+class CounterFile final :
+    public NonCopyable
+{
+public:
+    static CounterFile create(const std::string& path, std::uint32_t slot_count = default_slot_count)
+    {
+        auto descriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (descriptor < 0)
+        {
+            throw std::runtime_error("cannot create performance counter file " + path);
+        }
+
+        auto size = file_size(slot_count);
+        if (::ftruncate(descriptor, static_cast<off_t>(size)) != 0)
+        {
+            ::close(descriptor);
+            throw std::runtime_error("cannot size performance counter file " + path);
+        }
+
+        CounterFile file(descriptor, size, PROT_READ | PROT_WRITE, path);
+        // a fresh file is zero filled: every slot is free and every counter 0
+        auto header = file.mutable_header();
+        header->version = file_version;
+        header->slot_count = slot_count;
+        header->magic.store(file_magic, std::memory_order_release);
+        file.m_owner = true;
+        return file;
+    }
+
+    static CounterFile open_read_only(const std::string& path)
+    {
+        auto descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+        {
+            throw std::runtime_error("cannot open performance counter file " + path);
+        }
+
+        struct stat status {};
+        if ((::fstat(descriptor, &status) != 0) || (static_cast<std::size_t>(status.st_size) < sizeof(CounterFileHeader)))
+        {
+            ::close(descriptor);
+            throw std::runtime_error("not a performance counter file " + path);
+        }
+
+        CounterFile file(descriptor, static_cast<std::size_t>(status.st_size), PROT_READ, path);
+        auto header = file.header();
+        if ((header->magic.load(std::memory_order_acquire) != file_magic) || (header->version != file_version) || (file_size(header->slot_count) > file.m_size))
+        {
+            throw std::runtime_error("incompatible performance counter file " + path);
+        }
+        return file;
+    }
+
+    CounterFile(CounterFile&& other) noexcept :
+        m_memory{ other.m_memory },
+        m_size{ other.m_size },
+        m_path{ std::move(other.m_path) },
+        m_owner{ other.m_owner }
+    {
+        other.m_memory = nullptr;
+        other.m_owner = false;
+    }
+
+    ~CounterFile()
+    {
+        if (m_memory != nullptr)
+        {
+            ::munmap(m_memory, m_size);
+        }
+        if (m_owner)
+        {
+            ::unlink(m_path.c_str());
+        }
+    }
+
+    const CounterFileHeader* header() const noexcept
+    {
+        return static_cast<const CounterFileHeader*>(m_memory);
+    }
+
+    std::uint32_t slot_count() const noexcept
+    {
+        return header()->slot_count;
+    }
+
+    CounterSlot& slot(std::uint32_t index) const noexcept
+    {
+        return slots()[index];
+    }
+
+    // claims a free slot for a new instance, nullptr when all slots are taken
+    CounterSlot* claim(const std::string& instance_name) const noexcept
+    {
+        for (std::uint32_t index = 0; index < slot_count(); ++index)
+        {
+            auto& candidate = slots()[index];
+            auto expected = static_cast<std::uint32_t>(SlotState::free);
+            if (candidate.state.compare_exchange_strong(expected, static_cast<std::uint32_t>(SlotState::claimed), std::memory_order_acquire))
+            {
+                reset_counters(candidate);
+                std::memset(candidate.instance_name, 0, max_instance_name_size);
+                std::memcpy(candidate.instance_name, instance_name.data(), std::min(instance_name.size(), max_instance_name_size - 1));
+                candidate.generation.fetch_add(1, std::memory_order_relaxed);
+                candidate.state.store(static_cast<std::uint32_t>(SlotState::live), std::memory_order_release);
+                return &candidate;
+            }
+        }
+        return nullptr;
+    }
+
+    static void release(CounterSlot& slot) noexcept
+    {
+        slot.state.store(static_cast<std::uint32_t>(SlotState::free), std::memory_order_release);
+    }
+
+private:
+    CounterFile(int descriptor, std::size_t size, int protection, const std::string& path) :
+        m_size{ size },
+        m_path{ path }
+    {
+        m_memory = ::mmap(nullptr, size, protection, MAP_SHARED, descriptor, 0);
+        ::close(descriptor);
+        if (m_memory == MAP_FAILED)
+        {
+            m_memory = nullptr;
+            throw std::runtime_error("cannot map performance counter file " + path);
+        }
+    }
+
+    CounterFileHeader* mutable_header() noexcept
+    {
+        return static_cast<CounterFileHeader*>(m_memory);
+    }
+
+    CounterSlot* slots() const noexcept
+    {
+        return reinterpret_cast<CounterSlot*>(static_cast<char*>(m_memory) + sizeof(CounterFileHeader));
+    }
+
+    static void reset_counters(CounterSlot& slot) noexcept
+    {
+        slot.calls_queued.store(0, std::memory_order_relaxed);
+        slot.queue_size.store(0, std::memory_order_relaxed);
+        slot.queue_capacity.store(0, std::memory_order_relaxed);
+        for (auto& count : slot.queue_full)
+        {
+            count.store(0, std::memory_order_relaxed);
+        }
+        slot.tasks_run.store(0, std::memory_order_relaxed);
+        slot.queue_latency_ns_total.store(0, std::memory_order_relaxed);
+        slot.execution_time_ns_total.store(0, std::memory_order_relaxed);
+        slot.deadline_violations.store(0, std::memory_order_relaxed);
+        slot.latency_ms.store(0, std::memory_order_relaxed);
+        slot.max_latency_ms.store(0, std::memory_order_relaxed);
+        for (auto& latency : slot.lane_latency_ms)
+        {
+            latency.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void* m_memory = nullptr;
+    std::size_t m_size;
+    std::string m_path;
+    bool m_owner = false;
+};
+
+#endif
+
+} // shared_memory
+} // performance
+} // cpp
@@ -0,0 +1,217 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <cpplib/performance/cpplib_performance.h>
+#include <cpplib/performance/shared_memory_counters.h>
+
+#ifndef _WIN32
+
+namespace cpp
+{
+namespace performance
+{
+
+// Counters of one dispatcher instance, published in its slot of a shared memory counter file.
+// Every report is a single relaxed atomic operation on the slot, nothing is ever locked.
+// Without a slot (all slots taken) the counters silently do nothing.
+class SharedMemoryDispatcherPerformance final :
+    public DispatcherPerformanceItf
+{
+public:
+    SharedMemoryDispatcherPerformance(std::shared_ptr<shared_memory::CounterFile> file, shared_memory::CounterSlot* slot) noexcept :
+        m_file{ std::move(file) },
+        m_slot{ slot }
+    {
+    }
+
+    ~SharedMemoryDispatcherPerformance()
+    {
+        if (m_slot != nullptr)
+        {
+            shared_memory::CounterFile::release(*m_slot);
+        }
+    }
+
+    virtual void increment_number_of_calls_queued() override
+    {
+        if (m_slot != nullptr)
+        {
+            m_slot->calls_queued.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    virtual void report_queue_size(std::uint32_t size) override
+    {
+        if (m_slot != nullptr)
+        {
+            m_slot->queue_size.store(size, std::memory_order_relaxed);
+        }
+    }
+
+    virtual void report_latency_in_milliseconds(std::uint32_t latency) override
+    {
+        if (m_slot != nullptr)
+        {
+            m_slot->latency_ms.store(latency, std::memory_order_relaxed);
+            auto max = m_slot->max_latency_ms.load(std::memory_order_relaxed);
+            while ((latency > max) && !m_slot->max_latency_ms.compare_exchange_weak(max, latency, std::memory_order_relaxed))
+            {
+            }
+        }
+    }
+
+    virtual void report_latency_in_milliseconds(concurrency::DispatcherPriority priority, std::uint32_t latency) override
+    {
+        if (m_slot != nullptr)
+        {
+            m_slot->lane_latency_ms[static_cast<std::size_t>(priority)].store(latency, std::memory_order_relaxed);
+        }
+    }
+
+    virtual void report_deadline_violation(const DeadlineViolation&) override
+    {
+        if (m_slot != nullptr)
+        {
+            m_slot->deadline_violations.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    virtual void report_queue_latency(std::chrono::nanoseconds latency) override
+    {
+        if (m_slot != nullptr)
+        {
+            m_slot->tasks_run.fetch_add(1, std::memory_order_relaxed);
+            m_slot->queue_latency_ns_total.fetch_add(static_cast<std::uint64_t>(latency.count()), std::memory_order_relaxed);
+        }
+    }
+
+    virtual void report_execution_time(std::chrono::nanoseconds duration) override
+    {
+        if (m_slot != nullptr)
+        {
+            m_slot->execution_time_ns_total.fetch_add(static_cast<std::uint64_t>(duration.count()), std::memory_order_relaxed);
+        }
+    }
+
+    virtual void report_queue_occupancy(std::uint32_t size, std::uint32_t capacity) override
+    {
+        if (m_slot != nullptr)
+        {
+            m_slot->queue_size.store(size, std::memory_order_relaxed);
+            m_slot->queue_capacity.store(capacity, std::memory_order_relaxed);
+        }
+    }
+
+    virtual void report_queue_full(concurrency::QueueFullPolicy policy) override
+    {
+        if (m_slot != nullptr)
+        {
+            m_slot->queue_full[static_cast<std::size_t>(policy)].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::shared_ptr<shared_memory::CounterFile> m_file;     // keeps the mapping alive as long as the slot is used
+    shared_memory::CounterSlot* m_slot;
+};
+
+//-----------------------------------------------------------------------------------------------------------------------------------------
+
+// Publishes dispatcher counters in a shared memory counter file, the file is removed again when the last counters are gone.
+// By default all instances in a process share one file, its path is taken from CPPLIB_PERF_COUNTERS_FILE,
+// or /dev/shm/cpplib_perf.<pid> when it is not set. Sample it with tools/performance_counter_reader.
+class SharedMemoryPerformance :
+    public CpplibPerformanceItf
+{
+public:
+    SharedMemoryPerformance() :
+        m_file{ process_file() }
+    {
+    }
+
+    SharedMemoryPerformance(const std::string& path, std::uint32_t slot_count) :
+        m_file{ std::make_shared<shared_memory::CounterFile>(shared_memory::CounterFile::create(path, slot_count)) }
+    {
+    }
+
+    virtual std::shared_ptr<DispatcherPerformanceItf> GetDispatcherPerformanceCounters(const std::wstring& instance_name) override
+    {
+        return std::make_shared<SharedMemoryDispatcherPerformance>(m_file, m_file->claim(narrow(instance_name)));
+    }
+
+    static std::string default_path()
+    {
+        if (auto path = std::getenv("CPPLIB_PERF_COUNTERS_FILE"))
+        {
+            return path;
+        }
+        return "/dev/shm/cpplib_perf." + std::to_string(::getpid());
+    }
+
+private:
+    static std::shared_ptr<shared_memory::CounterFile> process_file()
+    {
+        static std::mutex mutex;
+        static std::weak_ptr<shared_memory::CounterFile> shared_file;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto file = shared_file.lock();
+        if (!file)
+        {
+            file = std::make_shared<shared_memory::CounterFile>(shared_memory::CounterFile::create(default_path()));
+            shared_file = file;
+        }
+        return file;
+    }
+
+    // instance names are identifiers, anything outside ASCII is replaced
+    static std::string narrow(const std::wstring& name)
+    {
+        std::string result;
+        result.reserve(name.size());
+        for (auto character : name)
+        {
+            result.push_back(((character > 0) && (character < 0x80)) ? static_cast<char>(character) : '?');
+        }
+        return result;
+    }
+
+    std::shared_ptr<shared_memory::CounterFile> m_file;
+};
+
+//-----------------------------------------------------------------------------------------------------------------------------------------
+
+// there is no performance counter DLL on posix, CpplibPerformance is header only on top of the shared memory counters
+
+namespace impl
+{
+
+class CpplibPerformanceImpl final :
+    public SharedMemoryPerformance
+{
+};
+
+}
+
+inline CpplibPerformance::CpplibPerformance() :
+    m_pimpl{ pimpl::make_ptr<impl::CpplibPerformanceImpl>() }
+{
+}
+
+inline CpplibPerformance::~CpplibPerformance() = default;
+
+inline std::shared_ptr<DispatcherPerformanceItf> CpplibPerformance::GetDispatcherPerformanceCounters(const std::wstring& instance_name)
+{
+    return m_pimpl->GetDispatcherPerformanceCounters(instance_name);
+}
+
+} // performance
+} // cpp
+
+#endif
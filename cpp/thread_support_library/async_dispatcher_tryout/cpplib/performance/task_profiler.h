@@ -0,0 +1,121 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include <cpplib/types/non_copyable.h>
+
+#ifdef _WIN32
+#include <cpplib/win32/win_api.h>
+#else
+#include <time.h>
+#endif
+
+namespace cpp
+{
+namespace performance
+{
+
+// what the dispatcher thread spent on the tasks with one tag
+struct TaskProfile
+{
+    const char* tag = nullptr;
+    std::uint64_t count = 0;
+    std::chrono::nanoseconds wall_time{ 0 };
+    std::chrono::nanoseconds cpu_time{ 0 };      // less than the wall time when the task blocks or is preempted
+    std::chrono::nanoseconds max_latency{ 0 };   // longest time from queueing until start
+};
+
+// CPU time consumed by the calling thread.
+// GetThreadTimes only advances with the scheduler tick on windows, per task values are rough there.
+inline std::chrono::nanoseconds thread_cpu_time() noexcept
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!::GetThreadTimes(::GetCurrentThread(), &creation, &exit, &kernel, &user))
+    {
+        return std::chrono::nanoseconds::zero();
+    }
+    auto to_100ns = [](const FILETIME& time) { return (static_cast<std::uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime; };
+    return std::chrono::nanoseconds((to_100ns(kernel) + to_100ns(user)) * 100);
+#else
+    timespec time{};
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+#endif
+}
+
+// Per tag totals of the tasks run by a dispatcher thread. Only used from that thread, no locking.
+// Tags are static strings, they are looked up by address; equal tags at different addresses
+// (e.g. the same function name in two modules) are merged in the report.
+class TaskProfiler final :
+    public NonCopyable
+{
+public:
+    void record(const char* tag, std::chrono::nanoseconds queue_latency, std::chrono::nanoseconds wall_time, std::chrono::nanoseconds cpu_time)
+    {
+        auto& profile = m_profiles.try_emplace(tag, TaskProfile{ tag }).first->second;
+        ++profile.count;
+        profile.wall_time += wall_time;
+        profile.cpu_time += cpu_time;
+        profile.max_latency = std::max(profile.max_latency, queue_latency);
+    }
+
+    // the top_n tags with the most wall time, most expensive first
+    std::vector<TaskProfile> top(std::size_t top_n) const
+    {
+        std::vector<TaskProfile> profiles;
+        profiles.reserve(m_profiles.size());
+        for (auto& entry : m_profiles)
+        {
+            profiles.push_back(entry.second);
+        }
+
+        std::sort(profiles.begin(), profiles.end(), [](const TaskProfile& lhs, const TaskProfile& rhs)
+        {
+            return std::strcmp(lhs.tag, rhs.tag) < 0;
+        });
+        std::vector<TaskProfile> merged;
+        for (auto& profile : profiles)
+        {
+            if (!merged.empty() && (std::strcmp(merged.back().tag, profile.tag) == 0))
+            {
+                merged.back().count += profile.count;
+                merged.back().wall_time += profile.wall_time;
+                merged.back().cpu_time += profile.cpu_time;
+                merged.back().max_latency = std::max(merged.back().max_latency, profile.max_latency);
+            }
+            else
+            {
+                merged.push_back(profile);
+            }
+        }
+
+        std::sort(merged.begin(), merged.end(), [](const TaskProfile& lhs, const TaskProfile& rhs)
+        {
+            return lhs.wall_time > rhs.wall_time;
+        });
+        if (merged.size() > top_n)
+        {
+            merged.resize(top_n);
+        }
+        return merged;
+    }
+
+    void reset() noexcept
+    {
+        m_profiles.clear();
+    }
+
+private:
+    std::unordered_map<const char*, TaskProfile> m_profiles;
+};
+
+} // performance
+} // cpp
@@ -0,0 +1,369 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include <cpplib/types/non_copyable.h>
+
+// Built-in event tracer, dumps Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+//
+//   cpp::performance::Tracer::instance().enable();
+//   ...
+//   std::ofstream file("trace.json");
+//   cpp::performance::Tracer::instance().write_chrome_trace(file);
+//
+// Every thread records into its own ring buffer, recording takes no lock and never allocates
+// after the first event of a thread; old events are overwritten when a buffer is full.
+// Dumping can be done while the threads keep recording. When the tracer is disabled (the default)
+// an event costs one relaxed load.
+//
+// Names and categories must be static strings, only the pointers are stored.
+
+namespace cpp
+{
+namespace performance
+{
+
+// Chrome trace event phases
+enum class TracePhase : char
+{
+    begin = 'B',
+    end = 'E',
+    instant = 'i',
+    complete = 'X',     // zero length slice
+    flow_start = 's',
+    flow_end = 'f'
+};
+
+struct TraceEvent
+{
+    const char* category;
+    const char* name;
+    TracePhase phase;
+    std::uint64_t id;           // connects flow_start and flow_end, possibly on different threads
+    std::int64_t timestamp;     // steady clock, nanoseconds
+    std::uint64_t value;        // shown as argument in the viewer
+};
+
+// ring buffer of one thread. Only the owning thread writes, any thread may read:
+// every slot is guarded by a sequence number (twice the number of writes to it, odd while writing),
+// a reader skips slots that are being or have been overwritten meanwhile.
+class TraceBuffer final :
+    public NonCopyable
+{
+public:
+    TraceBuffer(std::size_t capacity, std::uint32_t thread_index) :
+        m_slots(new Slot[capacity]),
+        m_capacity{ capacity },
+        m_thread_index{ thread_index }
+    {
+    }
+
+    void record(const TraceEvent& event) noexcept
+    {
+        auto position = m_written.load(std::memory_order_relaxed);
+        auto& slot = m_slots[position % m_capacity];
+
+        auto sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);   // odd: being written
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.category.store(event.category, std::memory_order_relaxed);
+        slot.name.store(event.name, std::memory_order_relaxed);
+        slot.phase.store(event.phase, std::memory_order_relaxed);
+        slot.id.store(event.id, std::memory_order_relaxed);
+        slot.timestamp.store(event.timestamp, std::memory_order_relaxed);
+        slot.value.store(event.value, std::memory_order_relaxed);
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+
+        m_written.store(position + 1, std::memory_order_release);
+    }
+
+    // the events still in the buffer, oldest first
+    template<typename Fn>
+    void for_each(Fn&& fn) const
+    {
+        auto written = m_written.load(std::memory_order_acquire);
+        auto first = (written > m_capacity) ? (written - m_capacity) : 0;
+        for (auto position = first; position < written; ++position)
+        {
+            auto& slot = m_slots[position % m_capacity];
+            auto sequence = slot.sequence.load(std::memory_order_acquire);
+            TraceEvent event
+            {
+                slot.category.load(std::memory_order_relaxed),
+                slot.name.load(std::memory_order_relaxed),
+                slot.phase.load(std::memory_order_relaxed),
+                slot.id.load(std::memory_order_relaxed),
+                slot.timestamp.load(std::memory_order_relaxed),
+                slot.value.load(std::memory_order_relaxed)
+            };
+            std::atomic_thread_fence(std::memory_order_acquire);
+            auto expected = 2 * (position / m_capacity + 1);
+            if ((sequence == expected) && (slot.sequence.load(std::memory_order_relaxed) == expected))
+            {
+                fn(event);
+            }
+        }
+    }
+
+    std::uint32_t thread_index() const noexcept
+    {
+        return m_thread_index;
+    }
+
+    void set_thread_name(const char* name) noexcept
+    {
+        m_thread_name = name;
+    }
+
+    const char* thread_name() const noexcept
+    {
+        return m_thread_name;
+    }
+
+    void retire() noexcept
+    {
+        m_retired = true;
+    }
+
+    bool retired() const noexcept
+    {
+        return m_retired;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::uint64_t> sequence{ 0 };
+        std::atomic<const char*> category{ nullptr };
+        std::atomic<const char*> name{ nullptr };
+        std::atomic<TracePhase> phase{ TracePhase::instant };
+        std::atomic<std::uint64_t> id{ 0 };
+        std::atomic<std::int64_t> timestamp{ 0 };
+        std::atomic<std::uint64_t> value{ 0 };
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    const std::size_t m_capacity;
+    const std::uint32_t m_thread_index;
+    std::atomic<std::uint64_t> m_written{ 0 };
+    std::atomic<const char*> m_thread_name{ nullptr };
+    std::atomic<bool> m_retired{ false };
+};
+
+//-----------------------------------------------------------------------------------------------------------------------------------------
+
+class Tracer final :
+    public NonCopyable
+{
+public:
+    static constexpr std::size_t default_events_per_thread = 1 << 14;
+
+    // buffers of threads that ended are kept for the dump, the oldest beyond this number are dropped
+    static constexpr std::size_t max_retired_buffers = 64;
+
+    static Tracer& instance()
+    {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    // threads get a buffer of events_per_thread events when they record their first event
+    void enable(std::size_t events_per_thread = default_events_per_thread) noexcept
+    {
+        m_events_per_thread = std::max<std::size_t>(events_per_thread, 1);
+        m_enabled.store(true, std::memory_order_relaxed);
+    }
+
+    void disable() noexcept
+    {
+        m_enabled.store(false, std::memory_order_relaxed);
+    }
+
+    bool enabled() const noexcept
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    void record(TracePhase phase, const char* category, const char* name, std::uint64_t id = 0, std::uint64_t value = 0) noexcept
+    {
+        if (!enabled())
+        {
+            return;
+        }
+        if (auto buffer = local_buffer())
+        {
+            auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            buffer->record({ category, name, phase, id, timestamp, value });
+        }
+    }
+
+    // shown as the name of the calling thread in the viewer
+    void set_thread_name(const char* name) noexcept
+    {
+        if (auto buffer = local_buffer())
+        {
+            buffer->set_thread_name(name);
+        }
+    }
+
+    void write_chrome_trace(std::ostream& stream) const
+    {
+        std::vector<std::shared_ptr<TraceBuffer>> buffers;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            buffers = m_buffers;
+        }
+
+        stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        auto separator = "\n";
+        for (auto& buffer : buffers)
+        {
+            if (auto thread_name = buffer->thread_name())
+            {
+                stream << separator << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->thread_index()
+                    << ",\"args\":{\"name\":";
+                write_string(stream, thread_name);
+                stream << "}}";
+                separator = ",\n";
+            }
+
+            buffer->for_each([&stream, &separator, &buffer](const TraceEvent& event)
+            {
+                stream << separator;
+                separator = ",\n";
+                write_event(stream, buffer->thread_index(), event);
+            });
+        }
+        stream << "\n]}\n";
+    }
+
+private:
+    // registers the buffer of the thread on its first event, unregisters it when the thread ends
+    struct LocalBuffer
+    {
+        ~LocalBuffer()
+        {
+            if (buffer)
+            {
+                Tracer::instance().retire(buffer);
+            }
+        }
+
+        std::shared_ptr<TraceBuffer> buffer;
+    };
+
+    Tracer() = default;
+
+    TraceBuffer* local_buffer() noexcept
+    {
+        static thread_local LocalBuffer local;
+        if (!local.buffer)
+        {
+            try
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                local.buffer = std::make_shared<TraceBuffer>(m_events_per_thread, m_next_thread_index++);
+                m_buffers.push_back(local.buffer);
+            }
+            catch (...)
+            {
+                return nullptr;
+            }
+        }
+        return local.buffer.get();
+    }
+
+    void retire(const std::shared_ptr<TraceBuffer>& buffer)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        buffer->retire();
+        auto retired = std::count_if(m_buffers.begin(), m_buffers.end(), [](const std::shared_ptr<TraceBuffer>& candidate)
+        {
+            return candidate->retired();
+        });
+        if (static_cast<std::size_t>(retired) > max_retired_buffers)
+        {
+            m_buffers.erase(std::find_if(m_buffers.begin(), m_buffers.end(), [](const std::shared_ptr<TraceBuffer>& candidate)
+            {
+                return candidate->retired();
+            }));
+        }
+    }
+
+    static void write_string(std::ostream& stream, const char* text)
+    {
+        stream << '"';
+        for (auto character = text; *character != '\0'; ++character)
+        {
+            if ((*character == '"') || (*character == '\\'))
+            {
+                stream << '\\';
+            }
+            stream << (static_cast<unsigned char>(*character) < 0x20 ? ' ' : *character);
+        }
+        stream << '"';
+    }
+
+    static void write_event(std::ostream& stream, std::uint32_t thread_index, const TraceEvent& event)
+    {
+        stream << "{\"ph\":\"" << static_cast<char>(event.phase) << "\",\"cat\":";
+        write_string(stream, (event.category != nullptr) ? event.category : "");
+        stream << ",\"name\":";
+        write_string(stream, (event.name != nullptr) ? event.name : "");
+        // microseconds with nanosecond digits
+        stream << ",\"pid\":1,\"tid\":" << thread_index
+            << ",\"ts\":" << event.timestamp / 1000 << '.' << std::setw(3) << std::setfill('0') << event.timestamp % 1000 << std::setfill(' ');
+
+        switch (event.phase)
+        {
+        case TracePhase::instant:
+            stream << ",\"s\":\"t\"";
+            break;
+        case TracePhase::complete:
+            stream << ",\"dur\":0";
+            break;
+        case TracePhase::flow_start:
+            stream << ",\"id\":" << event.id;
+            break;
+        case TracePhase::flow_end:
+            stream << ",\"id\":" << event.id << ",\"bp\":\"e\"";
+            break;
+        default:
+            break;
+        }
+        stream << ",\"args\":{\"value\":" << event.value << "}}";
+    }
+
+    std::atomic<bool> m_enabled{ false };
+    std::atomic<std::size_t> m_events_per_thread{ default_events_per_thread };
+
+    mutable std::mutex m_mutex;
+    std::vector<std::shared_ptr<TraceBuffer>> m_buffers;
+    std::uint32_t m_next_thread_index = 1;
+};
+
+//-----------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool tracing_enabled() noexcept
+{
+    return Tracer::instance().enabled();
+}
+
+inline void trace(TracePhase phase, const char* category, const char* name, std::uint64_t id = 0, std::uint64_t value = 0) noexcept
+{
+    Tracer::instance().record(phase, category, name, id, value);
+}
+
+} // performance
+} // cpp
@@ -0,0 +1,12 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+// As a default argument CPPLIB_CALLER_FUNCTION is the name of the calling function (like __FUNCTION__ at
+// the call site), a static string. nullptr on compilers without __builtin_FUNCTION.
+#if defined(__clang__) || defined(__GNUC__) || (defined(_MSC_VER) && (_MSC_VER >= 1926))
+#define CPPLIB_CALLER_FUNCTION __builtin_FUNCTION()
+#else
+#define CPPLIB_CALLER_FUNCTION nullptr
+#endif
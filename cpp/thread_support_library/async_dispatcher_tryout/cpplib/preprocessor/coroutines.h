@@ -0,0 +1,15 @@
+// Copyright (c) 2019 by Thermo Fisher Scientific
+// All rights reserved. This file includes confidential and proprietary information of Thermo Fisher Scientific
+
+#pragma once
+
+// CPPLIB_HAS_COROUTINES is 1 when the compiler supports C++20 coroutines (e.g. /std:c++latest, -std=c++20)
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define CPPLIB_HAS_COROUTINES 1
+#endif
+#endif
+
+#ifndef CPPLIB_HAS_COROUTINES
+#define CPPLIB_HAS_COROUTINES 0
+#endif
@@ -28,6 +28,7 @@ public:
     {
         m_released = rhs.m_released;
         rhs.release();
+        return *this;
     }
 
     guard_base(guard_base&& rhs) = delete; 
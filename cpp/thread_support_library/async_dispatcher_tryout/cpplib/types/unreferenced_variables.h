@@ -8,8 +8,13 @@ namespace cpp
 namespace unreferenced
 {
 
+#ifdef _MSC_VER
 #define UNREFERENED_FUNCTION static __forceinline 
 #define UNREFERENCED_CALLTYPE __fastcall
+#else
+#define UNREFERENED_FUNCTION static inline
+#define UNREFERENCED_CALLTYPE
+#endif
 
 template<typename Arg>
 UNREFERENED_FUNCTION void UNREFERENCED_CALLTYPE parameter(Arg&&) noexcept {};
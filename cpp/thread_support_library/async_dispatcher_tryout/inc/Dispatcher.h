@@ -1,11 +1,18 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <queue>
 #include <cassert>
 #include <mutex>
+#include <string>
 #include <thread>
-#include "inc/dbgstream.h"
+#include <unordered_map>
+#include <cpplib/concurrency/details/timing_wheel.h>
 
 #include "inc/ScheduledCall.h"
 #include "inc/DispatcherItf.h"
@@ -26,6 +33,7 @@ public:
 	virtual ~Dispatcher() override;
 
 	virtual void Notify(const std::function<void()>& fn) const override;
+	virtual void NotifyCoalesced(std::uint64_t key, const std::function<void()>& fn) const override;
 	virtual void Synchronize() const override;
 	virtual void Cancel(const ScheduledCall& call) const override;
 	virtual std::chrono::steady_clock::duration TimeUntilNextExecution(const ScheduledCall& call) const override;
@@ -52,7 +60,9 @@ private:
     unsigned int GetCallId() const;
 	void Insert(CallData&& call) const;
 	void Remove(const ScheduledCall& call) const;
-	std::vector<CallData>::iterator Find(const ScheduledCall& call);
+	void QueueDueCalls();
+	std::function<void()> TakeDueCall();
+	void RunCoalesced(std::uint64_t key) const;
 	std::function<void()> GetNextFunction();
 	void Run(const std::string& threadName);  
 
@@ -60,11 +70,15 @@ private:
 	mutable std::mutex m_qMtx;
 	mutable std::condition_variable m_cond;
 	mutable std::queue<std::function<void()>> m_q;
-	mutable std::vector<CallData> m_scheduledCalls;
+	mutable std::unordered_map<std::uint64_t, std::function<void()>> m_coalesced;
+	mutable cpp::concurrency::details::TimingWheel<CallData> m_scheduledCalls;
+	mutable std::unordered_map<unsigned int, cpp::concurrency::details::TimingWheel<CallData>::handle> m_scheduledCallHandles;
+	// fired by the wheel but not run yet, taken one at a time so a Cancel before the run still applies
+	mutable std::deque<CallData> m_dueCalls;
     mutable std::atomic<unsigned int> m_callId;
 	bool m_end;
-	std::thread m_thread;
 	std::function<void(const std::string&)> m_onUnhandledException;
+	std::thread m_thread;
 };
 
 }
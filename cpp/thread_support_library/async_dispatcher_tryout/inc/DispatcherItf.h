@@ -1,10 +1,15 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <cassert>
+#include <cstdint>
 #include <future>
 #include <chrono>
+#include <memory>
+#include <utility>
 
+#include <cpplib/concurrency/details/call_slot.h>
 #include "inc/ScheduledCall.h"
 
 namespace TaskExecution {
@@ -20,6 +25,8 @@ public:
 	DispatcherItf& operator=(const DispatcherItf&) = delete;
 
 	virtual void Notify(const std::function<void()>& fn) const = 0;
+	// While a notification with the same key is pending, fn replaces it instead of being queued again.
+	virtual void NotifyCoalesced(std::uint64_t key, const std::function<void()>& fn) const = 0;
 	virtual void Synchronize() const = 0;
 	virtual void Cancel(const ScheduledCall& call) const = 0;
 	virtual	std::chrono::steady_clock::duration TimeUntilNextExecution(const ScheduledCall& call) const = 0;
@@ -46,10 +53,71 @@ protected:
 	virtual ScheduledCall CallEverySystemClock(const std::chrono::steady_clock::duration& interval, const std::function<void()>& fn) const = 0;
 };
 
+// Waits on the call slot of the calling thread instead of a future. The rendezvous stays on the
+// stack of the caller, the notification only shares a small one-shot state that points to it.
 template <typename Fn>
 auto DispatcherItf::Call(const Fn& fn) const -> decltype(fn())
 {
-	return CallAsync(fn).get();
+	assert(!IsDispatcherThread());
+	typedef decltype(fn()) return_type;
+	struct Rendezvous
+	{
+		const Fn* fn;
+		cpp::concurrency::details::CallResult<return_type> result;
+		cpp::concurrency::details::CallSlot* slot;
+	} rendezvous{ &fn, {}, &cpp::concurrency::details::CallSlot::of_this_thread() };
+
+	// Completes the rendezvous exactly once. After that the caller may return, the rendezvous is not
+	// touched again. When the last copy of the call is dropped without having run, e.g. by the
+	// destructor of the dispatcher, it fails the call with a broken promise like the future of CallAsync would.
+	struct OneShot
+	{
+		explicit OneShot(Rendezvous& rendezvous) : pRendezvous(&rendezvous), done(false) {}
+
+		~OneShot()
+		{
+			if (!done.exchange(true))
+			{
+				pRendezvous->slot->error = std::make_exception_ptr(std::future_error(std::future_errc::broken_promise));
+				pRendezvous->slot->complete();
+			}
+		}
+
+		Rendezvous* pRendezvous;
+		std::atomic<bool> done;
+	};
+
+	// std::function wants a copyable callable: copies share the one-shot state, the first one to run calls fn
+	class PendingCall
+	{
+	public:
+		explicit PendingCall(Rendezvous& rendezvous) : m_pState(std::make_shared<OneShot>(rendezvous)) {}
+
+		void operator()() const
+		{
+			if (m_pState->done.exchange(true))
+				return;
+
+			auto& rendezvous = *m_pState->pRendezvous;
+			try
+			{
+				rendezvous.result.set(*rendezvous.fn);
+			}
+			catch (...)
+			{
+				rendezvous.slot->error = std::current_exception();
+			}
+			rendezvous.slot->complete();
+		}
+
+	private:
+		std::shared_ptr<OneShot> m_pState;
+	};
+
+	Notify(PendingCall(rendezvous));
+	rendezvous.slot->wait();
+	rendezvous.slot->rethrow_error();
+	return rendezvous.result.take();
 }
 
 template<typename Fn>
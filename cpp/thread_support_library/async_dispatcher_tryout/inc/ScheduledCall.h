@@ -0,0 +1,33 @@
+#pragma once
+
+namespace TaskExecution {
+
+class DispatcherItf;
+
+// Identifies a call scheduled with CallAt, CallAfter or CallEvery, pass it to DispatcherItf::Cancel
+// to cancel the call. Copies identify the same call.
+class ScheduledCall
+{
+public:
+	ScheduledCall(const DispatcherItf& dispatcher, unsigned int id) :
+		m_pDispatcher(&dispatcher),
+		m_id(id)
+	{
+	}
+
+	unsigned int GetId() const
+	{
+		return m_id;
+	}
+
+	const DispatcherItf& GetDispatcher() const
+	{
+		return *m_pDispatcher;
+	}
+
+private:
+	const DispatcherItf* m_pDispatcher;
+	unsigned int m_id;
+};
+
+}
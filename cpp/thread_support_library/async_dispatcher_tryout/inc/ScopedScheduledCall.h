@@ -0,0 +1,64 @@
+#pragma once
+
+#include "inc/DispatcherItf.h"
+#include "inc/ScheduledCall.h"
+
+namespace TaskExecution {
+
+// Cancels the scheduled call when it goes out of scope, the dispatcher has to outlive it.
+class ScopedScheduledCall
+{
+public:
+	ScopedScheduledCall(const ScheduledCall& call) :
+		m_call(call),
+		m_active(true)
+	{
+	}
+
+	ScopedScheduledCall(ScopedScheduledCall&& other) :
+		m_call(other.m_call),
+		m_active(other.m_active)
+	{
+		other.m_active = false;
+	}
+
+	ScopedScheduledCall& operator=(ScopedScheduledCall&& other)
+	{
+		if (this != &other)
+		{
+			Cancel();
+			m_call = other.m_call;
+			m_active = other.m_active;
+			other.m_active = false;
+		}
+		return *this;
+	}
+
+	ScopedScheduledCall(const ScopedScheduledCall&) = delete;
+	ScopedScheduledCall& operator=(const ScopedScheduledCall&) = delete;
+
+	~ScopedScheduledCall()
+	{
+		Cancel();
+	}
+
+	void Cancel()
+	{
+		if (m_active)
+		{
+			m_active = false;
+			m_call.GetDispatcher().Cancel(m_call);
+		}
+	}
+
+	const ScheduledCall& Get() const
+	{
+		return m_call;
+	}
+
+private:
+	ScheduledCall m_call;
+	bool m_active;
+};
+
+}
@@ -0,0 +1,66 @@
+// Cost of checking for cancellation in a tight loop.
+//
+// 1, 2, 4 and 8 threads check the same signal 10 million times each, the way a task polls its signal.
+// "StateVariable" is what TaskSignal used to be, it takes a mutex on every check, so the threads
+// contend on it; "token" is the CancellationToken that TaskSignal is now, an atomic load.
+// Reports the wall time divided by the number of checks of one thread.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout cancellation_check.cpp
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cpplib/concurrency/cancellation_token.h>
+#include <cpplib/concurrency/state_variable.h>
+
+namespace
+{
+
+constexpr int number_of_checks = 10000000;
+
+template<typename Check>
+double nanoseconds_per_check(int number_of_threads, Check&& is_cancelled)
+{
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int thread = 0; thread < number_of_threads; ++thread)
+    {
+        threads.emplace_back([&is_cancelled]
+        {
+            for (int check = 0; check < number_of_checks; ++check)
+            {
+                if (is_cancelled())
+                {
+                    return;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / number_of_checks;
+}
+
+}
+
+int main()
+{
+    cpp::concurrency::StateVariable<unsigned int> state_variable;
+    cpp::concurrency::CancellationSource source;
+    auto token = source.token();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "threads  StateVariable ns/check  token ns/check\n";
+    for (int number_of_threads : { 1, 2, 4, 8 })
+    {
+        auto locked = nanoseconds_per_check(number_of_threads, [&state_variable] { return state_variable == 1u; });
+        auto lock_free = nanoseconds_per_check(number_of_threads, [&token] { return token.is_cancelled(); });
+        std::cout << std::setw(7) << number_of_threads << std::setw(24) << locked << std::setw(16) << lock_free << '\n';
+    }
+    return 0;
+}
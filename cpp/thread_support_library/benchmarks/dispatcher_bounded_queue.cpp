@@ -0,0 +1,165 @@
+// A slow dispatcher flooded by faster producers, unbounded and with each QueueFullPolicy.
+//
+// Four producers post 20000 notifications each as fast as they can, every task takes about 2 us.
+// Reports how many tasks ran, how many the queue refused or dropped, the peak number of queued
+// tasks and the time until the dispatcher is done. Unbounded the queue grows to most of the
+// 80000 tasks; bounded it stays at the capacity while the producers block, fail or lose tasks.
+// With coalesce all notifications are posted with notify_replacing and the same key, so each one
+// replaces any queued one.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout dispatcher_bounded_queue.cpp
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+constexpr int number_of_producers = 4;
+constexpr int tasks_per_producer = 20000;
+constexpr std::size_t capacity = 1000;
+
+class QueueStatistics : public cpp::performance::DispatcherPerformanceItf
+{
+public:
+    void increment_number_of_calls_queued() override
+    {
+    }
+
+    void report_queue_size(std::uint32_t size) override
+    {
+        update_peak(size);
+    }
+
+    void report_latency_in_milliseconds(std::uint32_t) override
+    {
+    }
+
+    void report_queue_occupancy(std::uint32_t size, std::uint32_t) override
+    {
+        update_peak(size);
+    }
+
+    void report_queue_full(cpp::concurrency::QueueFullPolicy) override
+    {
+        ++m_full;
+    }
+
+    std::uint32_t peak() const noexcept
+    {
+        return m_peak;
+    }
+
+    std::uint64_t full() const noexcept
+    {
+        return m_full;
+    }
+
+private:
+    void update_peak(std::uint32_t size) noexcept
+    {
+        auto peak = m_peak.load(std::memory_order_relaxed);
+        while ((size > peak) && !m_peak.compare_exchange_weak(peak, size, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    std::atomic<std::uint32_t> m_peak{ 0 };
+    std::atomic<std::uint64_t> m_full{ 0 };
+};
+
+void busy_for(std::chrono::steady_clock::duration duration) noexcept
+{
+    auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+}
+
+void post(const cpp::concurrency::Dispatcher& dispatcher, bool replacing, std::atomic<int>& ran, int& refused)
+{
+    auto task = [&ran]() noexcept
+    {
+        busy_for(std::chrono::microseconds(2));
+        ++ran;
+    };
+    try
+    {
+        if (replacing)
+        {
+            dispatcher.notify_replacing(0, task);
+        }
+        else
+        {
+            dispatcher.notify(task);
+        }
+    }
+    catch (const cpp::queue_full_exception&)
+    {
+        ++refused;
+    }
+}
+
+void run(const char* name, cpp::concurrency::QueueBound bound)
+{
+    auto statistics = std::make_shared<QueueStatistics>();
+    cpp::concurrency::Dispatcher dispatcher(std::chrono::steady_clock::duration::max(), statistics, bound);
+    std::atomic<int> ran{ 0 };
+    std::atomic<int> refused{ 0 };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < number_of_producers; ++producer)
+    {
+        producers.emplace_back([&dispatcher, &ran, &refused, bound]
+        {
+            auto replacing = bound.policy == cpp::concurrency::QueueFullPolicy::coalesce;
+            int refused_here = 0;
+            for (int task = 0; task < tasks_per_producer; ++task)
+            {
+                post(dispatcher, replacing, ran, refused_here);
+            }
+            refused += refused_here;
+        });
+    }
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+    dispatcher.synchronize();
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    auto lost = number_of_producers * tasks_per_producer - ran.load() - refused.load();
+    std::cout << std::left << std::setw(14) << name << std::right
+        << std::setw(10) << ran.load()
+        << std::setw(10) << refused.load()
+        << std::setw(10) << lost
+        << std::setw(12) << statistics->full()
+        << std::setw(10) << statistics->peak()
+        << std::setw(12) << elapsed << '\n';
+}
+
+}
+
+int main()
+{
+    using cpp::concurrency::QueueBound;
+    using cpp::concurrency::QueueFullPolicy;
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "policy               ran   refused   dropped  queue full      peak     time ms\n";
+    run("unbounded", QueueBound{});
+    run("block", QueueBound{ capacity, QueueFullPolicy::block });
+    run("fail", QueueBound{ capacity, QueueFullPolicy::fail });
+    run("drop_oldest", QueueBound{ capacity, QueueFullPolicy::drop_oldest });
+    run("coalesce", QueueBound{ capacity, QueueFullPolicy::coalesce });
+    return 0;
+}
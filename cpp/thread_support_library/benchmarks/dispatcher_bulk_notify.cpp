@@ -0,0 +1,100 @@
+// Compares notify_bulk() against one notify() per item for batches of 1 to 1024 callbacks,
+// on the single threaded Dispatcher and on the PoolDispatcher.
+// Reports the producer side cost per item and the end to end throughput until the batch has run.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout dispatcher_bulk_notify.cpp
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+constexpr int items_per_run = 1 << 18;
+
+struct Result
+{
+    double producer_ns_per_item;
+    double items_per_second;
+};
+
+struct Callback
+{
+    void operator()() const noexcept
+    {
+        ++*received;
+    }
+
+    std::atomic<int>* received;
+};
+
+template<typename DISPATCHER, typename Submit>
+Result run(DISPATCHER& dispatcher, std::size_t batch_size, Submit&& submit)
+{
+    std::atomic<int> received{ 0 };
+    std::vector<Callback> batch(batch_size, Callback{ &received });
+    auto number_of_batches = items_per_run / batch_size;
+
+    std::chrono::steady_clock::duration producer_time{};
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t count = 0; count < number_of_batches; ++count)
+    {
+        auto submit_start = std::chrono::steady_clock::now();
+        submit(dispatcher, batch);
+        producer_time += std::chrono::steady_clock::now() - submit_start;
+    }
+    dispatcher.synchronize();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    auto items = static_cast<double>(number_of_batches * batch_size);
+    return { std::chrono::duration<double, std::nano>(producer_time).count() / items, received / elapsed.count() };
+}
+
+template<typename DISPATCHER>
+void compare(const char* name, DISPATCHER& dispatcher)
+{
+    auto per_item = [](DISPATCHER& target, const std::vector<Callback>& batch)
+    {
+        for (auto& callback : batch)
+        {
+            target.notify(callback);
+        }
+    };
+    auto bulk = [](DISPATCHER& target, const std::vector<Callback>& batch)
+    {
+        target.notify_bulk(batch);
+    };
+
+    std::cout << name << "\n  batch   notify ns/item   bulk ns/item   notify items/s     bulk items/s\n";
+    for (std::size_t batch_size = 1; batch_size <= 1024; batch_size *= 4)
+    {
+        auto single = run(dispatcher, batch_size, per_item);
+        auto batched = run(dispatcher, batch_size, bulk);
+        std::cout << std::fixed
+            << std::setw(7) << batch_size
+            << std::setw(17) << std::setprecision(1) << single.producer_ns_per_item
+            << std::setw(15) << batched.producer_ns_per_item
+            << std::setw(17) << std::setprecision(0) << single.items_per_second
+            << std::setw(17) << batched.items_per_second << std::endl;
+    }
+}
+
+}
+
+int main()
+{
+    {
+        cpp::concurrency::Dispatcher dispatcher;
+        compare("Dispatcher", dispatcher);
+    }
+    {
+        cpp::concurrency::PoolDispatcher dispatcher(std::chrono::steady_clock::duration::max(), cpp::performance::NullDispatcherPerformance::shared(), 4);
+        compare("PoolDispatcher (4 threads)", dispatcher);
+    }
+    return 0;
+}
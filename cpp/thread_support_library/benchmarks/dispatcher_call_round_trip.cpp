@@ -0,0 +1,86 @@
+// Round trip of a synchronous call into the dispatcher: async(fn).get(), which call() used to be,
+// against call(), which waits on a per-thread slot.
+//
+// 100000 calls returning an int, one after the other from the same thread. Reports the time and
+// the heap allocations per call; operator new is replaced to count them.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout dispatcher_call_round_trip.cpp
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+constexpr int number_of_calls = 100000;
+
+std::atomic<long long> allocations{ 0 };
+
+template<typename Call>
+void run(const char* name, Call call)
+{
+    cpp::concurrency::Dispatcher dispatcher;
+    for (int warm_up = 0; warm_up < 1000; ++warm_up)
+    {
+        call(dispatcher, warm_up);
+    }
+
+    long long sum = 0;
+    auto allocations_before = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int index = 0; index < number_of_calls; ++index)
+    {
+        sum += call(dispatcher, index);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    auto allocations_per_call = static_cast<double>(allocations.load() - allocations_before) / number_of_calls;
+
+    std::cout << std::left << std::setw(18) << name << std::right
+        << std::setw(12) << std::chrono::duration<double, std::micro>(elapsed).count() / number_of_calls
+        << std::setw(16) << allocations_per_call
+        << (sum == 0 ? " !" : "") << '\n';
+}
+
+}
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if (auto memory = std::malloc(size == 0 ? 1 : size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+// not inlined: gcc would see free() on memory from operator new and warn about a mismatch
+[[gnu::noinline]] void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+[[gnu::noinline]] void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "                    us/call  allocations/call\n";
+    run("async().get()", [](const cpp::concurrency::Dispatcher& dispatcher, int value)
+    {
+        return dispatcher.async([value] { return value; }).get();
+    });
+    run("call()", [](const cpp::concurrency::Dispatcher& dispatcher, int value)
+    {
+        return dispatcher.call([value] { return value; });
+    });
+    return 0;
+}
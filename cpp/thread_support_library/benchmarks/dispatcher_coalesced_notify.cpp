@@ -0,0 +1,117 @@
+// A status publisher posting the same "state changed" update with notify and with notify_coalesced.
+//
+// Two publishers post 100000 updates each, every update takes about 1 us to apply on the dispatcher.
+// Reports how often the update ran, the peak number of queued tasks and the time until the dispatcher
+// is done. With notify every update is queued and applied; coalesced, the queue holds at most one
+// update and the dispatcher applies the latest state once per turn.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout dispatcher_coalesced_notify.cpp
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+constexpr int number_of_publishers = 2;
+constexpr int updates_per_publisher = 100000;
+constexpr cpp::concurrency::coalescing_key state_changed = 1;
+
+class PeakQueueSize : public cpp::performance::DispatcherPerformanceItf
+{
+public:
+    void increment_number_of_calls_queued() override
+    {
+    }
+
+    void report_queue_size(std::uint32_t size) override
+    {
+        auto peak = m_peak.load(std::memory_order_relaxed);
+        while ((size > peak) && !m_peak.compare_exchange_weak(peak, size, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void report_latency_in_milliseconds(std::uint32_t) override
+    {
+    }
+
+    std::uint32_t peak() const noexcept
+    {
+        return m_peak;
+    }
+
+private:
+    std::atomic<std::uint32_t> m_peak{ 0 };
+};
+
+void apply_update(std::atomic<int>& applied) noexcept
+{
+    auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(1);
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+    ++applied;
+}
+
+template<typename Post>
+void run(const char* name, Post post)
+{
+    auto peak = std::make_shared<PeakQueueSize>();
+    cpp::concurrency::Dispatcher dispatcher(std::chrono::steady_clock::duration::max(), peak);
+    std::atomic<int> applied{ 0 };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> publishers;
+    for (int publisher = 0; publisher < number_of_publishers; ++publisher)
+    {
+        publishers.emplace_back([&dispatcher, &applied, &post]
+        {
+            for (int update = 0; update < updates_per_publisher; ++update)
+            {
+                post(dispatcher, applied);
+            }
+        });
+    }
+    for (auto& publisher : publishers)
+    {
+        publisher.join();
+    }
+    dispatcher.synchronize();
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::left << std::setw(18) << name << std::right
+        << std::setw(10) << applied.load()
+        << std::setw(10) << peak->peak()
+        << std::setw(12) << elapsed << '\n';
+}
+
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "                     applied      peak     time ms\n";
+    run("notify", [](const cpp::concurrency::Dispatcher& dispatcher, std::atomic<int>& applied)
+    {
+        dispatcher.notify([&applied]() noexcept
+        {
+            apply_update(applied);
+        });
+    });
+    run("notify_coalesced", [](const cpp::concurrency::Dispatcher& dispatcher, std::atomic<int>& applied)
+    {
+        dispatcher.notify_coalesced(state_changed, [&applied]() noexcept
+        {
+            apply_update(applied);
+        });
+    });
+    return 0;
+}
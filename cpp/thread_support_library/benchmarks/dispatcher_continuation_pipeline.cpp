@@ -0,0 +1,87 @@
+// Runs N concurrent three stage pipelines (stage 1 and 3 on dispatcher A, stage 2 on dispatcher B):
+//  - blocking:      one client thread per pipeline, each stage is a call() that parks the thread
+//  - continuations: post(a, ...).then(b, ...).then(a, ...), all pipelines driven from one thread
+// Reports the number of threads each approach needs besides the two dispatcher threads, and the elapsed time.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout dispatcher_continuation_pipeline.cpp
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cpplib/concurrency/dispatcher.h>
+#include <cpplib/concurrency/future.h>
+
+namespace
+{
+
+constexpr int rounds_per_pipeline = 200;
+
+int stage1(int value) { return value + 1; }
+int stage2(int value) { return value * 2; }
+int stage3(int value) { return value - 1; }
+
+double run_blocking(std::size_t number_of_pipelines)
+{
+    cpp::concurrency::Dispatcher a;
+    cpp::concurrency::Dispatcher b;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (std::size_t pipeline = 0; pipeline < number_of_pipelines; ++pipeline)
+    {
+        clients.emplace_back([&a, &b]
+        {
+            for (int round = 0; round < rounds_per_pipeline; ++round)
+            {
+                auto value = a.call([round] { return stage1(round); });
+                value = b.call([value] { return stage2(value); });
+                value = a.call([value] { return stage3(value); });
+            }
+        });
+    }
+    for (auto& client : clients)
+    {
+        client.join();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+double run_continuations(std::size_t number_of_pipelines)
+{
+    cpp::concurrency::Dispatcher a;
+    cpp::concurrency::Dispatcher b;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds_per_pipeline; ++round)
+    {
+        std::vector<cpp::concurrency::Future<int>> pipelines;
+        for (std::size_t pipeline = 0; pipeline < number_of_pipelines; ++pipeline)
+        {
+            pipelines.push_back(cpp::concurrency::post(a, [round] { return stage1(round); })
+                .then(b, [](const int& value) { return stage2(value); })
+                .then(a, [](const int& value) { return stage3(value); }));
+        }
+        cpp::concurrency::when_all(std::move(pipelines)).wait();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "pipelines  blocking threads  blocking ms  continuation threads  continuation ms\n";
+    for (std::size_t number_of_pipelines : { 1, 8, 64, 256 })
+    {
+        std::cout << std::setw(9) << number_of_pipelines
+            << std::setw(18) << number_of_pipelines
+            << std::setw(13) << run_blocking(number_of_pipelines)
+            << std::setw(22) << 1
+            << std::setw(17) << run_continuations(number_of_pipelines) << std::endl;
+    }
+    return 0;
+}
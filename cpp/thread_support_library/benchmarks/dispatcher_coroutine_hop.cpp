@@ -0,0 +1,77 @@
+// Compares a cross-thread round trip done with a blocking call() against the same hop done
+// by a coroutine that co_awaits dispatcher.schedule().
+//  - call():      the client thread blocks on a packaged_task/future pair for every hop
+//  - co_await:    a coroutine hops between two dispatchers, no thread blocks and no future is created
+//
+// Needs C++20 coroutines, build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++latest /O2 /EHsc /I..\async_dispatcher_tryout dispatcher_coroutine_hop.cpp
+
+#include <chrono>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <cpplib/concurrency/coroutine.h>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+constexpr int number_of_hops = 100000;
+
+double ns_per_hop(std::chrono::steady_clock::duration elapsed)
+{
+    return std::chrono::duration<double, std::nano>(elapsed).count() / number_of_hops;
+}
+
+double run_call()
+{
+    cpp::concurrency::Dispatcher dispatcher;
+    int counter = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int hop = 0; hop < number_of_hops; ++hop)
+    {
+        dispatcher.call([&counter] { ++counter; });
+    }
+    return ns_per_hop(std::chrono::steady_clock::now() - start);
+}
+
+cpp::concurrency::task<int> ping_pong(cpp::concurrency::Dispatcher& ping, cpp::concurrency::Dispatcher& pong)
+{
+    int counter = 0;
+    for (int hop = 0; hop < number_of_hops; hop += 2)
+    {
+        co_await ping.schedule();
+        ++counter;
+        co_await pong.schedule();
+        ++counter;
+    }
+    co_return counter;
+}
+
+cpp::concurrency::task<void> run_ping_pong(cpp::concurrency::Dispatcher& ping, cpp::concurrency::Dispatcher& pong, std::promise<int>& done)
+{
+    done.set_value(co_await ping_pong(ping, pong));
+}
+
+double run_coroutine()
+{
+    cpp::concurrency::Dispatcher ping;
+    cpp::concurrency::Dispatcher pong;
+    std::promise<int> done;
+
+    auto start = std::chrono::steady_clock::now();
+    cpp::concurrency::start_detached(run_ping_pong(ping, pong, done));
+    done.get_future().get();
+    return ns_per_hop(std::chrono::steady_clock::now() - start);
+}
+
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "call()           " << std::setw(10) << run_call() << " ns/hop\n";
+    std::cout << "co_await schedule" << std::setw(10) << run_coroutine() << " ns/hop\n";
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Round trip between a producer and the dispatcher with IdleStrategy::park and ::adaptive_spin.
+//
+// The producer notifies the dispatcher, waits (yielding) until the task has run and pauses for a
+// while before the next message, 20000 times. With short pauses the traffic is bursty and the
+// spinning dispatcher catches the next message without going to sleep; with long pauses it parks
+// either way. Reports p50 and p99 of the round trip and the CPU time of the process per message.
+//
+// Spinning only helps with a core of its own for the dispatcher; with a single hardware thread
+// adaptive_spin only yields.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout dispatcher_idle_strategy.cpp
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+constexpr int number_of_messages = 20000;
+
+double percentile(std::vector<double> values, double fraction)
+{
+    std::sort(values.begin(), values.end());
+    return values[static_cast<std::size_t>(fraction * (values.size() - 1))];
+}
+
+void pause_for(std::chrono::steady_clock::duration duration) noexcept
+{
+    auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+}
+
+void run(const char* name, cpp::concurrency::IdleStrategy strategy, std::chrono::microseconds pause)
+{
+    cpp::concurrency::Dispatcher dispatcher;
+    dispatcher.set_idle_strategy(strategy);
+    dispatcher.synchronize();
+
+    std::vector<double> round_trips;
+    round_trips.reserve(number_of_messages);
+    auto cpu_start = std::clock();
+    for (int message = 0; message < number_of_messages; ++message)
+    {
+        std::atomic<bool> done{ false };
+        auto start = std::chrono::steady_clock::now();
+        dispatcher.notify([&done]() noexcept
+        {
+            done.store(true, std::memory_order_release);
+        });
+        while (!done.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+        round_trips.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        pause_for(pause);
+    }
+    auto cpu_us_per_message = 1e6 * static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC / number_of_messages;
+
+    std::cout << std::left << std::setw(16) << name << std::right << std::setw(10) << pause.count()
+        << std::setw(12) << percentile(round_trips, 0.5)
+        << std::setw(12) << percentile(round_trips, 0.99)
+        << std::setw(16) << cpu_us_per_message << '\n';
+}
+
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "strategy        pause us      p50 us      p99 us  cpu us/message\n";
+    for (auto pause : { std::chrono::microseconds(5), std::chrono::microseconds(20), std::chrono::microseconds(500) })
+    {
+        run("park", cpp::concurrency::IdleStrategy::park, pause);
+        run("adaptive_spin", cpp::concurrency::IdleStrategy::adaptive_spin, pause);
+    }
+    return 0;
+}
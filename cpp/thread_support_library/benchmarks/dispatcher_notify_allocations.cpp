@@ -0,0 +1,85 @@
+// Counts the heap allocations done by cpp::concurrency::Dispatcher::notify() in steady state
+// and measures the cost of a notify call.
+//
+// Global operator new is replaced to count allocations. Task nodes are over-aligned and use the aligned
+// operator new, those are counted by the task node pool itself. The pool only grows when the backlog of
+// the dispatcher exceeds the largest backlog seen so far, lambdas that fit in TaskNode::inline_size
+// should report 0 allocations per notify.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout dispatcher_notify_allocations.cpp
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+std::atomic<std::size_t> number_of_allocations{ 0 };
+
+constexpr int notifications_per_round = 100000;
+constexpr int number_of_rounds = 5;
+
+}
+
+void* operator new(std::size_t size)
+{
+    ++number_of_allocations;
+    if (auto memory = std::malloc(size == 0 ? 1 : size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+// not inlined: gcc would see free() on memory from operator new and warn about a mismatch
+[[gnu::noinline]] void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+[[gnu::noinline]] void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+int main()
+{
+    cpp::concurrency::Dispatcher dispatcher;
+    std::atomic<int> received{ 0 };
+    std::uint64_t payload[4]{ 1, 2, 3, 4 };
+
+    auto& pool = cpp::concurrency::details::TaskNodePool::instance();
+
+    std::cout << "round  allocations/notify  pool allocations  ns/notify\n";
+    for (int round = 0; round < number_of_rounds; ++round)
+    {
+        auto allocations_before = number_of_allocations.load();
+        auto pool_allocations_before = pool.heap_allocations();
+        auto start = std::chrono::steady_clock::now();
+        for (int notification = 0; notification < notifications_per_round; ++notification)
+        {
+            dispatcher.notify([&received, payload]() noexcept { received += static_cast<int>(payload[0]); });
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        auto allocations = number_of_allocations.load() - allocations_before;
+        auto pool_allocations = pool.heap_allocations() - pool_allocations_before;
+
+        // synchronize() itself allocates a packaged task, keep it out of the measurement
+        dispatcher.synchronize();
+
+        std::cout << std::setw(5) << round
+            << std::setw(20) << std::fixed << std::setprecision(3) << static_cast<double>(allocations) / notifications_per_round
+            << std::setw(18) << pool_allocations
+            << std::setw(11) << std::setprecision(1) << std::chrono::duration<double, std::nano>(elapsed).count() / notifications_per_round
+            << std::endl;
+    }
+
+    std::cout << "received " << received << std::endl;
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Latency of critical callbacks while the dispatcher is flooded with bulk work.
+//
+// A producer queues 20000 bulk tasks of ~20 us each, then posts a critical callback every millisecond
+// and measures the time until it runs. Done once with everything in the normal lane (as before
+// priority lanes existed) and once with the bulk work in the background lane and the callbacks in the
+// critical lane. The last column shows the bulk work still completes, the background lane is not starved.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout dispatcher_priority_lanes.cpp
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+using cpp::concurrency::DispatcherPriority;
+
+constexpr int number_of_bulk_tasks = 20000;
+constexpr int number_of_probes = 100;
+
+void busy_for(std::chrono::steady_clock::duration duration) noexcept
+{
+    auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+}
+
+void run(const char* name, DispatcherPriority bulk_priority, DispatcherPriority probe_priority)
+{
+    cpp::concurrency::Dispatcher dispatcher;
+    std::atomic<int> bulk_done{ 0 };
+
+    for (int task = 0; task < number_of_bulk_tasks; ++task)
+    {
+        dispatcher.notify(bulk_priority, [&bulk_done]() noexcept
+        {
+            busy_for(std::chrono::microseconds(20));
+            ++bulk_done;
+        });
+    }
+
+    std::vector<std::atomic<std::int64_t>> latencies_us(number_of_probes);
+    for (int probe = 0; probe < number_of_probes; ++probe)
+    {
+        auto posted = std::chrono::steady_clock::now();
+        dispatcher.notify(probe_priority, [&latencies_us, probe, posted]() noexcept
+        {
+            latencies_us[probe] = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - posted).count();
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto bulk_done_after_probes = bulk_done.load();
+    dispatcher.synchronize();
+
+    std::vector<std::int64_t> sorted;
+    for (auto& latency : latencies_us)
+    {
+        sorted.push_back(latency);
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    std::cout << std::left << std::setw(22) << name << std::right
+        << std::setw(12) << sorted[sorted.size() / 2]
+        << std::setw(12) << sorted[sorted.size() * 99 / 100]
+        << std::setw(12) << sorted.back()
+        << std::setw(14) << bulk_done_after_probes << std::endl;
+}
+
+}
+
+int main()
+{
+    std::cout << "lanes                   p50 us      p99 us      max us   bulk done\n";
+    run("single lane", DispatcherPriority::normal, DispatcherPriority::normal);
+    run("critical/background", DispatcherPriority::background, DispatcherPriority::critical);
+    return 0;
+}
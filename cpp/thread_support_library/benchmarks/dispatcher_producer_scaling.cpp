@@ -0,0 +1,62 @@
+// Measures notify() throughput of cpp::concurrency::Dispatcher
+// with 1 to 32 producer threads posting to one dispatcher.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout dispatcher_producer_scaling.cpp
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+constexpr int messages_per_run = 1 << 20;
+
+double run(unsigned int number_of_producers)
+{
+    cpp::concurrency::Dispatcher dispatcher;
+    std::atomic<int> received{ 0 };
+    std::atomic<bool> go{ false };
+
+    std::vector<std::thread> producers;
+    auto messages_per_producer = messages_per_run / static_cast<int>(number_of_producers);
+    for (unsigned int producer = 0; producer < number_of_producers; ++producer)
+    {
+        producers.emplace_back([&]
+        {
+            while (!go) std::this_thread::yield();
+            for (int message = 0; message < messages_per_producer; ++message)
+            {
+                dispatcher.notify([&received]() noexcept { ++received; });
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+    dispatcher.synchronize();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    return received / elapsed.count();
+}
+
+}
+
+int main()
+{
+    std::cout << "producers  messages/s\n";
+    for (unsigned int number_of_producers = 1; number_of_producers <= 32; number_of_producers *= 2)
+    {
+        std::cout << std::setw(9) << number_of_producers << "  " << std::fixed << std::setprecision(0) << run(number_of_producers) << std::endl;
+    }
+    return 0;
+}
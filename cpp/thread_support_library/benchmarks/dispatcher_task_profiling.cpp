@@ -0,0 +1,105 @@
+// Cost of the per task profile of the dispatcher, and what its report looks like.
+//
+// Queues 200000 empty notifications with task profiling off and on and reports the time per task
+// on the dispatcher thread. Then runs a mix of cheap, expensive and blocking callbacks posted from
+// three functions and prints the top tags: the blocking one shows wall time without CPU time.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout dispatcher_task_profiling.cpp
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+constexpr int number_of_tasks = 200000;
+
+void busy_for(std::chrono::steady_clock::duration duration) noexcept
+{
+    auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+}
+
+double nanoseconds_per_task(bool profiling)
+{
+    cpp::concurrency::Dispatcher dispatcher;
+    dispatcher.enable_task_profiling(profiling);
+    dispatcher.synchronize();
+
+    // the dispatcher is held up until everything is queued, so only running the tasks is timed
+    std::atomic<bool> go{ false };
+    dispatcher.notify([&go]() noexcept
+    {
+        while (!go)
+        {
+            std::this_thread::yield();
+        }
+    });
+    for (int task = 0; task < number_of_tasks; ++task)
+    {
+        dispatcher.notify([]() noexcept {});
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    dispatcher.synchronize();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / number_of_tasks;
+}
+
+void post_cheap_work(cpp::concurrency::Dispatcher& dispatcher)
+{
+    for (int task = 0; task < 1000; ++task)
+    {
+        dispatcher.notify([]() noexcept { busy_for(std::chrono::microseconds(5)); });
+    }
+}
+
+void post_expensive_work(cpp::concurrency::Dispatcher& dispatcher)
+{
+    for (int task = 0; task < 50; ++task)
+    {
+        dispatcher.notify([]() noexcept { busy_for(std::chrono::milliseconds(1)); });
+    }
+}
+
+void post_blocking_work(cpp::concurrency::Dispatcher& dispatcher)
+{
+    for (int task = 0; task < 20; ++task)
+    {
+        dispatcher.notify([]() noexcept { std::this_thread::sleep_for(std::chrono::milliseconds(2)); });
+    }
+}
+
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "profiling off: " << nanoseconds_per_task(false) << " ns/task\n";
+    std::cout << "profiling on:  " << nanoseconds_per_task(true) << " ns/task\n\n";
+
+    cpp::concurrency::Dispatcher dispatcher;
+    dispatcher.enable_task_profiling();
+    post_cheap_work(dispatcher);
+    post_expensive_work(dispatcher);
+    post_blocking_work(dispatcher);
+    dispatcher.synchronize();
+
+    std::cout << std::left << std::setw(24) << "tag" << std::right
+        << std::setw(8) << "count" << std::setw(12) << "wall ms" << std::setw(12) << "cpu ms" << std::setw(16) << "max latency ms\n";
+    for (auto& profile : dispatcher.task_profile(5))
+    {
+        std::cout << std::left << std::setw(24) << profile.tag << std::right
+            << std::setw(8) << profile.count
+            << std::setw(12) << std::chrono::duration<double, std::milli>(profile.wall_time).count()
+            << std::setw(12) << std::chrono::duration<double, std::milli>(profile.cpu_time).count()
+            << std::setw(15) << std::chrono::duration<double, std::milli>(profile.max_latency).count() << '\n';
+    }
+    return 0;
+}
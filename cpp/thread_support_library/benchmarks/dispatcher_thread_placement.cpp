@@ -0,0 +1,84 @@
+// Round trip of call() into a dispatcher whose thread is left to the scheduler, pinned to the CPU
+// of the caller, pinned to another CPU of the same NUMA node, and pinned to the last NUMA node.
+//
+// The caller is pinned to the first CPU of NUMA node 0. 100000 calls returning an int, one after
+// the other. A placement the machine does not have (one CPU, one NUMA node) is skipped.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout dispatcher_thread_placement.cpp
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <cpplib/concurrency/dispatcher.h>
+#include <cpplib/concurrency/thread_placement.h>
+
+namespace
+{
+
+constexpr int number_of_calls = 100000;
+
+void run(const std::string& name, const cpp::concurrency::ThreadPlacement& placement)
+{
+    cpp::concurrency::Dispatcher dispatcher(std::chrono::steady_clock::duration::max(), cpp::performance::NullDispatcherPerformance::shared(), placement);
+    for (int warm_up = 0; warm_up < 1000; ++warm_up)
+    {
+        dispatcher.call([warm_up] { return warm_up; });
+    }
+
+    long long sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int index = 0; index < number_of_calls; ++index)
+    {
+        sum += dispatcher.call([index] { return index; });
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << std::left << std::setw(22) << name << std::right
+        << std::setw(10) << std::chrono::duration<double, std::micro>(elapsed).count() / number_of_calls
+        << (sum == 0 ? " !" : "") << '\n';
+}
+
+cpp::concurrency::ThreadPlacement pinned_to(unsigned int cpu)
+{
+    cpp::concurrency::ThreadPlacement placement;
+    placement.cpu_sets = { { cpu } };
+    placement.name = "placement bench";
+    return placement;
+}
+
+}
+
+int main()
+{
+    auto node0 = cpp::concurrency::numa_node_cpus(0);
+    if (node0.empty())
+    {
+        node0 = { 0 };
+    }
+    unsigned int last_node = 0;
+    while (!cpp::concurrency::numa_node_cpus(last_node + 1).empty())
+    {
+        ++last_node;
+    }
+
+    // the caller
+    cpp::concurrency::details::apply_thread_placement(pinned_to(node0.front()), 0, 1);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "dispatcher thread        us/call\n";
+    run("unpinned", {});
+    run("caller's cpu", pinned_to(node0.front()));
+    if (node0.size() > 1)
+    {
+        run("same numa node", pinned_to(node0.back()));
+    }
+    if (last_node > 0)
+    {
+        cpp::concurrency::ThreadPlacement remote;
+        remote.cpu_sets = { cpp::concurrency::numa_node_cpus(last_node) };
+        run("numa node " + std::to_string(last_node), remote);
+    }
+    return 0;
+}
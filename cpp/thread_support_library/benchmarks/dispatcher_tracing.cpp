@@ -0,0 +1,101 @@
+// Cost of the built-in tracer for dispatcher tasks, and a trace to look at.
+//
+// Queues 200000 empty notifications with the tracer disabled and enabled and reports the time per task
+// on the dispatcher thread (enqueue is traced on the producer, dequeue, start and end on the dispatcher).
+// Then a few producers post to a dispatcher and a thread pool, the result is written to
+// dispatcher_trace.json: open it in chrome://tracing or ui.perfetto.dev, arrows link enqueue and start.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout dispatcher_tracing.cpp
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cpplib/concurrency/dispatcher.h>
+#include <cpplib/performance/tracer.h>
+
+namespace
+{
+
+constexpr int number_of_tasks = 200000;
+
+double nanoseconds_per_task(bool tracing)
+{
+    auto& tracer = cpp::performance::Tracer::instance();
+    if (tracing)
+    {
+        tracer.enable();
+    }
+    else
+    {
+        tracer.disable();
+    }
+    cpp::concurrency::Dispatcher dispatcher;
+    dispatcher.synchronize();
+
+    // the dispatcher is held up until everything is queued, so only running the tasks is timed
+    std::atomic<bool> go{ false };
+    dispatcher.notify([&go]() noexcept
+    {
+        while (!go)
+        {
+            std::this_thread::yield();
+        }
+    });
+    for (int task = 0; task < number_of_tasks; ++task)
+    {
+        dispatcher.notify([]() noexcept {});
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    dispatcher.synchronize();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / number_of_tasks;
+}
+
+void produce(cpp::concurrency::Dispatcher& dispatcher, cpp::concurrency::PoolDispatcher& pool)
+{
+    for (int task = 0; task < 100; ++task)
+    {
+        dispatcher.notify([]() noexcept { std::this_thread::sleep_for(std::chrono::microseconds(50)); });
+        pool.notify([]() noexcept { std::this_thread::sleep_for(std::chrono::microseconds(200)); });
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "tracing off: " << nanoseconds_per_task(false) << " ns/task\n";
+    std::cout << "tracing on:  " << nanoseconds_per_task(true) << " ns/task\n";
+
+    auto& tracer = cpp::performance::Tracer::instance();
+    tracer.enable();
+    {
+        cpp::concurrency::Dispatcher dispatcher;
+        cpp::concurrency::PoolDispatcher pool(std::chrono::steady_clock::duration::max(), cpp::performance::NullDispatcherPerformance::shared(), 2);
+        std::vector<std::thread> producers;
+        for (int producer = 0; producer < 3; ++producer)
+        {
+            producers.emplace_back([&dispatcher, &pool] { produce(dispatcher, pool); });
+        }
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+        dispatcher.synchronize();
+        pool.synchronize();
+    }
+    tracer.disable();
+
+    std::ofstream file("dispatcher_trace.json");
+    tracer.write_chrome_trace(file);
+    std::cout << "trace written to dispatcher_trace.json" << std::endl;
+    return 0;
+}
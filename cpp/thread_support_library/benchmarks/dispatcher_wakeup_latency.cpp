@@ -0,0 +1,124 @@
+// Wake-up latency of Signal and of an idle dispatcher.
+//
+// "signal ping-pong" bounces between two threads through two signals 20000 times and reports the
+// round trip, once with the condition variable signal Signal used to be and once with Signal,
+// which sleeps on a futex and skips the wake-up when nobody waits.
+// "dispatcher wake-up" lets the dispatcher fall asleep, then notifies it 2000 times and reports the
+// time from notify until the task runs.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout dispatcher_wakeup_latency.cpp
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cpplib/concurrency/dispatcher.h>
+#include <cpplib/concurrency/signal.h>
+
+namespace
+{
+
+constexpr int number_of_round_trips = 20000;
+constexpr int number_of_wake_ups = 2000;
+
+// the previous Signal
+class ConditionVariableSignal
+{
+public:
+    void signal() noexcept
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_value = true;
+        }
+        m_changed.notify_all();
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [this] { return m_value; });
+        m_value = false;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    bool m_value = false;
+};
+
+template<typename SignalType>
+double microseconds_per_round_trip()
+{
+    SignalType ping;
+    SignalType pong;
+    std::thread partner([&ping, &pong]
+    {
+        for (int round_trip = 0; round_trip < number_of_round_trips; ++round_trip)
+        {
+            ping.wait();
+            pong.signal();
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round_trip = 0; round_trip < number_of_round_trips; ++round_trip)
+    {
+        ping.signal();
+        pong.wait();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    partner.join();
+    return std::chrono::duration<double, std::micro>(elapsed).count() / number_of_round_trips;
+}
+
+double percentile(std::vector<double> values, double fraction)
+{
+    std::sort(values.begin(), values.end());
+    return values[static_cast<std::size_t>(fraction * (values.size() - 1))];
+}
+
+std::vector<double> dispatcher_wake_up_microseconds()
+{
+    cpp::concurrency::Dispatcher dispatcher;
+    std::vector<double> latencies;
+    latencies.reserve(number_of_wake_ups);
+
+    for (int wake_up = 0; wake_up < number_of_wake_ups; ++wake_up)
+    {
+        // long enough for the dispatcher to go to sleep
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+        std::atomic<bool> done{ false };
+        auto notified_at = std::chrono::steady_clock::now();
+        dispatcher.notify([&latencies, &done, notified_at]() noexcept
+        {
+            latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - notified_at).count());
+            done = true;
+        });
+        while (!done)
+        {
+            std::this_thread::yield();
+        }
+    }
+    return latencies;
+}
+
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "signal ping-pong, condition variable: " << microseconds_per_round_trip<ConditionVariableSignal>() << " us/round trip\n";
+    std::cout << "signal ping-pong, futex:              " << microseconds_per_round_trip<cpp::concurrency::Signal>() << " us/round trip\n";
+
+    auto latencies = dispatcher_wake_up_microseconds();
+    std::cout << "dispatcher wake-up: p50 " << percentile(latencies, 0.5) << " us, p99 " << percentile(latencies, 0.99) << " us\n";
+    return 0;
+}
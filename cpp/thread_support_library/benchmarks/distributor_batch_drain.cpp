@@ -0,0 +1,92 @@
+// Throughput of distributor with one item per lock round trip and in batch mode (drain_batches)
+// with up to 8 and 64 items per round trip, for 1, 2 and 4 consumers and 2 producers.
+//
+// The producers push 400000 small items between them, a consumer only sums them up: the work per
+// item is far cheaper than the lock. The queue holds 256 items per consumer. Reports million items
+// per second.
+//
+// Build with the thread_support_library and async_dispatcher_tryout directories on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I.. /I..\async_dispatcher_tryout distributor_batch_drain.cpp
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <simple_concurrent_queue.h>
+
+namespace
+{
+
+constexpr std::uint64_t number_of_items = 400000;
+constexpr unsigned int number_of_producers = 2;
+constexpr std::size_t items_per_consumer = 256;
+
+template<typename Distributor>
+double million_items_per_second(Distributor& distributor, const std::atomic<std::uint64_t>& processed)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned int producer = 0; producer < number_of_producers; ++producer)
+    {
+        threads.emplace_back([&distributor]
+        {
+            for (std::uint64_t item = 0; item < number_of_items / number_of_producers; ++item)
+            {
+                distributor(1);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    while (processed.load() < number_of_items)
+    {
+        std::this_thread::yield();
+    }
+    return number_of_items / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 1e6;
+}
+
+double per_item(unsigned int consumers)
+{
+    std::atomic<std::uint64_t> processed{ 0 };
+    distributor<std::uint64_t> distributor([&processed](std::uint64_t& item)
+    {
+        processed.fetch_add(item, std::memory_order_relaxed);
+    }, consumers, items_per_consumer);
+    return million_items_per_second(distributor, processed);
+}
+
+double batched(unsigned int consumers, std::size_t max_items)
+{
+    std::atomic<std::uint64_t> processed{ 0 };
+    distributor<std::uint64_t> distributor(drain_batches{ max_items }, [&processed](item_span<std::uint64_t> items)
+    {
+        std::uint64_t sum = 0;
+        for (auto item : items)
+        {
+            sum += item;
+        }
+        processed.fetch_add(sum, std::memory_order_relaxed);
+    }, consumers, items_per_consumer);
+    return million_items_per_second(distributor, processed);
+}
+
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "consumers  per item  batch 8  batch 64  (million items/s)\n";
+    for (unsigned int consumers : { 1u, 2u, 4u })
+    {
+        std::cout << std::setw(9) << consumers
+            << std::setw(10) << per_item(consumers)
+            << std::setw(9) << batched(consumers, 8)
+            << std::setw(10) << batched(consumers, 64) << '\n';
+    }
+    return 0;
+}
@@ -0,0 +1,401 @@
+// One Google Benchmark suite for every executor and queue in the repo, run with the same workloads:
+//  - PingPong:     round trip of one task to the executor thread and back
+//  - FanIn:        1 and 4 producers post 100000 tasks between them, until all have run
+//  - TimerStorm:   10000 one-shot timers due in the next 5 ms, until all have fired
+//  - CancelStorm:  10000 timers due in 10 s, scheduled and cancelled again
+//  - LongTail:     10000 tasks, every 100th one busy for 200 us; reports the p50 and p99 queue
+//                  latency of all tasks as counters
+//
+// The executors are cpp::concurrency::Dispatcher (DispatcherImpl), cpp::concurrency::PoolDispatcher
+// (WorkStealingDispatcherImpl), TaskExecution::Dispatcher, distributor and ring_distributor (from
+// simple_concurrent_queue.h, 64 queued items per consumer) and, for PingPong and FanIn only,
+// RingBuffer from experimental/Codility. The distributors and RingBuffer have no timers. RingBuffer
+// overwrites its oldest item when full, so in FanIn it gets room for every item.
+//
+// For results a CI job can compare, write JSON:
+//   executor_suite --benchmark_out=executor_suite.json --benchmark_out_format=json
+// and e.g. compare two runs with tools/compare.py from Google Benchmark.
+//
+// Built by the CMakeLists.txt of thread_support_library when Google Benchmark is found, or by hand
+// with the thread_support_library, async_dispatcher_tryout and experimental/Codility/Codility
+// directories on the include path, together with Dispatcher.cpp, e.g.
+//   g++ -std=c++17 -O2 -I.. -I../async_dispatcher_tryout -I../../../experimental/Codility/Codility
+//       executor_suite.cpp ../async_dispatcher_tryout/Dispatcher.cpp -lbenchmark -pthread
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <cpplib/concurrency/dispatcher.h>
+#include <simple_concurrent_queue.h>
+#include "inc/Dispatcher.h"
+#include "RingBuffer.h"
+
+namespace
+{
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr std::uint64_t fan_in_tasks = 100000;
+constexpr std::size_t storm_timers = 10000;
+constexpr std::size_t long_tail_tasks = 10000;
+constexpr std::size_t long_tail_every = 100;
+constexpr auto long_tail_duration = std::chrono::microseconds(200);
+
+// The executors behind the same operations: post runs a task later, drain waits until every task
+// posted so far has run, round_trip runs a task and waits for it, schedule_at and cancel are timers.
+template<typename IMPL>
+struct ConcurrencyExecutor
+{
+    cpp::concurrency::DispatcherWithContext<cpp::concurrency::details::NullDispatcherContext, IMPL> dispatcher;
+
+    template<typename Fn>
+    void post(Fn fn)
+    {
+        dispatcher.notify(fn);
+    }
+
+    void drain()
+    {
+        dispatcher.synchronize();
+    }
+
+    template<typename Fn>
+    void round_trip(Fn fn)
+    {
+        dispatcher.call(fn);
+    }
+
+    template<typename Fn>
+    std::shared_ptr<cpp::concurrency::DispatcherTaskItf> schedule_at(clock_type::time_point at, Fn fn)
+    {
+        return dispatcher.call_at(at, fn);
+    }
+
+    void cancel(const std::shared_ptr<cpp::concurrency::DispatcherTaskItf>& timer)
+    {
+        timer->cancel();
+    }
+};
+
+using Dispatcher = ConcurrencyExecutor<cpp::concurrency::details::DispatcherImpl<cpp::concurrency::details::NullDispatcherContext>>;
+using PoolDispatcher = ConcurrencyExecutor<cpp::concurrency::details::WorkStealingDispatcherImpl<cpp::concurrency::details::NullDispatcherContext>>;
+
+struct TaskExecutionDispatcher
+{
+    TaskExecution::Dispatcher dispatcher;
+
+    template<typename Fn>
+    void post(Fn fn)
+    {
+        dispatcher.Notify(fn);
+    }
+
+    void drain()
+    {
+        dispatcher.Synchronize();
+    }
+
+    template<typename Fn>
+    void round_trip(Fn fn)
+    {
+        dispatcher.Call(fn);
+    }
+
+    template<typename Fn>
+    TaskExecution::ScheduledCall schedule_at(clock_type::time_point at, Fn fn)
+    {
+        return dispatcher.CallAt(at, fn);
+    }
+
+    void cancel(const TaskExecution::ScheduledCall& call)
+    {
+        dispatcher.Cancel(call);
+    }
+};
+
+// a distributor has no completion, the consumers count the tasks they ran
+template<template<typename> class Queue>
+struct DistributorExecutor
+{
+    std::atomic<std::uint64_t> posted{ 0 };
+    std::atomic<std::uint64_t> done{ 0 };
+    Queue<std::function<void()>> queue{ [this](std::function<void()>& fn)
+    {
+        fn();
+        ++done;
+    }, std::max(2u, std::thread::hardware_concurrency()), 64 };
+
+    template<typename Fn>
+    void post(Fn fn)
+    {
+        ++posted;
+        queue(std::function<void()>(fn));
+    }
+
+    void drain()
+    {
+        while (done != posted)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    template<typename Fn>
+    void round_trip(Fn fn)
+    {
+        post(fn);
+        drain();
+    }
+};
+
+template<typename T>
+using Distributor = distributor<T>;
+template<typename T>
+using RingDistributor = ring_distributor<T>;
+
+template<typename Executor>
+void PingPong(benchmark::State& state)
+{
+    Executor executor;
+    std::uint64_t value = 0;
+    for (auto _ : state)
+    {
+        executor.round_trip([&value]() noexcept { ++value; });
+    }
+    benchmark::DoNotOptimize(value);
+    state.SetItemsProcessed(state.iterations());
+}
+
+template<typename Executor>
+void FanIn(benchmark::State& state)
+{
+    Executor executor;
+    auto producers = static_cast<unsigned int>(state.range(0));
+    std::atomic<std::uint64_t> processed{ 0 };
+    for (auto _ : state)
+    {
+        std::vector<std::thread> threads;
+        for (unsigned int producer = 0; producer < producers; ++producer)
+        {
+            threads.emplace_back([&executor, &processed, producers]
+            {
+                for (std::uint64_t index = 0; index < fan_in_tasks / producers; ++index)
+                {
+                    executor.post([&processed]() noexcept { processed.fetch_add(1, std::memory_order_relaxed); });
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        executor.drain();
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(processed.load()));
+}
+
+std::vector<clock_type::duration> random_delays(std::size_t count, clock_type::duration maximum)
+{
+    std::mt19937 random(42);
+    std::uniform_int_distribution<clock_type::rep> distribution(0, maximum.count());
+    std::vector<clock_type::duration> delays;
+    for (std::size_t index = 0; index < count; ++index)
+    {
+        delays.push_back(clock_type::duration(distribution(random)));
+    }
+    return delays;
+}
+
+template<typename Executor>
+void TimerStorm(benchmark::State& state)
+{
+    Executor executor;
+    auto delays = random_delays(storm_timers, std::chrono::milliseconds(5));
+    for (auto _ : state)
+    {
+        std::atomic<std::size_t> fired{ 0 };
+        auto fire = [&fired]() noexcept { ++fired; };
+        std::vector<decltype(executor.schedule_at(clock_type::now(), fire))> timers;
+        timers.reserve(storm_timers);
+        auto start = clock_type::now();
+        for (auto delay : delays)
+        {
+            timers.push_back(executor.schedule_at(start + delay, fire));
+        }
+        while (fired != storm_timers)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * storm_timers));
+}
+
+template<typename Executor>
+void CancelStorm(benchmark::State& state)
+{
+    Executor executor;
+    auto delays = random_delays(storm_timers, std::chrono::seconds(1));
+    for (auto _ : state)
+    {
+        auto nothing = []() noexcept {};
+        std::vector<decltype(executor.schedule_at(clock_type::now(), nothing))> timers;
+        timers.reserve(storm_timers);
+        auto start = clock_type::now() + std::chrono::seconds(10);
+        for (auto delay : delays)
+        {
+            timers.push_back(executor.schedule_at(start + delay, nothing));
+        }
+        for (auto& timer : timers)
+        {
+            executor.cancel(timer);
+        }
+        executor.drain();
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * storm_timers));
+}
+
+template<typename Executor>
+void LongTail(benchmark::State& state)
+{
+    Executor executor;
+    std::vector<double> latencies;
+    std::vector<double> iteration_latencies(long_tail_tasks);
+    for (auto _ : state)
+    {
+        for (std::size_t index = 0; index < long_tail_tasks; ++index)
+        {
+            auto posted = clock_type::now();
+            auto slow = (index % long_tail_every) == 0;
+            executor.post([&iteration_latencies, index, posted, slow]() noexcept
+            {
+                auto start = clock_type::now();
+                iteration_latencies[index] = std::chrono::duration<double, std::micro>(start - posted).count();
+                while (slow && (clock_type::now() - start < long_tail_duration))
+                {
+                }
+            });
+        }
+        executor.drain();
+        latencies.insert(latencies.end(), iteration_latencies.begin(), iteration_latencies.end());
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    state.counters["p50_us"] = latencies[latencies.size() / 2];
+    state.counters["p99_us"] = latencies[latencies.size() * 99 / 100];
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * long_tail_tasks));
+}
+
+// RingBuffer is a queue, not an executor: an echo thread answers the ping-pong, the benchmark thread
+// consumes the fan-in. get returns 0 when the buffer is empty, so 0 is never sent.
+void PingPong_RingBuffer(benchmark::State& state)
+{
+    RingBuffer<std::uint32_t> request(1);
+    RingBuffer<std::uint32_t> reply(1);
+    constexpr std::uint32_t stop = ~std::uint32_t(0);
+    std::thread echo([&request, &reply]
+    {
+        for (;;)
+        {
+            auto value = request.get();
+            if (value == stop)
+            {
+                return;
+            }
+            if (value == 0)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            reply.put(value);
+        }
+    });
+
+    std::uint32_t value = 0;
+    for (auto _ : state)
+    {
+        value = (value % (stop - 1)) + 1;
+        request.put(value);
+        while (reply.get() == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    request.put(stop);
+    echo.join();
+    state.SetItemsProcessed(state.iterations());
+}
+
+void FanIn_RingBuffer(benchmark::State& state)
+{
+    auto producers = static_cast<unsigned int>(state.range(0));
+    RingBuffer<std::uint32_t> buffer(fan_in_tasks);
+    std::uint64_t processed = 0;
+    for (auto _ : state)
+    {
+        std::vector<std::thread> threads;
+        for (unsigned int producer = 0; producer < producers; ++producer)
+        {
+            threads.emplace_back([&buffer, producers]
+            {
+                for (std::uint64_t index = 0; index < fan_in_tasks / producers; ++index)
+                {
+                    buffer.put(1);
+                }
+            });
+        }
+        for (std::uint64_t received = 0; received < (fan_in_tasks / producers) * producers;)
+        {
+            auto value = buffer.get();
+            if (value == 0)
+            {
+                std::this_thread::yield();
+            }
+            received += value;
+        }
+        processed += (fan_in_tasks / producers) * producers;
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(processed));
+}
+
+}
+
+BENCHMARK_TEMPLATE(PingPong, Dispatcher)->UseRealTime();
+BENCHMARK_TEMPLATE(PingPong, PoolDispatcher)->UseRealTime();
+BENCHMARK_TEMPLATE(PingPong, TaskExecutionDispatcher)->UseRealTime();
+BENCHMARK_TEMPLATE(PingPong, DistributorExecutor<Distributor>)->UseRealTime();
+BENCHMARK_TEMPLATE(PingPong, DistributorExecutor<RingDistributor>)->UseRealTime();
+BENCHMARK(PingPong_RingBuffer)->UseRealTime();
+
+BENCHMARK_TEMPLATE(FanIn, Dispatcher)->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK_TEMPLATE(FanIn, PoolDispatcher)->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK_TEMPLATE(FanIn, TaskExecutionDispatcher)->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK_TEMPLATE(FanIn, DistributorExecutor<Distributor>)->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK_TEMPLATE(FanIn, DistributorExecutor<RingDistributor>)->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK(FanIn_RingBuffer)->Arg(1)->Arg(4)->UseRealTime();
+
+BENCHMARK_TEMPLATE(TimerStorm, Dispatcher)->UseRealTime();
+BENCHMARK_TEMPLATE(TimerStorm, PoolDispatcher)->UseRealTime();
+BENCHMARK_TEMPLATE(TimerStorm, TaskExecutionDispatcher)->UseRealTime();
+
+BENCHMARK_TEMPLATE(CancelStorm, Dispatcher)->UseRealTime();
+BENCHMARK_TEMPLATE(CancelStorm, PoolDispatcher)->UseRealTime();
+BENCHMARK_TEMPLATE(CancelStorm, TaskExecutionDispatcher)->UseRealTime();
+
+BENCHMARK_TEMPLATE(LongTail, Dispatcher)->UseRealTime();
+BENCHMARK_TEMPLATE(LongTail, PoolDispatcher)->UseRealTime();
+BENCHMARK_TEMPLATE(LongTail, TaskExecutionDispatcher)->UseRealTime();
+BENCHMARK_TEMPLATE(LongTail, DistributorExecutor<Distributor>)->UseRealTime();
+BENCHMARK_TEMPLATE(LongTail, DistributorExecutor<RingDistributor>)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,164 @@
+// TaskExecution::Dispatcher (one mutex, std::queue of std::function) against
+// cpp::concurrency::Dispatcher, on the same machine and with the same work.
+//
+// Throughput: 1, 2 and 4 producers post 1000000 notifications between them, each one adds to a
+// counter, until Synchronize()/synchronize() returns. Reports million notifications per second.
+// Latency: 100000 synchronous calls returning an int, one after the other from the same thread.
+// Reports the 50th, 99th and 99.9th percentile of the round trip in microseconds.
+//
+// Built by the CMakeLists.txt of thread_support_library, or by hand with the async_dispatcher_tryout
+// directory on the include path, together with Dispatcher.cpp, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout task_execution_dispatcher.cpp ..\async_dispatcher_tryout\Dispatcher.cpp
+//   g++ -std=c++17 -O2 -I../async_dispatcher_tryout task_execution_dispatcher.cpp ../async_dispatcher_tryout/Dispatcher.cpp -pthread
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <cpplib/concurrency/dispatcher.h>
+#include "inc/Dispatcher.h"
+
+namespace
+{
+
+constexpr std::uint64_t number_of_notifications = 1000000;
+constexpr int number_of_calls = 100000;
+
+// the two dispatchers behind the same three operations
+struct TaskExecutionDispatcher
+{
+    TaskExecution::Dispatcher dispatcher;
+
+    template<typename Fn>
+    void notify(Fn fn)
+    {
+        dispatcher.Notify(fn);
+    }
+
+    template<typename Fn>
+    auto call(Fn fn) -> decltype(fn())
+    {
+        return dispatcher.Call(fn);
+    }
+
+    void synchronize()
+    {
+        dispatcher.Synchronize();
+    }
+};
+
+struct ConcurrencyDispatcher
+{
+    cpp::concurrency::Dispatcher dispatcher;
+
+    template<typename Fn>
+    void notify(Fn fn)
+    {
+        dispatcher.notify(fn);
+    }
+
+    template<typename Fn>
+    auto call(Fn fn) -> decltype(fn())
+    {
+        return dispatcher.call(fn);
+    }
+
+    void synchronize()
+    {
+        dispatcher.synchronize();
+    }
+};
+
+template<typename Dispatcher>
+double million_notifications_per_second(unsigned int producers)
+{
+    Dispatcher dispatcher;
+    std::uint64_t processed = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (unsigned int producer = 0; producer < producers; ++producer)
+    {
+        threads.emplace_back([&dispatcher, &processed, producers]
+        {
+            for (std::uint64_t index = 0; index < number_of_notifications / producers; ++index)
+            {
+                dispatcher.notify([&processed]() noexcept { ++processed; });
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    dispatcher.synchronize();
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return dispatcher.call([&processed] { return processed; }) / elapsed / 1e6;
+}
+
+template<typename Dispatcher>
+std::vector<double> call_latency_percentiles(std::initializer_list<double> percentiles)
+{
+    Dispatcher dispatcher;
+    for (int warm_up = 0; warm_up < 1000; ++warm_up)
+    {
+        dispatcher.call([warm_up] { return warm_up; });
+    }
+
+    std::vector<double> round_trips;
+    round_trips.reserve(number_of_calls);
+    long long sum = 0;
+    for (int index = 0; index < number_of_calls; ++index)
+    {
+        auto start = std::chrono::steady_clock::now();
+        sum += dispatcher.call([index] { return index; });
+        round_trips.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(round_trips.begin(), round_trips.end());
+
+    std::vector<double> result;
+    for (auto percentile : percentiles)
+    {
+        result.push_back(round_trips[static_cast<std::size_t>(percentile / 100 * (round_trips.size() - 1))]);
+    }
+    if (sum == 0)
+    {
+        std::cout << "!";
+    }
+    return result;
+}
+
+template<typename Dispatcher>
+void print_latencies(const char* name)
+{
+    std::cout << std::left << std::setw(24) << name << std::right;
+    for (auto latency : call_latency_percentiles<Dispatcher>({ 50, 99, 99.9 }))
+    {
+        std::cout << std::setw(10) << latency;
+    }
+    std::cout << '\n';
+}
+
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "producers  TaskExecution  cpp::concurrency  (million notifications/s)\n";
+    for (unsigned int producers : { 1u, 2u, 4u })
+    {
+        std::cout << std::setw(9) << producers
+            << std::setw(15) << million_notifications_per_second<TaskExecutionDispatcher>(producers)
+            << std::setw(18) << million_notifications_per_second<ConcurrencyDispatcher>(producers) << '\n';
+    }
+
+    std::cout << "\ncall round trip (us)          p50       p99     p99.9\n";
+    print_latencies<TaskExecutionDispatcher>("TaskExecution");
+    print_latencies<ConcurrencyDispatcher>("cpp::concurrency");
+    return 0;
+}
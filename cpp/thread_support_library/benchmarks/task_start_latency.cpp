@@ -0,0 +1,100 @@
+// Start latency of cpp::concurrency tasks.
+//
+// Starts 2000 short tasks one after the other and measures how long start() takes (it returns once the
+// task runs) and the time from start until the result is available. "std::async" starts the function the
+// way Task::start did before, with a new thread per task; "task pool" uses make_task/start, which run
+// on the shared TaskThreadPool.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout task_start_latency.cpp
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <cpplib/concurrency/task.h>
+
+namespace
+{
+
+constexpr int number_of_tasks = 2000;
+
+struct Latencies
+{
+    std::vector<double> start_us;
+    std::vector<double> result_us;
+};
+
+double microseconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+Latencies run_std_async()
+{
+    Latencies latencies;
+    for (int task = 0; task < number_of_tasks; ++task)
+    {
+        std::atomic<bool> running{ false };
+        auto start = std::chrono::steady_clock::now();
+        auto future = std::async(std::launch::async, [&running]
+        {
+            running = true;
+            return 42;
+        });
+        while (!running)
+        {
+            std::this_thread::yield();
+        }
+        latencies.start_us.push_back(microseconds_since(start));
+        future.get();
+        latencies.result_us.push_back(microseconds_since(start));
+    }
+    return latencies;
+}
+
+Latencies run_task_pool()
+{
+    Latencies latencies;
+    for (int task = 0; task < number_of_tasks; ++task)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto started = cpp::concurrency::start_task(L"benchmark", cpp::concurrency::NullTaskReporting::instance(), [](const cpp::concurrency::TaskSignal&)
+        {
+            return 42;
+        });
+        latencies.start_us.push_back(microseconds_since(start));
+        started->get();
+        latencies.result_us.push_back(microseconds_since(start));
+    }
+    return latencies;
+}
+
+double percentile(std::vector<double> values, double fraction)
+{
+    std::sort(values.begin(), values.end());
+    return values[static_cast<std::size_t>(fraction * (values.size() - 1))];
+}
+
+void print(const char* name, const Latencies& latencies)
+{
+    std::cout << std::left << std::setw(12) << name << std::right
+        << std::setw(14) << percentile(latencies.start_us, 0.5)
+        << std::setw(14) << percentile(latencies.start_us, 0.99)
+        << std::setw(14) << percentile(latencies.result_us, 0.5)
+        << std::setw(14) << percentile(latencies.result_us, 0.99) << std::endl;
+}
+
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "            start p50 us  start p99 us    get p50 us    get p99 us\n";
+    print("std::async", run_std_async());
+    print("task pool", run_task_pool());
+    return 0;
+}
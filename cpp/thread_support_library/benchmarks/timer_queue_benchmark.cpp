@@ -0,0 +1,185 @@
+// Compares the timer structures used for call_every/call_at scheduling:
+//  - binary heap (std::priority_queue), as DispatcherImpl used, cancellation by flag
+//  - sorted vector with lower_bound + insert, as TaskExecution::Dispatcher used
+//  - hierarchical timing wheel (cpp::concurrency::details::TimingWheel)
+//
+// Every run inserts N timers with random expiries in the next 10 seconds, cancels half of them
+// and then advances a simulated clock in 1 ms steps until all remaining timers fired.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   cl /std:c++17 /O2 /EHsc /I..\async_dispatcher_tryout timer_queue_benchmark.cpp
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <random>
+#include <vector>
+#include <cpplib/concurrency/details/timing_wheel.h>
+
+namespace
+{
+
+using clock_type = std::chrono::steady_clock;
+
+struct Timer
+{
+    clock_type::time_point at;
+    unsigned int id;
+    bool cancelled;
+};
+
+struct Result
+{
+    double insert_ns;
+    double cancel_ns;
+    double fire_ns;
+    std::size_t fired;
+};
+
+double ns_per_item(clock_type::duration elapsed, std::size_t items)
+{
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(items);
+}
+
+std::vector<clock_type::duration> make_delays(std::size_t count)
+{
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> distribution(1, 10000);
+    std::vector<clock_type::duration> delays;
+    for (std::size_t index = 0; index < count; ++index)
+    {
+        delays.push_back(std::chrono::milliseconds(distribution(random)));
+    }
+    return delays;
+}
+
+Result run_heap(const std::vector<clock_type::duration>& delays, clock_type::time_point start)
+{
+    auto compare = [](const std::shared_ptr<Timer>& lhs, const std::shared_ptr<Timer>& rhs) { return lhs->at > rhs->at; };
+    std::priority_queue<std::shared_ptr<Timer>, std::vector<std::shared_ptr<Timer>>, decltype(compare)> heap(compare);
+    std::vector<std::shared_ptr<Timer>> handles;
+    Result result{};
+
+    auto t0 = clock_type::now();
+    for (unsigned int id = 0; id < delays.size(); ++id)
+    {
+        auto timer = std::make_shared<Timer>(Timer{ start + delays[id], id, false });
+        handles.push_back(timer);
+        heap.push(timer);
+    }
+    auto t1 = clock_type::now();
+    for (std::size_t index = 0; index < handles.size(); index += 2)
+    {
+        handles[index]->cancelled = true;
+    }
+    auto t2 = clock_type::now();
+    for (auto now = start; !heap.empty(); now += std::chrono::milliseconds(1))
+    {
+        while (!heap.empty() && (heap.top()->at <= now))
+        {
+            result.fired += heap.top()->cancelled ? 0 : 1;
+            heap.pop();
+        }
+    }
+    auto t3 = clock_type::now();
+
+    result.insert_ns = ns_per_item(t1 - t0, delays.size());
+    result.cancel_ns = ns_per_item(t2 - t1, delays.size() / 2);
+    result.fire_ns = ns_per_item(t3 - t2, delays.size());
+    return result;
+}
+
+Result run_sorted_vector(const std::vector<clock_type::duration>& delays, clock_type::time_point start)
+{
+    std::vector<Timer> timers;
+    Result result{};
+
+    auto t0 = clock_type::now();
+    for (unsigned int id = 0; id < delays.size(); ++id)
+    {
+        Timer timer{ start + delays[id], id, false };
+        auto it = std::lower_bound(timers.begin(), timers.end(), timer, [](const Timer& a, const Timer& b) { return a.at > b.at; });
+        timers.insert(it, timer);
+    }
+    auto t1 = clock_type::now();
+    for (unsigned int id = 0; id < delays.size(); id += 2)
+    {
+        auto it = std::find_if(timers.begin(), timers.end(), [id](const Timer& timer) { return timer.id == id; });
+        timers.erase(it);
+    }
+    auto t2 = clock_type::now();
+    for (auto now = start; !timers.empty(); now += std::chrono::milliseconds(1))
+    {
+        while (!timers.empty() && (timers.back().at <= now))
+        {
+            ++result.fired;
+            timers.pop_back();
+        }
+    }
+    auto t3 = clock_type::now();
+
+    result.insert_ns = ns_per_item(t1 - t0, delays.size());
+    result.cancel_ns = ns_per_item(t2 - t1, delays.size() / 2);
+    result.fire_ns = ns_per_item(t3 - t2, delays.size());
+    return result;
+}
+
+Result run_timing_wheel(const std::vector<clock_type::duration>& delays, clock_type::time_point start)
+{
+    cpp::concurrency::details::TimingWheel<unsigned int> wheel(std::chrono::milliseconds(1), start);
+    std::vector<cpp::concurrency::details::TimingWheel<unsigned int>::handle> handles;
+    Result result{};
+
+    auto t0 = clock_type::now();
+    for (unsigned int id = 0; id < delays.size(); ++id)
+    {
+        handles.push_back(wheel.insert(start + delays[id], id));
+    }
+    auto t1 = clock_type::now();
+    for (std::size_t index = 0; index < handles.size(); index += 2)
+    {
+        wheel.cancel(handles[index]);
+    }
+    auto t2 = clock_type::now();
+    for (auto now = start; !wheel.empty(); now += std::chrono::milliseconds(1))
+    {
+        wheel.advance(now, [&result](unsigned int) { ++result.fired; });
+    }
+    auto t3 = clock_type::now();
+
+    result.insert_ns = ns_per_item(t1 - t0, delays.size());
+    result.cancel_ns = ns_per_item(t2 - t1, delays.size() / 2);
+    result.fire_ns = ns_per_item(t3 - t2, delays.size());
+    return result;
+}
+
+void print(const char* name, std::size_t count, const Result& result)
+{
+    std::cout << std::left << std::setw(14) << name << std::right
+        << std::setw(8) << count
+        << std::setw(12) << result.insert_ns
+        << std::setw(12) << result.cancel_ns
+        << std::setw(12) << result.fire_ns
+        << std::setw(10) << result.fired << std::endl;
+}
+
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "structure      timers   insert/ns   cancel/ns     fire/ns     fired\n";
+    for (std::size_t count : { 1000, 10000, 50000 })
+    {
+        auto delays = make_delays(count);
+        auto start = clock_type::now();
+        print("heap", count, run_heap(delays, start));
+        print("sorted vector", count, run_sorted_vector(delays, start));
+        print("timing wheel", count, run_timing_wheel(delays, start));
+    }
+    return 0;
+}
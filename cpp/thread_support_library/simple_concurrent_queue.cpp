@@ -1,103 +1,46 @@
-// reference: https://blind.guru/simple_cxx11_workqueue.html
+#include "simple_concurrent_queue.h"
 
-#include <condition_variable>
-#include <mutex>
-#include <queue>
-#include <stdexcept>
-#include <thread>
-#include <vector>
+// Client example
 
-template <typename Type, typename Queue = std::queue<Type>>
-class distributor: Queue, std::mutex, std::condition_variable
-{
-private:
-   typename Queue::size_type capacity;
-   bool done = false;
-   std::vector<std::thread> threads;
+#include <iostream>
 
-public:
-   template<typename Function>
-   distributor(Function function,
-               unsigned int concurrency = std::thread::hardware_concurrency(),
-               typename Queue::size_type max_items_per_thread = 1) :
-   capacity { concurrency * max_items_per_thread }
+int main()
+{
+   typedef std::string item_type;
+   distributor<item_type> data_scheduler([](item_type &item)
    {
-      if (not concurrency)
-         throw std::invalid_argument("Concurrency must be non-zero");
-      if (not max_items_per_thread)
-         throw std::invalid_argument("Max items per thread must be non-zero");
-
-      for (unsigned int count = 0; count < concurrency; count ++)
-         threads.emplace_back(static_cast<void (distributor::*)(Function)>
-            (&distributor::consume), this, function);
-   }
-
-   distributor(distributor &&) = default;
-   distributor &operator=(distributor &&) = delete;
+      std::cout << "MSG : [" << item << "] received" << std::endl;
+   });
 
-   ~distributor()
+   std::vector<item_type> input_data = { "Hello", "World" };
+   while (not input_data.empty())
    {
-      {
-         std::lock_guard<std::mutex> guard(*this);
-         done = true;
-         notify_all();
-      }
-      for (auto&& thread : threads)
-         thread.join();
+      data_scheduler(std::move(input_data.back()));
+      input_data.pop_back();
    }
 
-   void operator()(Type &&value)
+   distributor<item_type> batch_scheduler(drain_batches { 16 }, [](item_span<item_type> items)
    {
-      std::unique_lock<std::mutex> lock(*this);
-      while (Queue::size() == capacity) wait(lock);
-      Queue::push(std::forward<Type>(value));
-      notify_one();
-   }
+      for (auto &item : items)
+         std::cout << "BATCH MSG : [" << item << "] received" << std::endl;
+   });
 
-private:
-   template <typename Function>
-   void consume(Function process)
+   input_data = { "Hello", "World" };
+   while (not input_data.empty())
    {
-      std::unique_lock<std::mutex> lock(*this);
-      while (true)
-      {
-         if (!Queue::empty())
-         {
-            Type item { std::move(Queue::front()) };
-            Queue::pop();
-            notify_one();
-            lock.unlock();
-            process(item);
-            lock.lock();
-         }
-         else if (done)
-         {
-            break;
-         }
-         else
-         {
-            wait(lock);
-         }
-      }
+      batch_scheduler(std::move(input_data.back()));
+      input_data.pop_back();
    }
-};
-
-// Client example
-
-#include <iostream>
 
-int main()
-{
-   typedef std::string item_type;
-   distributor<item_type> data_scheduler([](item_type &item)
+   ring_distributor<item_type> ring_scheduler([](item_type &item)
    {
-      std::cout << "MSG : [" << item << "] received" << std::endl;
+      std::cout << "RING MSG : [" << item << "] received" << std::endl;
    });
 
-   std::vector<item_type> input_data = { "Hello", "World" };
-   while (data_scheduler.size() < input_data.size())
+   input_data = { "Hello", "World" };
+   while (not input_data.empty())
    {
-      data_scheduler(std::move(input_data.back()));
+      ring_scheduler(std::move(input_data.back()));
       input_data.pop_back();
    }
 
@@ -0,0 +1,496 @@
+#pragma once
+
+// reference: https://blind.guru/simple_cxx11_workqueue.html
+// ring_distributor: bounded MPMC queue after http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cpplib/concurrency/thread_placement.h>
+
+// Starts the consumer threads, each one applies the placement to itself first. When a thread cannot
+// be placed or cannot be started at all, stop makes the started ones return, they are joined and the
+// error is rethrown. A distributor has one shared queue, so first_touch has no effect.
+template <typename Consume, typename Stop>
+void start_consumers(std::vector<std::thread> &threads,
+                     unsigned int concurrency,
+                     const cpp::concurrency::ThreadPlacement &placement,
+                     Consume consume,
+                     Stop stop)
+{
+   auto stop_started = [&threads, &stop]
+   {
+      stop();
+      for (auto &&thread : threads)
+         thread.join();
+   };
+
+   std::vector<std::future<void>> placed;
+   try
+   {
+      for (unsigned int count = 0; count < concurrency; count ++)
+      {
+         std::promise<void> promise;
+         placed.push_back(promise.get_future());
+         threads.emplace_back([promise = std::move(promise), &placement, consume, count, concurrency]() mutable
+         {
+            try
+            {
+               cpp::concurrency::details::apply_thread_placement(placement, count, concurrency);
+               promise.set_value();
+            }
+            catch (...)
+            {
+               promise.set_exception(std::current_exception());
+               return;
+            }
+            consume();
+         });
+      }
+   }
+   catch (...)
+   {
+      stop_started();
+      throw;
+   }
+
+   std::exception_ptr error;
+   for (auto &&result : placed)
+   {
+      try
+      {
+         result.get();
+      }
+      catch (...)
+      {
+         error = std::current_exception();
+      }
+   }
+   if (error)
+   {
+      stop_started();
+      std::rethrow_exception(error);
+   }
+}
+
+// the items a batch consumer gets at once, moved out of the queue. Valid during the call only.
+template <typename Type>
+struct item_span
+{
+   Type *first;
+   std::size_t count;
+
+   Type *begin() const { return first; }
+   Type *end() const { return first + count; }
+   std::size_t size() const { return count; }
+   Type &operator[](std::size_t index) const { return first[index]; }
+};
+
+// selects the batch mode of distributor: a worker takes up to max_items per lock
+struct drain_batches
+{
+   std::size_t max_items;
+};
+
+template <typename Type, typename Queue = std::queue<Type>>
+class distributor: Queue, std::mutex, std::condition_variable
+{
+private:
+   typename Queue::size_type capacity;
+   bool done = false;
+   std::vector<std::thread> threads;
+
+public:
+   // placement pins and names the consumer threads, see cpp::concurrency::ThreadPlacement
+   template<typename Function>
+   distributor(Function function,
+               unsigned int concurrency = std::thread::hardware_concurrency(),
+               typename Queue::size_type max_items_per_thread = 1,
+               const cpp::concurrency::ThreadPlacement &placement = {}) :
+   capacity { concurrency * max_items_per_thread }
+   {
+      if (not concurrency)
+         throw std::invalid_argument("Concurrency must be non-zero");
+      if (not max_items_per_thread)
+         throw std::invalid_argument("Max items per thread must be non-zero");
+
+      start_consumers(threads, concurrency, placement,
+         [this, function] { consume(function); },
+         [this] { stop(); });
+   }
+
+   // batch mode: a worker moves up to batch.max_items items into a local batch per lock round trip
+   // and calls function with an item_span<Type> of them
+   template<typename Function>
+   distributor(drain_batches batch,
+               Function function,
+               unsigned int concurrency = std::thread::hardware_concurrency(),
+               typename Queue::size_type max_items_per_thread = 1,
+               const cpp::concurrency::ThreadPlacement &placement = {}) :
+   capacity { concurrency * max_items_per_thread }
+   {
+      if (not concurrency)
+         throw std::invalid_argument("Concurrency must be non-zero");
+      if (not max_items_per_thread)
+         throw std::invalid_argument("Max items per thread must be non-zero");
+      if (not batch.max_items)
+         throw std::invalid_argument("Max items per batch must be non-zero");
+
+      auto max_items = batch.max_items;
+      start_consumers(threads, concurrency, placement,
+         [this, function, max_items] { consume_batches(function, max_items); },
+         [this] { stop(); });
+   }
+
+   distributor(distributor &&) = default;
+   distributor &operator=(distributor &&) = delete;
+
+   ~distributor()
+   {
+      stop();
+      for (auto&& thread : threads)
+         thread.join();
+   }
+
+   void operator()(Type &&value)
+   {
+      std::unique_lock<std::mutex> lock(*this);
+      while (Queue::size() == capacity) wait(lock);
+      Queue::push(std::forward<Type>(value));
+      notify_one();
+   }
+
+private:
+   void stop()
+   {
+      std::lock_guard<std::mutex> guard(*this);
+      done = true;
+      notify_all();
+   }
+
+   template <typename Function>
+   void consume(Function process)
+   {
+      std::unique_lock<std::mutex> lock(*this);
+      while (true)
+      {
+         if (!Queue::empty())
+         {
+            Type item { std::move(Queue::front()) };
+            Queue::pop();
+            notify_one();
+            lock.unlock();
+            process(item);
+            lock.lock();
+         }
+         else if (done)
+         {
+            break;
+         }
+         else
+         {
+            wait(lock);
+         }
+      }
+   }
+
+   template <typename Function>
+   void consume_batches(Function process, std::size_t max_items)
+   {
+      std::vector<Type> batch;
+      batch.reserve(max_items);
+
+      std::unique_lock<std::mutex> lock(*this);
+      while (true)
+      {
+         if (!Queue::empty())
+         {
+            while (!Queue::empty() && batch.size() < max_items)
+            {
+               batch.push_back(std::move(Queue::front()));
+               Queue::pop();
+            }
+            // as many slots as items became free
+            if (batch.size() == 1)
+               notify_one();
+            else
+               notify_all();
+            lock.unlock();
+            process(item_span<Type> { batch.data(), batch.size() });
+            batch.clear();
+            lock.lock();
+         }
+         else if (done)
+         {
+            break;
+         }
+         else
+         {
+            wait(lock);
+         }
+      }
+   }
+};
+
+// Bounded multi producer, multi consumer ring (Dmitry Vyukov). Every cell carries a sequence number:
+// equal to the position when the cell is free for the producer of that position, position + 1 when it
+// holds the item for the consumer of that position. Producers and consumers claim positions with a CAS
+// on their own counter and only meet on the cells, no lock and no allocation per item.
+template <typename Type>
+class mpmc_ring
+{
+private:
+   struct cell
+   {
+      std::atomic<std::size_t> sequence;
+      typename std::aligned_storage<sizeof(Type), alignof(Type)>::type storage;
+   };
+
+   static constexpr std::size_t cache_line = 64;
+
+   const std::size_t mask;
+   const std::unique_ptr<cell[]> cells;
+   alignas(cache_line) std::atomic<std::size_t> enqueue_position { 0 };
+   alignas(cache_line) std::atomic<std::size_t> dequeue_position { 0 };
+
+   static std::size_t round_up_to_power_of_two(std::size_t value)
+   {
+      std::size_t power = 2;
+      while (power < value)
+         power *= 2;
+      return power;
+   }
+
+public:
+   explicit mpmc_ring(std::size_t capacity) :
+   mask { round_up_to_power_of_two(capacity) - 1 },
+   cells { new cell[mask + 1] }
+   {
+      for (std::size_t position = 0; position <= mask; position ++)
+         cells[position].sequence.store(position, std::memory_order_relaxed);
+   }
+
+   mpmc_ring(const mpmc_ring &) = delete;
+   mpmc_ring &operator=(const mpmc_ring &) = delete;
+
+   ~mpmc_ring()
+   {
+      while (try_pop([](Type &) {}))
+      {
+      }
+   }
+
+   // value is moved from only when there was room
+   bool try_push(Type &value)
+   {
+      auto position = enqueue_position.load(std::memory_order_relaxed);
+      for (;;)
+      {
+         auto &slot = cells[position & mask];
+         auto sequence = slot.sequence.load(std::memory_order_acquire);
+         auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+         if (difference == 0)
+         {
+            if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+               new (&slot.storage) Type(std::move(value));
+               slot.sequence.store(position + 1, std::memory_order_release);
+               return true;
+            }
+         }
+         else if (difference < 0)
+         {
+            return false;
+         }
+         else
+         {
+            position = enqueue_position.load(std::memory_order_relaxed);
+         }
+      }
+   }
+
+   // moves the item out of its cell and frees the cell before process runs
+   template <typename Function>
+   bool try_pop(Function &&process)
+   {
+      auto position = dequeue_position.load(std::memory_order_relaxed);
+      for (;;)
+      {
+         auto &slot = cells[position & mask];
+         auto sequence = slot.sequence.load(std::memory_order_acquire);
+         auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+         if (difference == 0)
+         {
+            if (dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+               auto stored = reinterpret_cast<Type *>(&slot.storage);
+               Type item { std::move(*stored) };
+               stored->~Type();
+               slot.sequence.store(position + mask + 1, std::memory_order_release);
+               process(item);
+               return true;
+            }
+         }
+         else if (difference < 0)
+         {
+            return false;
+         }
+         else
+         {
+            position = dequeue_position.load(std::memory_order_relaxed);
+         }
+      }
+   }
+
+   // no item published at the head, a push may be under way
+   bool empty() const
+   {
+      auto position = dequeue_position.load(std::memory_order_seq_cst);
+      return cells[position & mask].sequence.load(std::memory_order_seq_cst) != position + 1;
+   }
+
+   // the cell at the tail is not free yet, a pop may be under way
+   bool full() const
+   {
+      auto position = enqueue_position.load(std::memory_order_seq_cst);
+      return cells[position & mask].sequence.load(std::memory_order_seq_cst) != position;
+   }
+};
+
+// Like distributor, on an mpmc_ring. Pushing and popping take no lock; a producer only waits when the
+// ring is full, a consumer only when it is empty, and the other side only locks to wake them when
+// somebody actually waits. Items are moved in and out, never copied.
+template <typename Type>
+class ring_distributor
+{
+private:
+   mpmc_ring<Type> ring;
+   std::mutex mutex;
+   std::condition_variable not_empty;
+   std::condition_variable not_full;
+   std::atomic<unsigned int> waiting_consumers { 0 };
+   std::atomic<unsigned int> waiting_producers { 0 };
+   std::atomic<bool> done { false };
+   std::vector<std::thread> threads;
+
+   // rounds of trying again before a thread waits, cheaper than sleeping when the other side is busy
+   static constexpr int retries_before_waiting = 64;
+
+public:
+   template<typename Function>
+   ring_distributor(Function function,
+                    unsigned int concurrency = std::thread::hardware_concurrency(),
+                    std::size_t max_items_per_thread = 1,
+                    const cpp::concurrency::ThreadPlacement &placement = {}) :
+   ring { check_arguments(concurrency, max_items_per_thread) * max_items_per_thread }
+   {
+      start_consumers(threads, concurrency, placement,
+         [this, function] { consume(function); },
+         [this] { stop(); });
+   }
+
+   ring_distributor(const ring_distributor &) = delete;
+   ring_distributor &operator=(const ring_distributor &) = delete;
+
+   // the consumers drain the ring before they stop
+   ~ring_distributor()
+   {
+      stop();
+      for (auto&& thread : threads)
+         thread.join();
+   }
+
+   void operator()(Type &&value)
+   {
+      for (int retry = 0; not ring.try_push(value); retry ++)
+      {
+         if (retry < retries_before_waiting)
+         {
+            std::this_thread::yield();
+            continue;
+         }
+         std::unique_lock<std::mutex> lock(mutex);
+         waiting_producers ++;
+         not_full.wait(lock, [this] { return not ring.full(); });
+         waiting_producers --;
+      }
+      wake(waiting_consumers, not_empty);
+   }
+
+private:
+   void stop()
+   {
+      {
+         std::lock_guard<std::mutex> guard(mutex);
+         done = true;
+      }
+      not_empty.notify_all();
+   }
+
+   static unsigned int check_arguments(unsigned int concurrency, std::size_t max_items_per_thread)
+   {
+      if (not concurrency)
+         throw std::invalid_argument("Concurrency must be non-zero");
+      if (not max_items_per_thread)
+         throw std::invalid_argument("Max items per thread must be non-zero");
+      return concurrency;
+   }
+
+   // the waiter registers before it checks the ring under the lock, the waker changes the ring before
+   // it looks for waiters: either the waiter sees the change or the waker sees the waiter
+   void wake(std::atomic<unsigned int> &waiting, std::condition_variable &condition)
+   {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (waiting.load(std::memory_order_seq_cst) != 0)
+      {
+         std::lock_guard<std::mutex> guard(mutex);
+         condition.notify_one();
+      }
+   }
+
+   template <typename Function>
+   void consume(Function process)
+   {
+      auto popped = [this, &process](Type &item)
+      {
+         wake(waiting_producers, not_full);
+         process(item);
+      };
+
+      for (int retry = 0;; retry ++)
+      {
+         if (ring.try_pop(popped))
+         {
+            retry = 0;
+         }
+         else if (done)
+         {
+            if (ring.empty())
+               break;
+         }
+         else if (retry >= retries_before_waiting)
+         {
+            std::unique_lock<std::mutex> lock(mutex);
+            waiting_consumers ++;
+            not_empty.wait(lock, [this] { return not ring.empty() or done; });
+            waiting_consumers --;
+            retry = 0;
+         }
+         else
+         {
+            std::this_thread::yield();
+         }
+      }
+   }
+};
@@ -0,0 +1,132 @@
+// Synchronous calls through details::CallSlot: DispatcherItf::Call and cpp::concurrency::Dispatcher::call
+
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/dispatcher.h>
+#include <cpplib/concurrency/details/call_slot.h>
+#include "inc/DispatcherItf.h"
+
+namespace
+{
+
+using namespace cpp::concurrency::details;
+
+// runs the notifications on another thread, or drops them like a dispatcher that is destroyed.
+// Runs a copy of the notification, or the original while the copy is still alive.
+class InlineDispatcher : public TaskExecution::DispatcherItf
+{
+public:
+    explicit InlineDispatcher(bool run, bool runOriginal = false) : m_run(run), m_runOriginal(runOriginal) {}
+
+    virtual void Notify(const std::function<void()>& fn) const override
+    {
+        std::function<void()> queued(fn);
+        if (m_run && m_runOriginal)
+            std::thread([&fn] { fn(); }).join();
+        else if (m_run)
+            std::thread(std::move(queued)).join();
+    }
+    virtual void NotifyCoalesced(std::uint64_t, const std::function<void()>& fn) const override { Notify(fn); }
+    virtual void Synchronize() const override {}
+    virtual void Cancel(const TaskExecution::ScheduledCall&) const override {}
+    virtual std::chrono::steady_clock::duration TimeUntilNextExecution(const TaskExecution::ScheduledCall&) const override { return {}; }
+    virtual bool IsDispatcherThread() const override { return false; }
+
+protected:
+    virtual TaskExecution::ScheduledCall CallAtSystemClock(const std::chrono::steady_clock::time_point&, const std::function<void()>&) const override { return { *this, 0 }; }
+    virtual TaskExecution::ScheduledCall CallAfterSystemClock(const std::chrono::steady_clock::duration&, const std::function<void()>&) const override { return { *this, 0 }; }
+    virtual TaskExecution::ScheduledCall CallEverySystemClock(const std::chrono::steady_clock::duration&, const std::function<void()>&) const override { return { *this, 0 }; }
+
+private:
+    bool m_run;
+    bool m_runOriginal;
+};
+
+bool is_broken_promise(const std::future_error& error)
+{
+    return error.code() == std::future_errc::broken_promise;
+}
+
+TEST(DispatcherItfCall, ReturnsTheValueAndRethrows)
+{
+    InlineDispatcher dispatcher(true);
+    EXPECT_EQ(42, dispatcher.Call([] { return 42; }));
+    EXPECT_THROW(dispatcher.Call([]() -> int { throw std::runtime_error("call"); }), std::runtime_error);
+    EXPECT_EQ(1, dispatcher.Call([] { return 1; }));
+}
+
+TEST(DispatcherItfCall, DroppedNotificationBreaksThePromise)
+{
+    InlineDispatcher dispatcher(false);
+    try
+    {
+        dispatcher.Call([] { return 1; });
+        FAIL() << "the call did not run and returned";
+    }
+    catch (const std::future_error& error)
+    {
+        EXPECT_TRUE(is_broken_promise(error));
+    }
+
+    // the slot of the thread can be used again
+    InlineDispatcher running(true);
+    EXPECT_EQ(2, running.Call([] { return 2; }));
+}
+
+TEST(DispatcherItfCall, CopiesOfTheNotificationAreRealCopies)
+{
+    // the copy taken first neither steals the call from the original nor breaks the promise when it is dropped
+    InlineDispatcher dispatcher(true, true);
+    EXPECT_EQ(42, dispatcher.Call([] { return 42; }));
+    EXPECT_THROW(dispatcher.Call([]() -> int { throw std::runtime_error("call"); }), std::runtime_error);
+    EXPECT_EQ(1, dispatcher.Call([] { return 1; }));
+}
+
+TEST(CallTask, CompletesTheSlotWithTheException)
+{
+    auto fn = []() -> int { throw std::logic_error("task"); };
+    CallResult<int> result;
+    CallSlot slot;
+    {
+        CallTask<decltype(fn), int> task(fn, result, slot);
+        task();
+    }
+    slot.wait();
+    EXPECT_THROW(slot.rethrow_error(), std::logic_error);
+}
+
+TEST(CallTask, DestroyedWithoutRunningBreaksThePromise)
+{
+    auto fn = [] { return 1; };
+    CallResult<int> result;
+    CallSlot slot;
+    {
+        CallTask<decltype(fn), int> task(fn, result, slot);
+        // the moved-from task does not complete the slot a second time
+        CallTask<decltype(fn), int> moved(std::move(task));
+    }
+    slot.wait();
+    try
+    {
+        slot.rethrow_error();
+        FAIL() << "no error was set";
+    }
+    catch (const std::future_error& error)
+    {
+        EXPECT_TRUE(is_broken_promise(error));
+    }
+}
+
+TEST(ConcurrencyDispatcherCall, ReturnsReferencesValuesAndExceptions)
+{
+    cpp::concurrency::Dispatcher dispatcher;
+    int value = 7;
+    EXPECT_EQ(&value, &dispatcher.call([&value]() -> int& { return value; }));
+    EXPECT_EQ(42, dispatcher.call([] { return 42; }));
+    EXPECT_THROW(dispatcher.call([]() -> int { throw std::runtime_error("call"); }), std::runtime_error);
+    EXPECT_TRUE(dispatcher.call([&dispatcher] { return dispatcher.is_injected_thread(); }));
+}
+
+}
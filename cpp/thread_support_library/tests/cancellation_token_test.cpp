@@ -0,0 +1,153 @@
+// cpp::concurrency::CancellationSource, CancellationToken and CancellationRegistration
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/cancellation_token.h>
+
+namespace
+{
+
+using cpp::concurrency::CancellationRegistration;
+using cpp::concurrency::CancellationSource;
+using cpp::concurrency::CancellationToken;
+using namespace std::chrono_literals;
+
+TEST(CancellationToken, DefaultTokenIsNeverCancelled)
+{
+    CancellationToken token;
+    EXPECT_FALSE(token.can_be_cancelled());
+    EXPECT_FALSE(token.is_cancelled());
+    EXPECT_NO_THROW(token.throw_if_cancelled());
+    EXPECT_FALSE(token.try_wait_for(1ms));
+}
+
+TEST(CancellationToken, CallbacksRunOnceInTheOrderTheyWereAdded)
+{
+    CancellationSource source;
+    auto token = source.token();
+    std::vector<int> order;
+    auto first = token.on_cancel([&order] { order.push_back(1); });
+    auto removed = token.on_cancel([&order] { order.push_back(2); });
+    auto last = token.on_cancel([&order] { order.push_back(3); });
+    removed.reset();
+
+    source.cancel();
+    source.cancel();
+    EXPECT_TRUE(token.is_cancelled());
+    EXPECT_THROW(token.throw_if_cancelled(), cpp::cancelled_exception);
+    EXPECT_EQ((std::vector<int>{ 1, 3 }), order);
+}
+
+TEST(CancellationToken, OnCancelAfterCancelRunsRightAway)
+{
+    CancellationSource source;
+    source.cancel();
+    auto thread = std::this_thread::get_id();
+    std::thread::id ran_on;
+    auto registration = source.token().on_cancel([&ran_on] { ran_on = std::this_thread::get_id(); });
+    EXPECT_EQ(thread, ran_on);
+    // nothing to remove
+    registration.reset();
+}
+
+TEST(CancellationToken, CallbackMayRemoveItsOwnRegistration)
+{
+    CancellationSource source;
+    CancellationRegistration registration;
+    bool ran = false;
+    registration = source.token().on_cancel([&registration, &ran]
+    {
+        ran = true;
+        registration.reset();
+    });
+    source.cancel();
+    EXPECT_TRUE(ran);
+}
+
+TEST(CancellationToken, RemoveWaitsForTheRunningCallback)
+{
+    CancellationSource source;
+    std::atomic<bool> running{ false };
+    std::atomic<bool> finished{ false };
+    auto registration = source.token().on_cancel([&running, &finished]
+    {
+        running = true;
+        std::this_thread::sleep_for(20ms);
+        finished = true;
+    });
+
+    std::thread canceller([&source] { source.cancel(); });
+    while (!running)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+    // the callback uses the stack of this thread, reset must not return before it is done
+    registration.reset();
+    EXPECT_TRUE(finished);
+    canceller.join();
+}
+
+TEST(CancellationToken, WaitWakesOnCancel)
+{
+    CancellationSource source;
+    auto token = source.token();
+    EXPECT_FALSE(token.try_wait_for(10ms));
+
+    std::thread canceller([&source]
+    {
+        std::this_thread::sleep_for(10ms);
+        source.cancel();
+    });
+    EXPECT_TRUE(token.try_wait_for(10s));
+    canceller.join();
+}
+
+TEST(CancellationSource, ChildIsCancelledWithTheParent)
+{
+    CancellationSource parent;
+    CancellationSource child(parent.token());
+    CancellationSource grandchild(child.token());
+
+    parent.cancel();
+    EXPECT_TRUE(child.is_cancelled());
+    EXPECT_TRUE(grandchild.is_cancelled());
+}
+
+TEST(CancellationSource, CancellingTheChildLeavesTheParentAlone)
+{
+    CancellationSource parent;
+    CancellationSource child(parent.token());
+    CancellationSource sibling(parent.token());
+
+    child.cancel();
+    EXPECT_TRUE(child.is_cancelled());
+    EXPECT_FALSE(parent.is_cancelled());
+    EXPECT_FALSE(sibling.is_cancelled());
+}
+
+TEST(CancellationSource, ChildOfACancelledParentStartsCancelled)
+{
+    CancellationSource parent;
+    parent.cancel();
+    CancellationSource child(parent.token());
+    EXPECT_TRUE(child.is_cancelled());
+}
+
+TEST(CancellationSource, DestroyedChildIsUnlinkedFromTheParent)
+{
+    CancellationSource parent;
+    auto token = [&parent]
+    {
+        CancellationSource child(parent.token());
+        return child.token();
+    }();
+
+    parent.cancel();
+    // the state outlives the child source, but it is no longer linked
+    EXPECT_FALSE(token.is_cancelled());
+}
+
+}
@@ -0,0 +1,169 @@
+// cpp::concurrency::Dispatcher with a bounded queue, one test per QueueFullPolicy
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+using cpp::concurrency::Dispatcher;
+using cpp::concurrency::QueueBound;
+using cpp::concurrency::QueueFullPolicy;
+using namespace std::chrono_literals;
+
+constexpr std::size_t capacity = 2;
+
+Dispatcher bounded_dispatcher(QueueFullPolicy policy)
+{
+    return Dispatcher(std::chrono::steady_clock::duration::max(), cpp::performance::NullDispatcherPerformance::shared(), QueueBound{ capacity, policy });
+}
+
+// keeps the dispatcher thread busy, so the notifications posted meanwhile stay queued.
+// Declared after the dispatcher, so it is released before the dispatcher is destroyed.
+class Blocker
+{
+public:
+    explicit Blocker(const Dispatcher& dispatcher)
+    {
+        dispatcher.notify([this]() noexcept
+        {
+            m_running = true;
+            while (!m_released)
+            {
+                std::this_thread::sleep_for(1ms);
+            }
+        });
+        while (!m_running)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+
+    ~Blocker()
+    {
+        release();
+    }
+
+    void release() noexcept
+    {
+        m_released = true;
+    }
+
+private:
+    std::atomic<bool> m_running{ false };
+    std::atomic<bool> m_released{ false };
+};
+
+// the order the notifications ran in, only touched on the dispatcher thread until synchronize
+struct Ran
+{
+    std::vector<int> order;
+
+    auto task(int id)
+    {
+        return [this, id]() noexcept { order.push_back(id); };
+    }
+};
+
+TEST(DispatcherBoundedQueue, BlockWaitsUntilTheDispatcherTakesATask)
+{
+    auto dispatcher = bounded_dispatcher(QueueFullPolicy::block);
+    Ran ran;
+    Blocker blocker(dispatcher);
+    dispatcher.notify(ran.task(1));
+    dispatcher.notify(ran.task(2));
+
+    std::atomic<bool> posted{ false };
+    std::thread producer([&dispatcher, &ran, &posted]
+    {
+        dispatcher.notify(ran.task(3));
+        posted = true;
+    });
+    std::this_thread::sleep_for(20ms);
+    EXPECT_FALSE(posted);
+
+    blocker.release();
+    producer.join();
+    dispatcher.synchronize();
+    EXPECT_EQ((std::vector<int>{ 1, 2, 3 }), ran.order);
+}
+
+TEST(DispatcherBoundedQueue, FailThrowsQueueFull)
+{
+    auto dispatcher = bounded_dispatcher(QueueFullPolicy::fail);
+    Ran ran;
+    Blocker blocker(dispatcher);
+    dispatcher.notify(ran.task(1));
+    dispatcher.notify(ran.task(2));
+    EXPECT_THROW(dispatcher.notify(ran.task(3)), cpp::queue_full_exception);
+    EXPECT_THROW((void)dispatcher.async([] { return 4; }), cpp::queue_full_exception);
+
+    // synchronize gets past the bound
+    blocker.release();
+    dispatcher.synchronize();
+    EXPECT_EQ((std::vector<int>{ 1, 2 }), ran.order);
+}
+
+TEST(DispatcherBoundedQueue, DropOldestDropsTheOldestQueuedTask)
+{
+    auto dispatcher = bounded_dispatcher(QueueFullPolicy::drop_oldest);
+    Ran ran;
+    Blocker blocker(dispatcher);
+    auto dropped = dispatcher.async([] { return 1; });
+    dispatcher.notify(ran.task(2));
+    dispatcher.notify(ran.task(3));
+
+    blocker.release();
+    dispatcher.synchronize();
+    EXPECT_EQ((std::vector<int>{ 2, 3 }), ran.order);
+    try
+    {
+        dropped.get();
+        FAIL() << "the dropped task ran";
+    }
+    catch (const std::future_error& error)
+    {
+        EXPECT_EQ(std::future_errc::broken_promise, error.code());
+    }
+}
+
+TEST(DispatcherBoundedQueue, CoalesceReplacesOnlyTheNotificationWithTheSameKey)
+{
+    auto dispatcher = bounded_dispatcher(QueueFullPolicy::coalesce);
+    Ran ran;
+    Blocker blocker(dispatcher);
+    dispatcher.notify_replacing(7, ran.task(1));
+    dispatcher.notify(ran.task(2));
+
+    // no key, or a key that is not queued: the queue is full. Posted from the same function
+    // with the same tag as the queued ones, which does not matter.
+    EXPECT_THROW(dispatcher.notify(ran.task(3)), cpp::queue_full_exception);
+    EXPECT_THROW(dispatcher.notify_replacing(8, ran.task(4)), cpp::queue_full_exception);
+
+    // replaces 1 and goes to the back of the queue
+    dispatcher.notify_replacing(7, ran.task(5));
+
+    blocker.release();
+    dispatcher.synchronize();
+    EXPECT_EQ((std::vector<int>{ 2, 5 }), ran.order);
+}
+
+TEST(DispatcherBoundedQueue, KeyedNotificationsAreQueuedWhileThereIsRoom)
+{
+    auto dispatcher = bounded_dispatcher(QueueFullPolicy::coalesce);
+    Ran ran;
+    Blocker blocker(dispatcher);
+    dispatcher.notify_replacing(7, ran.task(1));
+    dispatcher.notify_replacing(7, ran.task(2));
+
+    blocker.release();
+    dispatcher.synchronize();
+    EXPECT_EQ((std::vector<int>{ 1, 2 }), ran.order);
+}
+
+}
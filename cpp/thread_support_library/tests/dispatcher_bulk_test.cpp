@@ -0,0 +1,141 @@
+// cpp::concurrency::Dispatcher::notify_bulk and async_bulk
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+using cpp::concurrency::Dispatcher;
+
+// appends its id to the order, only touched on the dispatcher thread until synchronize
+struct Append
+{
+    void operator()() const noexcept
+    {
+        order->push_back(id);
+    }
+
+    std::vector<int>* order;
+    int id;
+};
+
+std::vector<Append> batch(std::vector<int>& order, int first, int count)
+{
+    std::vector<Append> fns;
+    for (int id = first; id < first + count; ++id)
+    {
+        fns.push_back({ &order, id });
+    }
+    return fns;
+}
+
+TEST(DispatcherBulk, NotifyBulkRunsInTheOrderOfTheRange)
+{
+    Dispatcher dispatcher;
+    std::vector<int> order;
+    dispatcher.notify(Append{ &order, 0 });
+    dispatcher.notify_bulk(batch(order, 1, 5));
+    dispatcher.notify(Append{ &order, 6 });
+    dispatcher.notify_bulk(std::vector<Append>{});
+    dispatcher.synchronize();
+    EXPECT_EQ((std::vector<int>{ 0, 1, 2, 3, 4, 5, 6 }), order);
+}
+
+TEST(DispatcherBulk, BatchIsNotInterleavedWithOtherProducers)
+{
+    Dispatcher dispatcher;
+    std::vector<int> order;
+    constexpr int batch_size = 1000;
+    std::atomic<bool> stop{ false };
+
+    // negative ids, posted one at a time while the batches go in
+    std::thread producer([&dispatcher, &order, &stop]
+    {
+        for (int id = -1; !stop; --id)
+        {
+            dispatcher.notify(Append{ &order, id });
+        }
+    });
+    for (int round = 0; round < 10; ++round)
+    {
+        dispatcher.notify_bulk(batch(order, round * batch_size, batch_size));
+    }
+    stop = true;
+    producer.join();
+    dispatcher.synchronize();
+
+    std::vector<int> batches;
+    for (std::size_t index = 0; index < order.size(); ++index)
+    {
+        if (order[index] < 0)
+        {
+            continue;
+        }
+        batches.push_back(order[index]);
+        // the first of a batch is followed by the rest of it
+        if ((order[index] % batch_size) == 0)
+        {
+            for (int offset = 1; offset < batch_size; ++offset)
+            {
+                ASSERT_EQ(order[index] + offset, order[index + offset]);
+            }
+        }
+    }
+    ASSERT_EQ(static_cast<std::size_t>(10 * batch_size), batches.size());
+    for (int id = 0; id < 10 * batch_size; ++id)
+    {
+        EXPECT_EQ(id, batches[id]);
+    }
+}
+
+TEST(DispatcherBulk, AsyncBulkReturnsTheFuturesInOrder)
+{
+    Dispatcher dispatcher;
+    std::vector<std::function<int()>> fns;
+    for (int id = 0; id < 5; ++id)
+    {
+        fns.push_back([id]() -> int
+        {
+            if (id == 3)
+            {
+                throw std::runtime_error("3");
+            }
+            return id * 10;
+        });
+    }
+
+    auto futures = dispatcher.async_bulk(fns);
+    ASSERT_EQ(5u, futures.size());
+    EXPECT_EQ(0, futures[0].get());
+    EXPECT_EQ(10, futures[1].get());
+    EXPECT_EQ(20, futures[2].get());
+    EXPECT_THROW(futures[3].get(), std::runtime_error);
+    EXPECT_EQ(40, futures[4].get());
+}
+
+TEST(DispatcherBulk, PoolDispatcherRunsTheWholeBatch)
+{
+    cpp::concurrency::PoolDispatcher dispatcher(std::chrono::milliseconds(100), cpp::performance::NullDispatcherPerformance::shared(), 4);
+    std::atomic<int> runs{ 0 };
+    struct Count
+    {
+        void operator()() const noexcept
+        {
+            ++*runs;
+        }
+
+        std::atomic<int>* runs;
+    };
+    dispatcher.notify_bulk(std::vector<Count>(1000, Count{ &runs }));
+    dispatcher.synchronize();
+    EXPECT_EQ(1000, runs);
+}
+
+}
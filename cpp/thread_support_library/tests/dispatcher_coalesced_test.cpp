@@ -0,0 +1,167 @@
+// notify_coalesced of the dispatchers: one pending notification per key, running the latest fn
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+using cpp::concurrency::Dispatcher;
+using cpp::concurrency::PoolDispatcher;
+using cpp::concurrency::QueueBound;
+using cpp::concurrency::QueueFullPolicy;
+using namespace std::chrono_literals;
+
+// keeps the dispatcher busy until released, so everything posted meanwhile is pending
+template<typename D>
+class Blocker
+{
+public:
+    explicit Blocker(const D& dispatcher)
+    {
+        dispatcher.notify([this]() noexcept
+        {
+            m_running = true;
+            while (!m_released)
+            {
+                std::this_thread::sleep_for(1ms);
+            }
+        });
+        while (!m_running)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+
+    ~Blocker()
+    {
+        release();
+    }
+
+    void release() noexcept
+    {
+        m_released = true;
+    }
+
+private:
+    std::atomic<bool> m_running{ false };
+    std::atomic<bool> m_released{ false };
+};
+
+// the values the coalesced notifications ran with, only touched by one dispatcher thread until synchronize
+struct Ran
+{
+    std::vector<int> values;
+
+    auto update(int value)
+    {
+        return [this, value]() noexcept { values.push_back(value); };
+    }
+};
+
+TEST(DispatcherCoalesced, PendingUpdatesOfAKeyRunOnceWithTheLatest)
+{
+    Dispatcher dispatcher;
+    Ran ran;
+    Blocker<Dispatcher> blocker(dispatcher);
+    for (int value = 0; value < 100; ++value)
+    {
+        dispatcher.notify_coalesced(1, ran.update(value));
+    }
+
+    blocker.release();
+    dispatcher.synchronize();
+    EXPECT_EQ((std::vector<int>{ 99 }), ran.values);
+}
+
+TEST(DispatcherCoalesced, KeysAreCoalescedSeparately)
+{
+    Dispatcher dispatcher;
+    Ran ran;
+    Blocker<Dispatcher> blocker(dispatcher);
+    for (int value = 0; value < 10; ++value)
+    {
+        dispatcher.notify_coalesced(1, ran.update(value));
+        dispatcher.notify_coalesced(2, ran.update(100 + value));
+    }
+
+    blocker.release();
+    dispatcher.synchronize();
+    // each key runs at the place of its first post
+    EXPECT_EQ((std::vector<int>{ 9, 109 }), ran.values);
+}
+
+TEST(DispatcherCoalesced, UpdateWhileTheNotificationRunsIsQueuedAgain)
+{
+    Dispatcher dispatcher;
+    std::atomic<bool> running{ false };
+    std::atomic<bool> released{ false };
+    std::atomic<int> runs{ 0 };
+    dispatcher.notify_coalesced(1, [&running, &released, &runs]() noexcept
+    {
+        ++runs;
+        running = true;
+        while (!released)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+    });
+    while (!running)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    // the running notification is no longer pending, this one must not be lost
+    dispatcher.notify_coalesced(1, [&runs]() noexcept { ++runs; });
+    released = true;
+    dispatcher.synchronize();
+    EXPECT_EQ(2, runs);
+}
+
+TEST(DispatcherCoalesced, IsExemptFromTheQueueBound)
+{
+    Dispatcher dispatcher(std::chrono::milliseconds(100), cpp::performance::NullDispatcherPerformance::shared(), QueueBound{ 1, QueueFullPolicy::fail });
+    Ran ran;
+    Blocker<Dispatcher> blocker(dispatcher);
+    dispatcher.notify(ran.update(0));
+    EXPECT_THROW(dispatcher.notify(ran.update(-1)), cpp::queue_full_exception);
+    dispatcher.notify_coalesced(1, ran.update(1));
+    dispatcher.notify_coalesced(1, ran.update(2));
+
+    blocker.release();
+    dispatcher.synchronize();
+    EXPECT_EQ((std::vector<int>{ 0, 2 }), ran.values);
+}
+
+TEST(DispatcherCoalesced, PoolDispatcherCollapsesUpdatesFromManyProducers)
+{
+    PoolDispatcher dispatcher(std::chrono::steady_clock::duration::max(), cpp::performance::NullDispatcherPerformance::shared(), 1);
+    std::atomic<int> runs{ 0 };
+    Blocker<PoolDispatcher> blocker(dispatcher);
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < 4; ++producer)
+    {
+        producers.emplace_back([&dispatcher, &runs]
+        {
+            for (int update = 0; update < 1000; ++update)
+            {
+                dispatcher.notify_coalesced(7, [&runs]() noexcept { ++runs; });
+            }
+        });
+    }
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+
+    blocker.release();
+    dispatcher.synchronize();
+    EXPECT_EQ(1, runs);
+}
+
+}
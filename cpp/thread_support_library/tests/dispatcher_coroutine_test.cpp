@@ -0,0 +1,193 @@
+// co_await on the dispatchers: schedule(), after(), task<T> and start_detached
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/coroutine.h>
+#include <cpplib/concurrency/dispatcher.h>
+
+#if CPPLIB_HAS_COROUTINES
+
+namespace
+{
+
+using cpp::concurrency::Dispatcher;
+using cpp::concurrency::PoolDispatcher;
+using cpp::concurrency::task;
+using namespace std::chrono_literals;
+
+std::atomic<long long> allocations{ 0 };
+
+template<typename D>
+task<bool> runs_on_the_dispatcher(const D& dispatcher)
+{
+    co_await dispatcher.schedule();
+    co_return dispatcher.is_injected_thread();
+}
+
+template<typename D>
+task<std::chrono::steady_clock::duration> resume_after(const D& dispatcher, std::chrono::steady_clock::duration duration)
+{
+    auto start = std::chrono::steady_clock::now();
+    co_await dispatcher.after(duration);
+    if (!dispatcher.is_injected_thread())
+    {
+        throw std::logic_error("resumed on another thread");
+    }
+    co_return std::chrono::steady_clock::now() - start;
+}
+
+task<int> fail(const Dispatcher& dispatcher)
+{
+    co_await dispatcher.schedule();
+    throw std::runtime_error("fail");
+}
+
+task<int> add_one(const Dispatcher& dispatcher, bool rethrow)
+{
+    try
+    {
+        co_return co_await fail(dispatcher) + 1;
+    }
+    catch (const std::runtime_error&)
+    {
+        if (rethrow)
+        {
+            throw;
+        }
+    }
+    co_return -1;
+}
+
+// completes the promise with the result of the task, from whatever thread the task ends on
+template<typename T>
+task<void> complete(task<T> awaited, std::promise<T>& promise)
+{
+    try
+    {
+        promise.set_value(co_await awaited);
+    }
+    catch (...)
+    {
+        promise.set_exception(std::current_exception());
+    }
+}
+
+template<typename T>
+T run(task<T> awaited)
+{
+    std::promise<T> promise;
+    auto result = promise.get_future();
+    cpp::concurrency::start_detached(complete(std::move(awaited), promise));
+    return result.get();
+}
+
+// heap allocations of the dispatcher for `waits` resumes by after(), once the timer queue is warm
+task<void> count_allocations_of_after(const Dispatcher& dispatcher, int waits, std::promise<long long>& promise)
+{
+    auto& pool = cpp::concurrency::details::TaskNodePool::instance();
+    for (int warm_up = 0; warm_up < 3; ++warm_up)
+    {
+        co_await dispatcher.after(1ms);
+    }
+
+    auto before = allocations.load() + static_cast<long long>(pool.heap_allocations());
+    for (int wait = 0; wait < waits; ++wait)
+    {
+        co_await dispatcher.after(1ms);
+    }
+    promise.set_value(allocations.load() + static_cast<long long>(pool.heap_allocations()) - before);
+}
+
+TEST(DispatcherCoroutine, ScheduleContinuesOnTheDispatcherThread)
+{
+    Dispatcher dispatcher;
+    PoolDispatcher pool(std::chrono::milliseconds(100), cpp::performance::NullDispatcherPerformance::shared(), 2);
+    EXPECT_TRUE(run(runs_on_the_dispatcher(dispatcher)));
+    EXPECT_TRUE(run(runs_on_the_dispatcher(pool)));
+}
+
+TEST(DispatcherCoroutine, AfterWaitsAtLeastTheDuration)
+{
+    Dispatcher dispatcher;
+    PoolDispatcher pool(std::chrono::milliseconds(100), cpp::performance::NullDispatcherPerformance::shared(), 2);
+    EXPECT_GE(run(resume_after(dispatcher, 20ms)), 20ms);
+    EXPECT_GE(run(resume_after(pool, 20ms)), 20ms);
+}
+
+TEST(DispatcherCoroutine, AfterDoesNotAllocateOnceTheTimersAreWarm)
+{
+    Dispatcher dispatcher;
+    std::promise<long long> promise;
+    auto result = promise.get_future();
+    cpp::concurrency::start_detached(count_allocations_of_after(dispatcher, 20, promise));
+    EXPECT_EQ(0, result.get());
+}
+
+TEST(DispatcherCoroutine, TaskPassesTheExceptionToItsAwaiter)
+{
+    Dispatcher dispatcher;
+    EXPECT_THROW(run(fail(dispatcher)), std::runtime_error);
+    EXPECT_THROW(run(add_one(dispatcher, true)), std::runtime_error);
+    EXPECT_EQ(-1, run(add_one(dispatcher, false)));
+}
+
+TEST(DispatcherCoroutine, StartDetachedReturnsBeforeTheTaskCompletes)
+{
+    Dispatcher dispatcher;
+    std::atomic<bool> released{ false };
+    std::promise<bool> promise;
+    auto result = promise.get_future();
+
+    // blocks the dispatcher, the detached task waits in its queue
+    dispatcher.notify([&released]() noexcept
+    {
+        while (!released)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+    });
+    cpp::concurrency::start_detached(complete(runs_on_the_dispatcher(dispatcher), promise));
+    EXPECT_EQ(std::future_status::timeout, result.wait_for(10ms));
+
+    released = true;
+    EXPECT_TRUE(result.get());
+}
+
+TEST(DispatcherCoroutine, StartDetachedSwallowsTheException)
+{
+    Dispatcher dispatcher;
+    cpp::concurrency::start_detached(fail(dispatcher));
+    // the task ran and destroyed itself
+    EXPECT_EQ(42, dispatcher.call([] { return 42; }));
+}
+
+}
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if (auto memory = std::malloc(size == 0 ? 1 : size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+// not inlined: gcc would see free() on memory from operator new and warn about a mismatch
+[[gnu::noinline]] void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+[[gnu::noinline]] void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+#endif
@@ -0,0 +1,175 @@
+// required response time of cpp::concurrency::Dispatcher: DeadlineViolation reports and BackgroundWorkPolicy
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+using cpp::concurrency::BackgroundWorkPolicy;
+using cpp::concurrency::Dispatcher;
+using cpp::concurrency::DispatcherPriority;
+using namespace std::chrono_literals;
+
+constexpr auto required_response_time = 5ms;
+// only a slow task is late against it, also on a loaded machine
+constexpr auto generous_response_time = 50ms;
+
+// keeps the violations, reported on the dispatcher thread and read after synchronize
+class Violations :
+    public cpp::performance::DispatcherPerformanceItf
+{
+public:
+    virtual void increment_number_of_calls_queued() override {}
+    virtual void report_queue_size(std::uint32_t) override {}
+    virtual void report_latency_in_milliseconds(std::uint32_t) override {}
+
+    virtual void report_deadline_violation(const cpp::performance::DeadlineViolation& violation) override
+    {
+        reported.push_back(violation);
+    }
+
+    std::vector<cpp::performance::DeadlineViolation> reported;
+};
+
+// keeps the dispatcher busy for longer than the required response time, everything queued meanwhile is late
+void block(const Dispatcher& dispatcher)
+{
+    std::atomic<bool> running{ false };
+    dispatcher.notify([&running]() noexcept
+    {
+        running = true;
+        std::this_thread::sleep_for(4 * required_response_time);
+    });
+    while (!running)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+}
+
+// the order the tasks ran in, only touched on the dispatcher thread until synchronize
+struct Ran
+{
+    std::vector<int> order;
+
+    auto task(int id)
+    {
+        return [this, id]() noexcept { order.push_back(id); };
+    }
+};
+
+constexpr int background_task = -1;
+
+// 20 normal tasks and one background task, all late. The normal lane takes two rounds.
+Ran run_late_tasks(const Dispatcher& dispatcher)
+{
+    Ran ran;
+    block(dispatcher);
+    dispatcher.notify(DispatcherPriority::background, ran.task(background_task));
+    for (int id = 0; id < 20; ++id)
+    {
+        dispatcher.notify(DispatcherPriority::normal, ran.task(id));
+    }
+    dispatcher.synchronize();
+    // a deferred background task runs in the round after the synchronize
+    dispatcher.synchronize();
+    return ran;
+}
+
+TEST(DispatcherDeadline, LateTaskIsReported)
+{
+    auto violations = std::make_shared<Violations>();
+    Dispatcher dispatcher(generous_response_time, violations);
+    dispatcher.notify([]() noexcept {});
+    dispatcher.synchronize();
+    EXPECT_TRUE(violations->reported.empty());
+    EXPECT_EQ(0u, dispatcher.number_of_deadline_violations());
+
+    // synchronize only once the slow task is done, its own task would be late as well otherwise
+    std::atomic<bool> done{ false };
+    dispatcher.notify(DispatcherPriority::critical, [&done]() noexcept
+    {
+        std::this_thread::sleep_for(2 * generous_response_time);
+        done = true;
+    });
+    while (!done)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+    dispatcher.synchronize();
+    ASSERT_EQ(1u, violations->reported.size());
+    EXPECT_EQ(1u, dispatcher.number_of_deadline_violations());
+    auto& violation = violations->reported.front();
+    EXPECT_NE(nullptr, violation.task);
+    EXPECT_EQ(DispatcherPriority::critical, violation.priority);
+    EXPECT_GE(violation.execution_time, 2 * generous_response_time);
+    EXPECT_GT(violation.queue_latency + violation.execution_time, generous_response_time);
+}
+
+TEST(DispatcherDeadline, MaxResponseTimeSwitchesTheCheckOff)
+{
+    auto violations = std::make_shared<Violations>();
+    Dispatcher dispatcher(std::chrono::steady_clock::duration::max(), violations);
+    dispatcher.notify([]() noexcept { std::this_thread::sleep_for(2 * required_response_time); });
+    dispatcher.synchronize();
+    EXPECT_TRUE(violations->reported.empty());
+    EXPECT_EQ(0u, dispatcher.number_of_deadline_violations());
+}
+
+TEST(DispatcherDeadline, RunPolicyKeepsRunningBackgroundWork)
+{
+    Dispatcher dispatcher(required_response_time, cpp::performance::NullDispatcherPerformance::shared());
+    auto ran = run_late_tasks(dispatcher);
+    ASSERT_EQ(21u, ran.order.size());
+    // in the first round, after the normal lane budget
+    EXPECT_NE(background_task, ran.order.back());
+}
+
+TEST(DispatcherDeadline, DeferPolicySkipsBackgroundWorkWhileHigherLanesAreLate)
+{
+    Dispatcher dispatcher(required_response_time, cpp::performance::NullDispatcherPerformance::shared());
+    dispatcher.set_background_work_policy(BackgroundWorkPolicy::defer);
+    auto ran = run_late_tasks(dispatcher);
+    ASSERT_EQ(21u, ran.order.size());
+    EXPECT_EQ(background_task, ran.order.back());
+    EXPECT_EQ(0u, dispatcher.number_of_shed_tasks());
+}
+
+TEST(DispatcherDeadline, ShedPolicyDropsBackgroundWorkWhileHigherLanesAreLate)
+{
+    Dispatcher dispatcher(required_response_time, cpp::performance::NullDispatcherPerformance::shared());
+    dispatcher.set_background_work_policy(BackgroundWorkPolicy::shed);
+    block(dispatcher);
+    auto dropped = dispatcher.async(DispatcherPriority::background, [] { return 1; });
+    auto ran = run_late_tasks(dispatcher);
+
+    EXPECT_EQ(20u, ran.order.size());
+    EXPECT_EQ(2u, dispatcher.number_of_shed_tasks());
+    try
+    {
+        dropped.get();
+        FAIL() << "the shed task ran";
+    }
+    catch (const std::future_error& error)
+    {
+        EXPECT_EQ(std::future_errc::broken_promise, error.code());
+    }
+
+    // once the higher lanes are on time again, background work runs. A loaded machine can make a round late, retry.
+    std::atomic<bool> background_ran{ false };
+    for (int attempt = 0; (attempt < 100) && !background_ran; ++attempt)
+    {
+        dispatcher.notify(DispatcherPriority::background, [&background_ran]() noexcept { background_ran = true; });
+        dispatcher.synchronize();
+        dispatcher.synchronize();
+    }
+    EXPECT_TRUE(background_ran);
+}
+
+}
@@ -0,0 +1,169 @@
+// priority lanes of the dispatchers: critical first, but every lane gets its share
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+using cpp::concurrency::Dispatcher;
+using cpp::concurrency::DispatcherPriority;
+using cpp::concurrency::PoolDispatcher;
+using namespace std::chrono_literals;
+
+constexpr int normal_task = -1;
+constexpr int background_task = -2;
+
+// keeps the dispatcher busy until released, so everything posted meanwhile is queued up
+template<typename D>
+class Blocker
+{
+public:
+    explicit Blocker(const D& dispatcher)
+    {
+        dispatcher.notify([this]() noexcept
+        {
+            m_running = true;
+            while (!m_released)
+            {
+                std::this_thread::sleep_for(1ms);
+            }
+        });
+        while (!m_running)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+
+    ~Blocker()
+    {
+        release();
+    }
+
+    void release() noexcept
+    {
+        m_released = true;
+    }
+
+private:
+    std::atomic<bool> m_running{ false };
+    std::atomic<bool> m_released{ false };
+};
+
+// the ids in the order the tasks ran, only touched by one dispatcher thread until synchronize
+struct Ran
+{
+    std::vector<int> order;
+
+    auto task(int id)
+    {
+        return [this, id]() noexcept { order.push_back(id); };
+    }
+
+    std::ptrdiff_t position(int id) const
+    {
+        return std::find(order.begin(), order.end(), id) - order.begin();
+    }
+
+    // the ids at or above zero, in the order they ran
+    std::vector<int> ids() const
+    {
+        std::vector<int> ids;
+        std::copy_if(order.begin(), order.end(), std::back_inserter(ids), [](int id) { return id >= 0; });
+        return ids;
+    }
+};
+
+std::vector<int> sequence(int count)
+{
+    std::vector<int> ids(count);
+    for (int id = 0; id < count; ++id)
+    {
+        ids[id] = id;
+    }
+    return ids;
+}
+
+TEST(DispatcherPriorityLanes, CriticalRunsFirstAndBackgroundLast)
+{
+    Dispatcher dispatcher;
+    Ran ran;
+    Blocker<Dispatcher> blocker(dispatcher);
+    dispatcher.notify(DispatcherPriority::background, ran.task(background_task));
+    dispatcher.notify(DispatcherPriority::normal, ran.task(normal_task));
+    dispatcher.notify(DispatcherPriority::critical, ran.task(0));
+
+    blocker.release();
+    dispatcher.synchronize();
+    EXPECT_EQ((std::vector<int>{ 0, normal_task, background_task }), ran.order);
+}
+
+TEST(DispatcherPriorityLanes, LowerLanesAreNotStarvedByAFloodOfCriticalTasks)
+{
+    Dispatcher dispatcher;
+    Ran ran;
+    Blocker<Dispatcher> blocker(dispatcher);
+    constexpr int critical_tasks = 1000;
+    for (int id = 0; id < critical_tasks; ++id)
+    {
+        dispatcher.notify(DispatcherPriority::critical, ran.task(id));
+    }
+    dispatcher.notify(DispatcherPriority::normal, ran.task(normal_task));
+    dispatcher.notify(DispatcherPriority::background, ran.task(background_task));
+
+    blocker.release();
+    dispatcher.synchronize();
+    ASSERT_EQ(static_cast<std::size_t>(critical_tasks + 2), ran.order.size());
+    // a round runs at most 64 critical tasks before the next normal one, and takes one background task
+    EXPECT_LE(ran.position(normal_task), 64);
+    EXPECT_LT(ran.position(background_task), 200);
+    EXPECT_EQ(sequence(critical_tasks), ran.ids());
+}
+
+TEST(DispatcherPriorityLanes, BackgroundIsNotStarvedByAFloodOfNormalTasks)
+{
+    Dispatcher dispatcher;
+    Ran ran;
+    Blocker<Dispatcher> blocker(dispatcher);
+    constexpr int normal_tasks = 200;
+    for (int id = 0; id < normal_tasks; ++id)
+    {
+        dispatcher.notify(DispatcherPriority::normal, ran.task(id));
+    }
+    dispatcher.notify(DispatcherPriority::background, ran.task(background_task));
+
+    blocker.release();
+    dispatcher.synchronize();
+    // a round runs at most 16 normal tasks
+    EXPECT_LE(ran.position(background_task), 16);
+    EXPECT_EQ(sequence(normal_tasks), ran.ids());
+}
+
+TEST(DispatcherPriorityLanes, PoolWorkerRotatesTheLaneItStartsAt)
+{
+    PoolDispatcher dispatcher(std::chrono::steady_clock::duration::max(), cpp::performance::NullDispatcherPerformance::shared(), 1);
+    Ran ran;
+    Blocker<PoolDispatcher> blocker(dispatcher);
+    constexpr int critical_tasks = 200;
+    for (int id = 0; id < critical_tasks; ++id)
+    {
+        dispatcher.notify(DispatcherPriority::critical, ran.task(id));
+    }
+    dispatcher.notify(DispatcherPriority::normal, ran.task(normal_task));
+    dispatcher.notify(DispatcherPriority::background, ran.task(background_task));
+
+    blocker.release();
+    dispatcher.synchronize();
+    // every 4th pop starts at the normal lane, every 16th at the background lane
+    EXPECT_LT(ran.position(normal_task), 4);
+    EXPECT_LT(ran.position(background_task), 16);
+    EXPECT_EQ(sequence(critical_tasks), ran.ids());
+}
+
+}
@@ -0,0 +1,47 @@
+// cpp::concurrency::DispatcherWithContext whose dispatcher thread fails to start
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+std::atomic<bool> fail_to_start{ true };
+
+// the thread context of a dispatcher is constructed on the dispatcher thread before it runs tasks
+struct ThreadContext
+{
+    ThreadContext()
+    {
+        if (fail_to_start)
+        {
+            throw std::runtime_error("thread context");
+        }
+    }
+};
+
+using ContextDispatcher = cpp::concurrency::DispatcherWithContext<ThreadContext>;
+
+TEST(DispatcherStartup, DefaultConstructorThrowsTheExceptionOfTheThreadContext)
+{
+    fail_to_start = true;
+    EXPECT_THROW(ContextDispatcher dispatcher, std::runtime_error);
+}
+
+TEST(DispatcherStartup, ConstructorWithPerformanceThrowsTheExceptionOfTheThreadContext)
+{
+    fail_to_start = true;
+    EXPECT_THROW(ContextDispatcher dispatcher(std::chrono::milliseconds(100), cpp::performance::NullDispatcherPerformance::shared()), std::runtime_error);
+}
+
+TEST(DispatcherStartup, ThreadContextThatConstructsRunsTasks)
+{
+    fail_to_start = false;
+    ContextDispatcher dispatcher;
+    EXPECT_EQ(42, dispatcher.call([] { return 42; }));
+}
+
+}
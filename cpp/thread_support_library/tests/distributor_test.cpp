@@ -0,0 +1,177 @@
+// distributor of simple_concurrent_queue.h, one item at a time and in batches (drain_batches)
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <simple_concurrent_queue.h>
+
+namespace
+{
+
+using namespace std::chrono_literals;
+
+// a consumer that holds its thread until released
+class Gate
+{
+public:
+    void pass()
+    {
+        m_entered = true;
+        while (!m_open)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+
+    void wait_until_entered() const
+    {
+        while (!m_entered)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+
+    void open() noexcept
+    {
+        m_open = true;
+    }
+
+private:
+    std::atomic<bool> m_entered{ false };
+    std::atomic<bool> m_open{ false };
+};
+
+// the items of every batch, in the order the batches ran
+struct Batches
+{
+    std::mutex mutex;
+    std::vector<std::vector<int>> ran;
+
+    void add(item_span<int> items)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ran.emplace_back(items.begin(), items.end());
+    }
+};
+
+TEST(Distributor, RejectsZeroArguments)
+{
+    auto ignore = [](int&) {};
+    EXPECT_THROW(distributor<int>(ignore, 0), std::invalid_argument);
+    EXPECT_THROW(distributor<int>(ignore, 1, 0), std::invalid_argument);
+    auto ignore_batch = [](item_span<int>) {};
+    EXPECT_THROW(distributor<int>(drain_batches{ 0 }, ignore_batch, 1), std::invalid_argument);
+}
+
+TEST(Distributor, DrainsTheQueueBeforeItStops)
+{
+    Gate gate;
+    std::atomic<int> processed{ 0 };
+    {
+        distributor<int> distributor([&gate, &processed](int&)
+        {
+            gate.pass();
+            ++processed;
+        }, 1, 8);
+        for (int value = 0; value < 9; ++value)
+        {
+            distributor(int{ value });
+        }
+        gate.wait_until_entered();
+        gate.open();
+    }
+    EXPECT_EQ(9, processed);
+}
+
+TEST(Distributor, ProducerWaitsWhileTheQueueIsFull)
+{
+    Gate gate;
+    distributor<int> distributor([&gate](int&) { gate.pass(); }, 1, 2);
+    distributor(0);
+    gate.wait_until_entered();
+    distributor(1);
+    distributor(2);
+
+    std::atomic<bool> pushed{ false };
+    std::thread producer([&distributor, &pushed]
+    {
+        distributor(3);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(20ms);
+    EXPECT_FALSE(pushed);
+
+    gate.open();
+    producer.join();
+    EXPECT_TRUE(pushed);
+}
+
+TEST(DistributorBatches, BacklogIsTakenInBatchesOfAtMostMaxItems)
+{
+    Gate gate;
+    Batches batches;
+    {
+        distributor<int> distributor(drain_batches{ 4 }, [&gate, &batches](item_span<int> items)
+        {
+            batches.add(items);
+            gate.pass();
+        }, 1, 10);
+        distributor(0);
+        gate.wait_until_entered();
+        // queued while the consumer holds the first batch
+        for (int value = 1; value <= 10; ++value)
+        {
+            distributor(int{ value });
+        }
+        gate.open();
+    }
+    EXPECT_EQ((std::vector<std::vector<int>>{ { 0 }, { 1, 2, 3, 4 }, { 5, 6, 7, 8 }, { 9, 10 } }), batches.ran);
+}
+
+TEST(DistributorBatches, EveryItemIsTakenOnceWithManyConsumers)
+{
+    constexpr int items = 20000;
+    std::vector<std::atomic<int>> seen(items);
+    std::atomic<std::size_t> largest_batch{ 0 };
+    {
+        distributor<int> distributor(drain_batches{ 16 }, [&seen, &largest_batch](item_span<int> batch)
+        {
+            for (auto item : batch)
+            {
+                ++seen[item];
+            }
+            auto largest = largest_batch.load();
+            while ((batch.size() > largest) && !largest_batch.compare_exchange_weak(largest, batch.size()))
+            {
+            }
+        }, 4, 32);
+
+        std::vector<std::thread> producers;
+        for (int producer = 0; producer < 2; ++producer)
+        {
+            producers.emplace_back([&distributor, producer]
+            {
+                for (int item = producer; item < items; item += 2)
+                {
+                    distributor(int{ item });
+                }
+            });
+        }
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+    }
+
+    for (auto& count : seen)
+    {
+        ASSERT_EQ(1, count);
+    }
+    EXPECT_LE(largest_batch, 16u);
+}
+
+}
@@ -0,0 +1,95 @@
+// details::futex_wait and futex_wake_one/all, the waiting primitive of StateVariable and Signal
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/details/futex.h>
+
+namespace
+{
+
+using cpp::concurrency::details::futex_wait;
+using cpp::concurrency::details::futex_wake_all;
+using cpp::concurrency::details::futex_wake_one;
+using namespace std::chrono_literals;
+
+std::chrono::steady_clock::duration time_waiting(const std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::steady_clock::duration timeout)
+{
+    auto start = std::chrono::steady_clock::now();
+    futex_wait(word, expected, timeout);
+    return std::chrono::steady_clock::now() - start;
+}
+
+TEST(Futex, DoesNotSleepWhenTheWordChanged)
+{
+    std::atomic<std::uint32_t> word{ 1 };
+    EXPECT_LT(time_waiting(word, 0, 10s), 1s);
+    // longer timeouts are cut to a day, they must not overflow
+    EXPECT_LT(time_waiting(word, 0, std::chrono::steady_clock::duration::max()), 1s);
+}
+
+TEST(Futex, DoesNotSleepWithoutTimeout)
+{
+    std::atomic<std::uint32_t> word{ 0 };
+    EXPECT_LT(time_waiting(word, 0, std::chrono::steady_clock::duration::zero()), 1s);
+    EXPECT_LT(time_waiting(word, 0, -1s), 1s);
+}
+
+TEST(Futex, ReturnsAfterTheTimeout)
+{
+    std::atomic<std::uint32_t> word{ 0 };
+    EXPECT_LT(time_waiting(word, 0, 20ms), 5s);
+}
+
+TEST(Futex, WakeAllWakesEverySleeper)
+{
+    std::atomic<std::uint32_t> word{ 0 };
+    std::atomic<int> woken{ 0 };
+    std::vector<std::thread> sleepers;
+    for (int sleeper = 0; sleeper < 4; ++sleeper)
+    {
+        sleepers.emplace_back([&word, &woken]
+        {
+            while (word.load() == 0)
+            {
+                futex_wait(word, 0, 10s);
+            }
+            ++woken;
+        });
+    }
+
+    std::this_thread::sleep_for(10ms);
+    auto start = std::chrono::steady_clock::now();
+    word = 1;
+    futex_wake_all(word);
+    for (auto& sleeper : sleepers)
+    {
+        sleeper.join();
+    }
+    EXPECT_EQ(4, woken);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+}
+
+TEST(Futex, WakeOneWakesASleeper)
+{
+    std::atomic<std::uint32_t> word{ 0 };
+    std::thread sleeper([&word]
+    {
+        while (word.load() == 0)
+        {
+            futex_wait(word, 0, 10s);
+        }
+    });
+
+    std::this_thread::sleep_for(10ms);
+    auto start = std::chrono::steady_clock::now();
+    word = 1;
+    futex_wake_one(word);
+    sleeper.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+}
+
+}
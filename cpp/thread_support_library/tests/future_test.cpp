@@ -0,0 +1,189 @@
+// cpp::concurrency::Future: continuations, when_all, when_any and continuations that never run
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/dispatcher.h>
+#include <cpplib/concurrency/future.h>
+
+namespace
+{
+
+using cpp::concurrency::Dispatcher;
+using cpp::concurrency::Future;
+using cpp::concurrency::Promise;
+using namespace std::chrono_literals;
+
+template<typename T>
+bool is_broken_promise(const Future<T>& future)
+{
+    future.wait();
+    try
+    {
+        future.get();
+    }
+    catch (const std::future_error& error)
+    {
+        return error.code() == std::future_errc::broken_promise;
+    }
+    return false;
+}
+
+// keeps the dispatcher thread busy until released, declared after the dispatcher
+class Blocker
+{
+public:
+    explicit Blocker(const Dispatcher& dispatcher)
+    {
+        dispatcher.notify([this]() noexcept
+        {
+            m_running = true;
+            while (!m_released)
+            {
+                std::this_thread::sleep_for(1ms);
+            }
+        });
+        while (!m_running)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+
+    ~Blocker()
+    {
+        release();
+    }
+
+    void release() noexcept
+    {
+        m_released = true;
+    }
+
+private:
+    std::atomic<bool> m_running{ false };
+    std::atomic<bool> m_released{ false };
+};
+
+TEST(Future, ThenRunsEachContinuationOnItsDispatcher)
+{
+    Dispatcher first;
+    Dispatcher second;
+    auto result = cpp::concurrency::post(first, [&first] { return first.is_injected_thread() ? 20 : 0; })
+        .then(second, [&second](const int& value) { return second.is_injected_thread() ? value + 1 : 0; })
+        .then(first, [](const int& value) { return value * 2; });
+    EXPECT_EQ(42, result.get());
+}
+
+TEST(Future, ThenOfAReadyFutureAndOfVoid)
+{
+    Dispatcher dispatcher;
+    std::atomic<int> runs{ 0 };
+    auto done = cpp::concurrency::make_ready_future(1)
+        .then(dispatcher, [&runs](const int& value) { runs += value; })
+        .then(dispatcher, [&runs] { runs += 10; });
+    done.get();
+    EXPECT_EQ(11, runs);
+}
+
+TEST(Future, ExceptionSkipsTheContinuations)
+{
+    Dispatcher dispatcher;
+    std::atomic<bool> skipped_ran{ false };
+    auto result = cpp::concurrency::post(dispatcher, []() -> int { throw std::runtime_error("first"); })
+        .then(dispatcher, [&skipped_ran](const int& value) { skipped_ran = true; return value; });
+    EXPECT_THROW(result.get(), std::runtime_error);
+    EXPECT_FALSE(skipped_ran);
+    EXPECT_TRUE(result.exception() != nullptr);
+}
+
+TEST(Future, WhenAllKeepsTheOrderOfTheFutures)
+{
+    Dispatcher dispatcher;
+    Promise<int> late;
+    std::vector<Future<int>> futures{ late.get_future(), cpp::concurrency::post(dispatcher, [] { return 2; }), cpp::concurrency::make_ready_future(3) };
+    auto all = cpp::concurrency::when_all(futures);
+    EXPECT_FALSE(all.is_ready());
+    late.set_value(1);
+    EXPECT_EQ((std::vector<int>{ 1, 2, 3 }), all.get());
+
+    EXPECT_TRUE(cpp::concurrency::when_all(std::vector<Future<void>>{}).is_ready());
+}
+
+TEST(Future, WhenAllFailsWithTheFirstException)
+{
+    Promise<int> first;
+    Promise<int> second;
+    auto all = cpp::concurrency::when_all(std::vector<Future<int>>{ first.get_future(), second.get_future() });
+    second.set_exception(std::make_exception_ptr(std::logic_error("second")));
+    first.set_exception(std::make_exception_ptr(std::runtime_error("first")));
+    EXPECT_THROW(all.get(), std::runtime_error);
+}
+
+TEST(Future, WhenAnyIsTheIndexOfTheFirstReadyFuture)
+{
+    Promise<int> first;
+    Promise<int> second;
+    auto any = cpp::concurrency::when_any(std::vector<Future<int>>{ first.get_future(), second.get_future() });
+    EXPECT_FALSE(any.is_ready());
+    second.set_exception(std::make_exception_ptr(std::runtime_error("second")));
+    first.set_value(1);
+    EXPECT_EQ(1u, any.get());
+    EXPECT_THROW((void)cpp::concurrency::when_any(std::vector<Future<int>>{}), std::invalid_argument);
+}
+
+TEST(Future, RefusedContinuationFailsTheNextFuture)
+{
+    Dispatcher dispatcher(std::chrono::steady_clock::duration::max(), cpp::performance::NullDispatcherPerformance::shared(),
+        cpp::concurrency::QueueBound{ 1, cpp::concurrency::QueueFullPolicy::fail });
+    Blocker blocker(dispatcher);
+    dispatcher.notify([]() noexcept {});
+
+    Promise<int> input;
+    auto next = input.get_future().then(dispatcher, [](const int& value) { return value; });
+    // the queue is full: the exception goes to the next future, not to set_value
+    EXPECT_NO_THROW(input.set_value(1));
+    EXPECT_THROW(next.get(), cpp::queue_full_exception);
+}
+
+TEST(Future, DroppedContinuationBreaksThePromise)
+{
+    Dispatcher dispatcher(std::chrono::steady_clock::duration::max(), cpp::performance::NullDispatcherPerformance::shared(),
+        cpp::concurrency::QueueBound{ 2, cpp::concurrency::QueueFullPolicy::drop_oldest });
+    Blocker blocker(dispatcher);
+
+    Promise<int> input;
+    auto next = input.get_future().then(dispatcher, [](const int& value) { return value; });
+    input.set_value(1);
+    // the second one fills the queue, the third drops the queued continuation
+    dispatcher.notify([]() noexcept {});
+    dispatcher.notify([]() noexcept {});
+    EXPECT_TRUE(is_broken_promise(next));
+}
+
+TEST(Future, ContinuationOfAGoneDispatcherBreaksThePromise)
+{
+    auto dispatcher = std::make_shared<Dispatcher>();
+    Promise<int> input;
+    auto next = input.get_future().then(std::weak_ptr<const cpp::concurrency::InjectedThreadItf>(dispatcher), [](const int& value) { return value; });
+    dispatcher.reset();
+    input.set_value(1);
+    EXPECT_TRUE(is_broken_promise(next));
+}
+
+TEST(Future, AbandonedInputBreaksThePromise)
+{
+    Dispatcher dispatcher;
+    Future<int> next = [&dispatcher]
+    {
+        Promise<int> input;
+        return input.get_future().then(dispatcher, [](const int& value) { return value; });
+    }();
+    EXPECT_TRUE(is_broken_promise(next));
+}
+
+}
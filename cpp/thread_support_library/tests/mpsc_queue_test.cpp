@@ -0,0 +1,134 @@
+// details::MpscQueue, the lock-free ready queue of the dispatcher
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/details/mpsc_queue.h>
+
+namespace
+{
+
+struct Item
+{
+    std::atomic<Item*> next{ nullptr };
+    int producer = 0;
+    int sequence = 0;
+};
+
+using Queue = cpp::concurrency::details::MpscQueue<Item>;
+
+// pops until the queue is empty, the sequence numbers in the order they came out
+std::vector<int> drain(Queue& queue)
+{
+    std::vector<int> popped;
+    while (auto item = queue.try_pop())
+    {
+        popped.push_back(item->sequence);
+    }
+    return popped;
+}
+
+TEST(MpscQueue, PopsInPushOrder)
+{
+    Queue queue;
+    std::vector<Item> items(5);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(nullptr, queue.try_pop());
+
+    for (int index = 0; index < 5; ++index)
+    {
+        items[index].sequence = index;
+        queue.push(&items[index]);
+    }
+    EXPECT_FALSE(queue.empty());
+    EXPECT_EQ((std::vector<int>{ 0, 1, 2, 3, 4 }), drain(queue));
+    EXPECT_TRUE(queue.empty());
+
+    // the stub went back in for the last node, the queue is usable again
+    queue.push(&items[2]);
+    EXPECT_EQ((std::vector<int>{ 2 }), drain(queue));
+}
+
+TEST(MpscQueue, ChainStaysContiguous)
+{
+    Queue queue;
+    std::vector<Item> items(4);
+    for (int index = 0; index < 4; ++index)
+    {
+        items[index].sequence = index;
+    }
+    items[1].next = &items[2];
+    items[2].next = &items[3];
+
+    queue.push(&items[0]);
+    queue.push(&items[1], &items[3]);
+    EXPECT_EQ((std::vector<int>{ 0, 1, 2, 3 }), drain(queue));
+}
+
+TEST(MpscQueue, EveryProducerKeepsItsOrder)
+{
+    constexpr int producers = 4;
+    constexpr int items_per_producer = 20000;
+    std::vector<std::vector<Item>> items;
+    for (int producer = 0; producer < producers; ++producer)
+    {
+        items.emplace_back(items_per_producer);
+    }
+    Queue queue;
+
+    std::vector<std::thread> threads;
+    for (int producer = 0; producer < producers; ++producer)
+    {
+        threads.emplace_back([&queue, &items, producer]
+        {
+            for (int sequence = 0; sequence < items_per_producer; ++sequence)
+            {
+                auto& item = items[producer][sequence];
+                item.producer = producer;
+                item.sequence = sequence;
+                queue.push(&item);
+            }
+        });
+    }
+
+    // the consumer runs while the producers push, a null pop only means "not linked yet"
+    std::vector<int> next(producers, 0);
+    int popped = 0;
+    while (popped < producers * items_per_producer)
+    {
+        auto item = queue.try_pop();
+        if (item == nullptr)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        EXPECT_EQ(next[item->producer], item->sequence);
+        next[item->producer] = item->sequence + 1;
+        ++popped;
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(nullptr, queue.try_pop());
+}
+
+TEST(MpscQueue, RemoveFirstIfTakesTheOldestMatchButNeverTheNewest)
+{
+    Queue queue;
+    std::vector<Item> items(4);
+    for (int index = 0; index < 4; ++index)
+    {
+        items[index].sequence = index;
+        queue.push(&items[index]);
+    }
+
+    auto odd = [](const Item& item) { return (item.sequence % 2) == 1; };
+    EXPECT_EQ(&items[1], queue.remove_first_if(odd));
+    // 3 is the newest node, a producer could be linking behind it
+    EXPECT_EQ(nullptr, queue.remove_first_if(odd));
+    EXPECT_EQ((std::vector<int>{ 0, 2, 3 }), drain(queue));
+}
+
+}
@@ -0,0 +1,259 @@
+// mpmc_ring and ring_distributor of simple_concurrent_queue.h, and start_consumers cleaning up after a failed start
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <simple_concurrent_queue.h>
+
+namespace
+{
+
+using namespace std::chrono_literals;
+
+// a consumer that holds its thread until released
+class Gate
+{
+public:
+    void pass()
+    {
+        m_entered = true;
+        while (!m_open)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+
+    void wait_until_entered() const
+    {
+        while (!m_entered)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+
+    void open() noexcept
+    {
+        m_open = true;
+    }
+
+private:
+    std::atomic<bool> m_entered{ false };
+    std::atomic<bool> m_open{ false };
+};
+
+TEST(MpmcRing, PushesUntilFullAndPopsInOrder)
+{
+    // rounded up to a power of two
+    mpmc_ring<std::unique_ptr<int>> ring(3);
+    EXPECT_TRUE(ring.empty());
+    EXPECT_FALSE(ring.try_pop([](std::unique_ptr<int>&) {}));
+
+    for (int value = 0; value < 4; ++value)
+    {
+        auto item = std::make_unique<int>(value);
+        ASSERT_TRUE(ring.try_push(item));
+        EXPECT_EQ(nullptr, item);
+    }
+    EXPECT_TRUE(ring.full());
+
+    // no room, the value stays with the caller
+    auto rejected = std::make_unique<int>(4);
+    EXPECT_FALSE(ring.try_push(rejected));
+    ASSERT_NE(nullptr, rejected);
+
+    std::vector<int> popped;
+    while (ring.try_pop([&popped](std::unique_ptr<int>& item) { popped.push_back(*item); }))
+    {
+    }
+    EXPECT_EQ((std::vector<int>{ 0, 1, 2, 3 }), popped);
+    EXPECT_TRUE(ring.empty());
+    EXPECT_FALSE(ring.full());
+
+    // the positions wrap around
+    EXPECT_TRUE(ring.try_push(rejected));
+    EXPECT_TRUE(ring.try_pop([](std::unique_ptr<int>& item) { EXPECT_EQ(4, *item); }));
+}
+
+TEST(MpmcRing, DestroysTheItemsLeftBehind)
+{
+    auto item = std::make_shared<int>(0);
+    {
+        mpmc_ring<std::shared_ptr<int>> ring(8);
+        for (int count = 0; count < 5; ++count)
+        {
+            auto copy = item;
+            ring.try_push(copy);
+        }
+        EXPECT_EQ(6, item.use_count());
+    }
+    EXPECT_EQ(1, item.use_count());
+}
+
+TEST(MpmcRing, EveryItemIsPoppedOnceWithManyProducersAndConsumers)
+{
+    constexpr int threads = 4;
+    constexpr int items_per_producer = 50000;
+    mpmc_ring<int> ring(64);
+    std::vector<std::atomic<int>> seen(threads * items_per_producer);
+    std::atomic<int> popped{ 0 };
+
+    std::vector<std::thread> workers;
+    for (int producer = 0; producer < threads; ++producer)
+    {
+        workers.emplace_back([&ring, producer]
+        {
+            for (int item = producer * items_per_producer; item < (producer + 1) * items_per_producer; ++item)
+            {
+                auto value = item;
+                while (!ring.try_push(value))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int consumer = 0; consumer < threads; ++consumer)
+    {
+        workers.emplace_back([&ring, &seen, &popped]
+        {
+            while (popped < threads * items_per_producer)
+            {
+                if (ring.try_pop([&seen, &popped](int& item) { ++seen[item]; ++popped; }))
+                {
+                    continue;
+                }
+                std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    for (auto& count : seen)
+    {
+        ASSERT_EQ(1, count);
+    }
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(RingDistributor, RejectsZeroArguments)
+{
+    auto ignore = [](int&) {};
+    EXPECT_THROW(ring_distributor<int>(ignore, 0), std::invalid_argument);
+    EXPECT_THROW(ring_distributor<int>(ignore, 1, 0), std::invalid_argument);
+}
+
+TEST(RingDistributor, ProcessesEveryItem)
+{
+    std::atomic<long long> sum{ 0 };
+    {
+        ring_distributor<std::unique_ptr<int>> distributor([&sum](std::unique_ptr<int>& item) { sum += *item; }, 4, 4);
+        for (int value = 1; value <= 10000; ++value)
+        {
+            distributor(std::make_unique<int>(value));
+        }
+    }
+    EXPECT_EQ(10000LL * 10001 / 2, sum);
+}
+
+TEST(RingDistributor, DrainsTheRingBeforeItStops)
+{
+    Gate gate;
+    std::atomic<int> processed{ 0 };
+    {
+        ring_distributor<int> distributor([&gate, &processed](int&)
+        {
+            gate.pass();
+            ++processed;
+        }, 1, 8);
+        for (int value = 0; value < 8; ++value)
+        {
+            distributor(int{ value });
+        }
+        gate.wait_until_entered();
+        gate.open();
+    }
+    EXPECT_EQ(8, processed);
+}
+
+TEST(RingDistributor, ProducerWaitsWhileTheRingIsFull)
+{
+    Gate gate;
+    ring_distributor<int> distributor([&gate](int&) { gate.pass(); }, 1, 2);
+    distributor(0);
+    gate.wait_until_entered();
+    // the consumer holds item 0, the ring holds two more
+    distributor(1);
+    distributor(2);
+
+    std::atomic<bool> pushed{ false };
+    std::thread producer([&distributor, &pushed]
+    {
+        distributor(3);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(20ms);
+    EXPECT_FALSE(pushed);
+
+    gate.open();
+    producer.join();
+    EXPECT_TRUE(pushed);
+}
+
+// copying it into the next consumer thread throws once the given number of copies is reached
+struct ThrowingConsume
+{
+    ThrowingConsume(std::atomic<int>& copies, int throw_at, std::atomic<bool>& stopped, std::atomic<int>& returned) :
+        copies{ copies }, throw_at{ throw_at }, stopped{ stopped }, returned{ returned }
+    {
+    }
+
+    ThrowingConsume(const ThrowingConsume& other) :
+        copies{ other.copies }, throw_at{ other.throw_at }, stopped{ other.stopped }, returned{ other.returned }
+    {
+        if (++copies == throw_at)
+        {
+            throw std::runtime_error("no thread");
+        }
+    }
+
+    void operator()() const
+    {
+        while (!stopped)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+        ++returned;
+    }
+
+    std::atomic<int>& copies;
+    int throw_at;
+    std::atomic<bool>& stopped;
+    std::atomic<int>& returned;
+};
+
+TEST(StartConsumers, ThreadsStartedBeforeAFailedStartAreStoppedAndJoined)
+{
+    std::atomic<int> copies{ 0 };
+    std::atomic<bool> stopped{ false };
+    std::atomic<int> returned{ 0 };
+    std::vector<std::thread> threads;
+    ThrowingConsume consume(copies, 8, stopped, returned);
+
+    EXPECT_THROW(start_consumers(threads, 16, {}, consume, [&stopped] { stopped = true; }), std::runtime_error);
+    EXPECT_TRUE(stopped);
+    ASSERT_FALSE(threads.empty());
+    for (auto& thread : threads)
+    {
+        EXPECT_FALSE(thread.joinable());
+    }
+    EXPECT_EQ(static_cast<int>(threads.size()), returned);
+}
+
+}
@@ -0,0 +1,89 @@
+// cpp::concurrency::Signal, an auto reset event on a futex word
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/signal.h>
+
+namespace
+{
+
+using cpp::concurrency::Signal;
+using namespace std::chrono_literals;
+
+TEST(Signal, WaitTimesOutWithoutSignal)
+{
+    Signal signal;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(signal.try_wait_for(20ms));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+    EXPECT_FALSE(signal.try_wait_for(std::chrono::steady_clock::duration::zero()));
+}
+
+TEST(Signal, WaitConsumesTheSignal)
+{
+    Signal signal;
+    signal.signal();
+    // signals are not counted
+    signal.signal();
+    EXPECT_TRUE(signal.try_wait_for(std::chrono::steady_clock::duration::zero()));
+    EXPECT_FALSE(signal.try_wait_for(std::chrono::steady_clock::duration::zero()));
+}
+
+TEST(Signal, SignalWakesASleepingWaiter)
+{
+    Signal signal;
+    std::atomic<bool> waiting{ false };
+    std::atomic<bool> signalled{ false };
+    std::thread waiter([&]
+    {
+        waiting = true;
+        signalled = signal.try_wait_for(std::chrono::steady_clock::duration::max());
+    });
+    while (!waiting)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+    std::this_thread::sleep_for(10ms);
+
+    signal.signal();
+    waiter.join();
+    EXPECT_TRUE(signalled);
+}
+
+// signal() skips the wake up when it sees no waiter; a waiter that registers at the same time
+// must see the signal then, or it sleeps until its timeout
+TEST(Signal, NoSignalIsLostWhenTheWakeUpIsSkipped)
+{
+    Signal ping;
+    Signal pong;
+    constexpr int rounds = 20000;
+    std::atomic<int> lost{ 0 };
+    std::thread other([&]
+    {
+        for (int round = 0; round < rounds; ++round)
+        {
+            if (!ping.try_wait_for(5s))
+            {
+                ++lost;
+                return;
+            }
+            pong.signal();
+        }
+    });
+
+    for (int round = 0; (round < rounds) && (lost == 0); ++round)
+    {
+        ping.signal();
+        if (!pong.try_wait_for(5s))
+        {
+            ++lost;
+        }
+    }
+    ping.signal();
+    other.join();
+    EXPECT_EQ(0, lost);
+}
+
+}
@@ -0,0 +1,153 @@
+// cpp::concurrency::StateVariable: set, wait_for and wait_for_any with and without timeouts
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/state_variable.h>
+
+namespace
+{
+
+using cpp::concurrency::StateVariable;
+using namespace std::chrono_literals;
+
+enum class State
+{
+    idle,
+    running,
+    done,
+    failed
+};
+
+// sets the state from another thread, by then the test most likely sleeps in a wait
+class SetLater
+{
+public:
+    SetLater(StateVariable<State>& state, State value) :
+        m_thread([&state, value]
+        {
+            std::this_thread::sleep_for(10ms);
+            state = value;
+        })
+    {
+    }
+
+    ~SetLater()
+    {
+        m_thread.join();
+    }
+
+private:
+    std::thread m_thread;
+};
+
+TEST(StateVariable, SetAndGet)
+{
+    StateVariable<State> state;
+    EXPECT_EQ(State::idle, state.get());
+    state.set(State::running);
+    EXPECT_TRUE(state == State::running);
+    state = State::done;
+    EXPECT_EQ(State::done, static_cast<State>(state));
+    EXPECT_TRUE(state != State::running);
+}
+
+TEST(StateVariable, SetIfInOnlyChangesTheExpectedState)
+{
+    StateVariable<State> state(State::running);
+    state.set_if_in(State::idle, State::failed);
+    EXPECT_EQ(State::running, state.get());
+    state.set_if_in(State::running, State::done);
+    EXPECT_EQ(State::done, state.get());
+}
+
+TEST(StateVariable, WaitForTimesOut)
+{
+    StateVariable<State> state;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(state.try_wait_for(State::done, 20ms));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+    EXPECT_THROW(state.wait_for(State::done, 1ms), cpp::timeout_exception);
+    EXPECT_FALSE(state.try_wait_for_any({ State::done, State::failed }, 1ms));
+    EXPECT_THROW(state.wait_for_any({ State::done, State::failed }, 1ms), cpp::timeout_exception);
+}
+
+TEST(StateVariable, WaitForReturnsAtOnceWhenTheStateIsThere)
+{
+    StateVariable<State> state(State::done);
+    EXPECT_TRUE(state.try_wait_for(State::done, std::chrono::steady_clock::duration::zero()));
+    EXPECT_NO_THROW(state.wait_for(State::done));
+    EXPECT_TRUE(state.try_wait_for_any({ State::failed, State::done }, std::chrono::steady_clock::duration::zero()));
+}
+
+TEST(StateVariable, WaitForWakesOnSet)
+{
+    StateVariable<State> state;
+    SetLater later(state, State::done);
+    EXPECT_TRUE(state.try_wait_for(State::done, 10s));
+}
+
+TEST(StateVariable, WaitForAnyWakesOnAnyOfTheValues)
+{
+    StateVariable<State> state;
+    {
+        SetLater later(state, State::failed);
+        // without a timeout, the deadline must not overflow
+        EXPECT_TRUE(state.try_wait_for_any({ State::done, State::failed }));
+    }
+    EXPECT_EQ(State::failed, state.get());
+
+    {
+        SetLater later(state, State::done);
+        EXPECT_NO_THROW(state.wait_for_any({ State::done, State::running }));
+    }
+}
+
+TEST(StateVariable, WaiterSleepsThroughOtherValues)
+{
+    StateVariable<State> state;
+    std::thread setter([&state]
+    {
+        std::this_thread::sleep_for(5ms);
+        state = State::running;
+        std::this_thread::sleep_for(5ms);
+        state = State::done;
+    });
+    EXPECT_TRUE(state.try_wait_for(State::done, 10s));
+    setter.join();
+}
+
+// set() skips the wake up when it sees no waiter; a waiter that registers at the same time
+// must see the new value then, or it sleeps until its timeout
+TEST(StateVariable, NoChangeIsLostWhenTheWakeUpIsSkipped)
+{
+    StateVariable<int> turn(0);
+    constexpr int rounds = 20000;
+    std::atomic<bool> lost{ false };
+    std::thread other([&]
+    {
+        for (int round = 0; round < rounds; ++round)
+        {
+            if (!turn.try_wait_for(2 * round + 1, 5s))
+            {
+                lost = true;
+                return;
+            }
+            turn = 2 * round + 2;
+        }
+    });
+
+    for (int round = 0; (round < rounds) && !lost; ++round)
+    {
+        turn = 2 * round + 1;
+        if (!turn.try_wait_for(2 * round + 2, 5s))
+        {
+            lost = true;
+        }
+    }
+    other.join();
+    EXPECT_FALSE(lost);
+}
+
+}
@@ -0,0 +1,108 @@
+// TaskExecution::Dispatcher, ScopedScheduledCall and DispatcherClient
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <gtest/gtest.h>
+#include "inc/Dispatcher.h"
+#include "inc/DispatcherClient.h"
+
+namespace
+{
+
+using namespace std::chrono_literals;
+
+TEST(TaskExecutionDispatcher, CallReturnsTheValueOnTheDispatcherThread)
+{
+    TaskExecution::Dispatcher dispatcher;
+    EXPECT_TRUE(dispatcher.Call([&dispatcher] { return dispatcher.IsDispatcherThread(); }));
+    EXPECT_FALSE(dispatcher.IsDispatcherThread());
+    EXPECT_EQ(42, dispatcher.Call([] { return 42; }));
+}
+
+TEST(TaskExecutionDispatcher, CallRethrowsTheException)
+{
+    TaskExecution::Dispatcher dispatcher;
+    EXPECT_THROW(dispatcher.Call([]() -> int { throw std::runtime_error("call"); }), std::runtime_error);
+    EXPECT_EQ(1, dispatcher.Call([] { return 1; }));
+}
+
+TEST(TaskExecutionDispatcher, NotificationsRunInOrder)
+{
+    TaskExecution::Dispatcher dispatcher;
+    std::vector<int> order;
+    for (int index = 0; index < 100; ++index)
+    {
+        dispatcher.Notify([&order, index] { order.push_back(index); });
+    }
+    dispatcher.Synchronize();
+    ASSERT_EQ(100u, order.size());
+    for (int index = 0; index < 100; ++index)
+    {
+        EXPECT_EQ(index, order[index]);
+    }
+}
+
+TEST(TaskExecutionDispatcher, CancelledCallDoesNotRun)
+{
+    TaskExecution::Dispatcher dispatcher;
+    std::atomic<int> runs{ 0 };
+    auto call = dispatcher.CallAfter(20ms, [&runs] { ++runs; });
+    EXPECT_GT(dispatcher.TimeUntilNextExecution(call), 0ms);
+    dispatcher.Cancel(call);
+    EXPECT_LT(dispatcher.TimeUntilNextExecution(call), 0ms);
+    std::this_thread::sleep_for(50ms);
+    EXPECT_EQ(0, runs);
+}
+
+TEST(TaskExecutionDispatcher, CancelFromAnEarlierCallbackInTheSameTick)
+{
+    TaskExecution::Dispatcher dispatcher;
+    std::atomic<int> runs{ 0 };
+    std::optional<TaskExecution::ScheduledCall> second;
+    dispatcher.Call([&dispatcher, &second, &runs]
+    {
+        dispatcher.CallAfter(5ms, [&dispatcher, &second, &runs] { ++runs; dispatcher.Cancel(*second); });
+        second = dispatcher.CallAfter(6ms, [&runs] { runs += 10; });
+        // both calls are due by the time the dispatcher looks at its timers again
+        dispatcher.Notify([] { std::this_thread::sleep_for(30ms); });
+    });
+    std::this_thread::sleep_for(60ms);
+    dispatcher.Synchronize();
+    EXPECT_EQ(1, runs);
+}
+
+TEST(TaskExecutionDispatcher, ScopedScheduledCallCancelsWhenDestroyed)
+{
+    TaskExecution::Dispatcher dispatcher;
+    std::atomic<int> runs{ 0 };
+    {
+        TaskExecution::ScopedScheduledCall call = dispatcher.CallEvery(1ms, [&runs] { ++runs; });
+        std::this_thread::sleep_for(20ms);
+    }
+    auto runs_when_destroyed = runs.load();
+    EXPECT_GT(runs_when_destroyed, 0);
+    std::this_thread::sleep_for(20ms);
+    EXPECT_EQ(runs_when_destroyed, runs);
+}
+
+TEST(TaskExecutionDispatcher, ClientDropsQueuedNotificationsWhenCancelled)
+{
+    TaskExecution::Dispatcher dispatcher;
+    TaskExecution::DispatcherClient client(dispatcher);
+    std::atomic<bool> release{ false };
+    std::atomic<int> runs{ 0 };
+
+    // keeps the dispatcher busy so the notifications below stay queued
+    dispatcher.Notify([&release] { while (!release) std::this_thread::yield(); });
+    client.Notify([&runs] { ++runs; });
+    client.CancelNotifications();
+    client.Notify([&runs] { runs += 10; });
+    release = true;
+    client.Synchronize();
+    EXPECT_EQ(10, runs);
+}
+
+}
@@ -0,0 +1,125 @@
+// details::TaskNodePool and TaskNode, the allocation-free submission path of the dispatcher
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/dispatcher.h>
+#include <cpplib/concurrency/details/task_node.h>
+
+namespace
+{
+
+using cpp::concurrency::details::TaskNode;
+using cpp::concurrency::details::TaskNodePool;
+
+TEST(TaskNodePool, ReleasedNodesAreReused)
+{
+    auto& pool = TaskNodePool::instance();
+    std::vector<TaskNode*> nodes(100);
+    for (auto& node : nodes)
+    {
+        node = pool.allocate();
+    }
+    for (auto node : nodes)
+    {
+        pool.release(node);
+    }
+
+    auto allocations = pool.heap_allocations();
+    for (auto& node : nodes)
+    {
+        node = pool.allocate();
+    }
+    EXPECT_EQ(allocations, pool.heap_allocations());
+    for (auto node : nodes)
+    {
+        pool.release(node);
+    }
+}
+
+TEST(TaskNodePool, NodesBeyondTheCapAreFreed)
+{
+    auto& pool = TaskNodePool::instance();
+    constexpr std::size_t beyond_cap = 10;
+    std::vector<TaskNode*> nodes(TaskNodePool::max_pooled_nodes + beyond_cap);
+
+    for (auto& node : nodes)
+    {
+        node = pool.allocate();
+    }
+    for (auto node : nodes)
+    {
+        pool.release(node);
+    }
+
+    // the pool kept max_pooled_nodes of them, the others come from the heap again
+    auto allocations = pool.heap_allocations();
+    for (auto& node : nodes)
+    {
+        node = pool.allocate();
+    }
+    EXPECT_EQ(allocations + beyond_cap, pool.heap_allocations());
+    for (auto node : nodes)
+    {
+        pool.release(node);
+    }
+}
+
+TEST(TaskNode, OnlyCallablesThatDoNotFitInlineAreAllocated)
+{
+    auto& pool = TaskNodePool::instance();
+    auto node = pool.allocate();
+    int runs = 0;
+
+    auto allocations = pool.heap_allocations();
+    node->emplace([&runs] { ++runs; });
+    node->run();
+    EXPECT_EQ(allocations, pool.heap_allocations());
+
+    std::array<char, TaskNode::inline_size + 1> large{};
+    node->emplace([&runs, large] { runs += 1 + large[0]; });
+    EXPECT_EQ(allocations + 1, pool.heap_allocations());
+    node->run();
+    EXPECT_EQ(2, runs);
+
+    // cleared without running, the callable is destroyed
+    node->emplace([&runs] { ++runs; });
+    EXPECT_TRUE(node->has_callable());
+    pool.release(node);
+    EXPECT_EQ(2, runs);
+}
+
+TEST(TaskNodePool, NotifyDoesNotAllocateNodesOnceThePoolIsWarm)
+{
+    cpp::concurrency::Dispatcher dispatcher;
+    std::atomic<int> runs{ 0 };
+    // the dispatcher is held until the whole round is queued, so both rounds have the same backlog
+    auto notify_all = [&dispatcher, &runs]
+    {
+        std::atomic<bool> released{ false };
+        dispatcher.notify([&released]() noexcept
+        {
+            while (!released)
+            {
+                std::this_thread::yield();
+            }
+        });
+        for (int notification = 0; notification < 1000; ++notification)
+        {
+            dispatcher.notify([&runs]() noexcept { ++runs; });
+        }
+        released = true;
+        dispatcher.synchronize();
+    };
+
+    // the first round may grow the pool up to the size of the backlog, no more
+    notify_all();
+    auto allocations = TaskNodePool::instance().heap_allocations();
+    notify_all();
+    EXPECT_EQ(allocations, TaskNodePool::instance().heap_allocations());
+    EXPECT_EQ(2000, runs);
+}
+
+}
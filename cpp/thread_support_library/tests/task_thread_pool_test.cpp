@@ -0,0 +1,104 @@
+// details::TaskThreadPool, the threads behind cpp::concurrency::Task
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/details/task_thread_pool.h>
+
+namespace
+{
+
+using cpp::concurrency::details::TaskThreadPool;
+using namespace std::chrono_literals;
+
+// released once all the jobs expected have arrived
+class Latch
+{
+public:
+    explicit Latch(int count) : m_count(count) {}
+
+    void arrive_and_wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (--m_count == 0)
+        {
+            m_zero.notify_all();
+        }
+        m_zero.wait(lock, [this] { return m_count <= 0; });
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_zero;
+    int m_count;
+};
+
+TEST(TaskThreadPool, EveryRunningJobHasAThreadOfItsOwn)
+{
+    TaskThreadPool pool(16);
+    Latch latch(4);
+    std::atomic<int> finished{ 0 };
+    for (int job = 0; job < 4; ++job)
+    {
+        pool.submit([&latch, &finished] { latch.arrive_and_wait(); ++finished; });
+    }
+    while (finished < 4)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_EQ(4u, pool.number_of_threads());
+}
+
+TEST(TaskThreadPool, IdleThreadsAreReused)
+{
+    TaskThreadPool pool(16);
+    for (int job = 0; job < 10; ++job)
+    {
+        std::atomic<bool> done{ false };
+        pool.submit([&done] { done = true; });
+        while (!done)
+        {
+            std::this_thread::sleep_for(1ms);
+        }
+        // the worker is idle again once it has taken the lock after the job
+        std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_LE(pool.number_of_threads(), 2u);
+}
+
+TEST(TaskThreadPool, JobsBeyondMaxThreadsWaitForAThread)
+{
+    TaskThreadPool pool(1);
+    std::atomic<bool> release{ false };
+    std::atomic<int> finished{ 0 };
+    pool.submit([&release, &finished] { while (!release) std::this_thread::sleep_for(1ms); ++finished; });
+    pool.submit([&finished] { ++finished; });
+    std::this_thread::sleep_for(20ms);
+    EXPECT_EQ(0, finished);
+    EXPECT_EQ(1u, pool.number_of_threads());
+
+    release = true;
+    while (finished < 2)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_EQ(1u, pool.number_of_threads());
+}
+
+TEST(TaskThreadPool, DestructorWaitsForTheRunningJobs)
+{
+    std::atomic<int> finished{ 0 };
+    {
+        TaskThreadPool pool(4);
+        for (int job = 0; job < 3; ++job)
+        {
+            pool.submit([&finished] { std::this_thread::sleep_for(10ms); ++finished; });
+        }
+    }
+    EXPECT_EQ(3, finished);
+}
+
+}
@@ -0,0 +1,134 @@
+// details::TimingWheel, driven with explicit time points instead of the clock
+
+#include <chrono>
+#include <vector>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/details/timing_wheel.h>
+
+namespace
+{
+
+using Wheel = cpp::concurrency::details::TimingWheel<int>;
+using namespace std::chrono_literals;
+
+const Wheel::clock::time_point start{};
+
+// advances the wheel to `at` and returns what fired
+std::vector<int> advance_to(Wheel& wheel, std::chrono::milliseconds at)
+{
+    std::vector<int> fired;
+    wheel.advance(start + at, [&fired](int&& value) { fired.push_back(value); });
+    return fired;
+}
+
+TEST(TimingWheel, FiresInOrderOfExpiry)
+{
+    Wheel wheel(1ms, start);
+    for (auto at : { 30, 5, 70, 1, 4000, 300000 })
+    {
+        wheel.insert(start + std::chrono::milliseconds(at), at);
+    }
+    EXPECT_EQ(6u, wheel.size());
+
+    EXPECT_EQ((std::vector<int>{ 1, 5, 30, 70, 4000, 300000 }), advance_to(wheel, 1000s));
+    EXPECT_TRUE(wheel.empty());
+    EXPECT_EQ(Wheel::clock::time_point::max(), wheel.next_expiry());
+}
+
+TEST(TimingWheel, NeverFiresEarly)
+{
+    Wheel wheel(1ms, start);
+    wheel.insert(start + 10ms, 10);
+    wheel.insert(start + 100ms, 100);
+    wheel.insert(start + 5000ms, 5000);
+
+    EXPECT_TRUE(advance_to(wheel, 9ms).empty());
+    EXPECT_EQ((std::vector<int>{ 10 }), advance_to(wheel, 10ms));
+    EXPECT_TRUE(advance_to(wheel, 99ms).empty());
+    EXPECT_EQ((std::vector<int>{ 100 }), advance_to(wheel, 100ms));
+    EXPECT_TRUE(advance_to(wheel, 4999ms).empty());
+    EXPECT_EQ((std::vector<int>{ 5000 }), advance_to(wheel, 5000ms));
+}
+
+TEST(TimingWheel, NextExpiryIsNotAfterTheEarliestEntry)
+{
+    Wheel wheel(1ms, start);
+    wheel.insert(start + 200ms, 200);
+    wheel.insert(start + 20ms, 20);
+
+    // a cascade may come first, advancing to it fires nothing early
+    while (wheel.next_expiry() < start + 20ms)
+    {
+        EXPECT_TRUE(advance_to(wheel, std::chrono::duration_cast<std::chrono::milliseconds>(wheel.next_expiry() - start)).empty());
+    }
+    EXPECT_EQ(start + 20ms, wheel.next_expiry());
+}
+
+TEST(TimingWheel, EntriesBeyondTheRangeFireOnTime)
+{
+    Wheel wheel(1ms, start);
+    // the four levels cover 2^24 ticks, about 4.7 hours
+    auto far = std::chrono::milliseconds(std::chrono::hours(10));
+    wheel.insert(start + far, 1);
+
+    EXPECT_TRUE(advance_to(wheel, far - 1ms).empty());
+    EXPECT_EQ((std::vector<int>{ 1 }), advance_to(wheel, far));
+}
+
+TEST(TimingWheel, DeadlineAtTheEndOfTimeDoesNotOverflow)
+{
+    Wheel wheel(1ms, start);
+    auto never = wheel.insert(Wheel::clock::time_point::max(), 1);
+    wheel.insert(start + 10ms, 10);
+    EXPECT_EQ(Wheel::clock::time_point::max(), wheel.expiry(never));
+
+    EXPECT_EQ((std::vector<int>{ 10 }), advance_to(wheel, 10h));
+    EXPECT_EQ(1u, wheel.size());
+    EXPECT_GT(wheel.next_expiry(), start + 10h);
+
+    // started at some time and with a resolution that does not divide the distance to the end
+    Wheel later(3ms, Wheel::clock::now());
+    auto also_never = later.insert(Wheel::clock::time_point::max(), 2);
+    EXPECT_EQ(Wheel::clock::time_point::max(), later.expiry(also_never));
+}
+
+TEST(TimingWheel, CancelledEntriesDoNotFire)
+{
+    Wheel wheel(1ms, start);
+    wheel.insert(start + 10ms, 10);
+    auto cancelled = wheel.insert(start + 20ms, 20);
+    auto cascading = wheel.insert(start + 3000ms, 3000);
+    wheel.insert(start + 30ms, 30);
+    EXPECT_EQ(20, wheel.get(cancelled));
+
+    wheel.cancel(cancelled);
+    EXPECT_EQ((std::vector<int>{ 10 }), advance_to(wheel, 25ms));
+    wheel.cancel(cascading);
+    EXPECT_EQ(1u, wheel.size());
+    EXPECT_EQ((std::vector<int>{ 30 }), advance_to(wheel, 10s));
+    EXPECT_TRUE(wheel.empty());
+}
+
+TEST(TimingWheel, FiredEntryMayInsertAndCancel)
+{
+    Wheel wheel(1ms, start);
+    wheel.insert(start + 10ms, 10);
+    auto cancelled = wheel.insert(start + 15ms, 15);
+
+    std::vector<int> fired;
+    wheel.advance(start + 50ms, [&](int&& value)
+    {
+        fired.push_back(value);
+        if (value == 10)
+        {
+            wheel.cancel(cancelled);
+            // already due, fires within the same advance
+            wheel.insert(start + 12ms, 12);
+            wheel.insert(start + 100ms, 100);
+        }
+    });
+    EXPECT_EQ((std::vector<int>{ 10, 12 }), fired);
+    EXPECT_EQ((std::vector<int>{ 100 }), advance_to(wheel, 100ms));
+}
+
+}
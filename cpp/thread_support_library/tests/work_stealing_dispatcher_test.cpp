@@ -0,0 +1,147 @@
+// details::WorkStealingDispatcherImpl, the pool behind PoolDispatcher: stealing, strands and synchronize.
+// The implementation is used directly, PoolDispatcher does not let a worker post.
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <cpplib/concurrency/dispatcher.h>
+
+namespace
+{
+
+using Pool = cpp::concurrency::details::WorkStealingDispatcherImpl<cpp::concurrency::details::NullDispatcherContext>;
+using namespace std::chrono_literals;
+
+std::unique_ptr<Pool> make_pool(std::size_t number_of_threads)
+{
+    return std::make_unique<Pool>(std::chrono::steady_clock::duration::max(), cpp::performance::NullDispatcherPerformance::shared(), number_of_threads);
+}
+
+// waits for the condition, gives up after a while so a broken dispatcher fails the test instead of hanging it
+template<typename Condition>
+bool eventually(Condition condition)
+{
+    auto give_up = std::chrono::steady_clock::now() + 5s;
+    while (!condition())
+    {
+        if (std::chrono::steady_clock::now() > give_up)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+TEST(WorkStealingDispatcher, TasksOfABusyWorkerAreStolen)
+{
+    auto pool = make_pool(4);
+    std::atomic<int> ran{ 0 };
+
+    // tasks posted from a worker go to its own deque, it only gets through while the others steal them
+    auto all_ran = pool->call([&pool, &ran]
+    {
+        for (int task = 0; task < 8; ++task)
+        {
+            pool->notify([&ran]() noexcept { ++ran; });
+        }
+        return eventually([&ran] { return ran == 8; });
+    });
+    EXPECT_TRUE(all_ran);
+}
+
+TEST(WorkStealingDispatcher, StrandRunsItsTasksInOrderOneAtATime)
+{
+    auto pool = make_pool(4);
+    constexpr int tasks_per_strand = 1000;
+    struct Strand
+    {
+        std::vector<int> order;
+        std::atomic<int> running{ 0 };
+        std::atomic<bool> overlapped{ false };
+    };
+    Strand strands[2];
+
+    std::vector<std::thread> producers;
+    for (cpp::concurrency::strand_key key = 0; key < 2; ++key)
+    {
+        producers.emplace_back([&pool, &strands, key]
+        {
+            auto& strand = strands[key];
+            for (int task = 0; task < tasks_per_strand; ++task)
+            {
+                pool->notify_in_strand(key, [&strand, task]() noexcept
+                {
+                    if (++strand.running != 1)
+                    {
+                        strand.overlapped = true;
+                    }
+                    strand.order.push_back(task);
+                    --strand.running;
+                });
+            }
+        });
+    }
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+    pool->synchronize();
+
+    for (auto& strand : strands)
+    {
+        EXPECT_FALSE(strand.overlapped);
+        ASSERT_EQ(static_cast<std::size_t>(tasks_per_strand), strand.order.size());
+        for (int task = 0; task < tasks_per_strand; ++task)
+        {
+            EXPECT_EQ(task, strand.order[task]);
+        }
+    }
+}
+
+TEST(WorkStealingDispatcher, SynchronizeWaitsForTheTasksPostedBefore)
+{
+    auto pool = make_pool(4);
+    std::atomic<int> ran{ 0 };
+    for (int task = 0; task < 100; ++task)
+    {
+        pool->notify([&ran]() noexcept { std::this_thread::sleep_for(100us); ++ran; });
+    }
+    pool->synchronize();
+    EXPECT_EQ(100, ran);
+}
+
+TEST(WorkStealingDispatcher, SynchronizeReturnsWhileOthersKeepPosting)
+{
+    auto pool = make_pool(2);
+    std::atomic<bool> stop{ false };
+    std::atomic<bool> ran{ false };
+
+    // always one task queued or running, the pool is never idle
+    struct Repost
+    {
+        void operator()() const noexcept
+        {
+            if (!stop)
+            {
+                pool.notify(*this);
+            }
+        }
+
+        Pool& pool;
+        std::atomic<bool>& stop;
+    };
+    pool->notify(Repost{ *pool, stop });
+    pool->notify([&ran]() noexcept { ran = true; });
+
+    auto synchronized = std::async(std::launch::async, [&pool] { pool->synchronize(); });
+    EXPECT_EQ(std::future_status::ready, synchronized.wait_for(5s));
+    EXPECT_TRUE(ran);
+    stop = true;
+}
+
+}
@@ -0,0 +1,148 @@
+// Samples the dispatcher counters a process publishes in shared memory (posix CpplibPerformance).
+//
+//   performance_counter_reader <counter file> [interval ms = 1000] [samples = 0, forever]
+//
+// e.g. performance_counter_reader /dev/shm/cpplib_perf.4711 100
+//
+// The file is mapped read-only and only read with relaxed atomic loads, the sampled process is
+// never blocked, sampling every few milliseconds is fine. Rates are computed between two samples,
+// a slot that was released and claimed again in between (generation changed) starts over.
+//
+// Build with the async_dispatcher_tryout directory on the include path, e.g.
+//   g++ -std=c++17 -O2 -I../async_dispatcher_tryout performance_counter_reader.cpp -o performance_counter_reader
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cpplib/performance/shared_memory_counters.h>
+
+namespace
+{
+
+using namespace cpp::performance::shared_memory;
+
+struct Sample
+{
+    std::uint32_t generation = 0;
+    std::uint64_t calls_queued = 0;
+    std::uint64_t tasks_run = 0;
+    std::uint64_t queue_latency_ns_total = 0;
+    std::uint64_t execution_time_ns_total = 0;
+};
+
+Sample take_sample(const CounterSlot& slot) noexcept
+{
+    Sample sample;
+    sample.generation = slot.generation.load(std::memory_order_acquire);
+    sample.calls_queued = slot.calls_queued.load(std::memory_order_relaxed);
+    sample.tasks_run = slot.tasks_run.load(std::memory_order_relaxed);
+    sample.queue_latency_ns_total = slot.queue_latency_ns_total.load(std::memory_order_relaxed);
+    sample.execution_time_ns_total = slot.execution_time_ns_total.load(std::memory_order_relaxed);
+    return sample;
+}
+
+// tasks that met a full queue, over all policies
+std::uint64_t queue_full_count(const CounterSlot& slot) noexcept
+{
+    std::uint64_t count = 0;
+    for (auto& policy_count : slot.queue_full)
+    {
+        count += policy_count.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+double mean_us(std::uint64_t total_ns, std::uint64_t count) noexcept
+{
+    return (count == 0) ? 0.0 : static_cast<double>(total_ns) / static_cast<double>(count) / 1000.0;
+}
+
+void print_header()
+{
+    std::cout << std::left << std::setw(24) << "instance" << std::right
+        << std::setw(12) << "calls/s"
+        << std::setw(10) << "queued"
+        << std::setw(12) << "tasks/s"
+        << std::setw(14) << "queue us"
+        << std::setw(14) << "exec us"
+        << std::setw(10) << "max ms"
+        << std::setw(12) << "violations"
+        << std::setw(10) << "capacity"
+        << std::setw(12) << "queue full" << '\n';
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: performance_counter_reader <counter file> [interval ms] [samples]\n";
+        return 1;
+    }
+
+    try
+    {
+        auto file = CounterFile::open_read_only(argv[1]);
+        auto interval = std::chrono::milliseconds((argc > 2) ? std::atoi(argv[2]) : 1000);
+        auto samples = (argc > 3) ? std::atoi(argv[3]) : 0;
+
+        std::vector<Sample> previous(file.slot_count());
+        for (std::uint32_t index = 0; index < file.slot_count(); ++index)
+        {
+            previous[index] = take_sample(file.slot(index));
+        }
+        auto previous_time = std::chrono::steady_clock::now();
+
+        std::cout << std::fixed << std::setprecision(1);
+        for (int sample = 0; (samples == 0) || (sample < samples); ++sample)
+        {
+            std::this_thread::sleep_for(interval);
+            auto now = std::chrono::steady_clock::now();
+            auto seconds = std::chrono::duration<double>(now - previous_time).count();
+            previous_time = now;
+
+            print_header();
+            for (std::uint32_t index = 0; index < file.slot_count(); ++index)
+            {
+                auto& slot = file.slot(index);
+                if (slot.state.load(std::memory_order_acquire) != static_cast<std::uint32_t>(SlotState::live))
+                {
+                    continue;
+                }
+
+                auto current = take_sample(slot);
+                auto name = std::string(slot.instance_name, ::strnlen(slot.instance_name, max_instance_name_size));
+                if (current.generation != previous[index].generation)
+                {
+                    previous[index] = Sample{};
+                }
+
+                auto tasks = current.tasks_run - previous[index].tasks_run;
+                std::cout << std::left << std::setw(24) << name << std::right
+                    << std::setw(12) << (current.calls_queued - previous[index].calls_queued) / seconds
+                    << std::setw(10) << slot.queue_size.load(std::memory_order_relaxed)
+                    << std::setw(12) << tasks / seconds
+                    << std::setw(14) << mean_us(current.queue_latency_ns_total - previous[index].queue_latency_ns_total, tasks)
+                    << std::setw(14) << mean_us(current.execution_time_ns_total - previous[index].execution_time_ns_total, tasks)
+                    << std::setw(10) << slot.max_latency_ms.load(std::memory_order_relaxed)
+                    << std::setw(12) << slot.deadline_violations.load(std::memory_order_relaxed)
+                    << std::setw(10) << slot.queue_capacity.load(std::memory_order_relaxed)
+                    << std::setw(12) << queue_full_count(slot) << '\n';
+                previous[index] = current;
+            }
+            std::cout << std::endl;
+        }
+    }
+    catch (const std::exception& error)
+    {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}